@@ -0,0 +1,314 @@
+#include "adder_generator.h"
+#include <cmath>
+#include <sstream>
+#include <utility>
+
+using namespace std;
+
+bool parseAdderStyle(const string &str, AdderStyle &style) {
+    if (str == "behavioral") {
+        style = AdderStyle::Behavioral;
+    } else if (str == "ripple") {
+        style = AdderStyle::Ripple;
+    } else if (str == "carry-select") {
+        style = AdderStyle::CarrySelect;
+    } else if (str == "ks") {
+        style = AdderStyle::KoggeStone;
+    } else if (str == "bk") {
+        style = AdderStyle::BrentKung;
+    } else if (str == "hc") {
+        style = AdderStyle::HanCarlson;
+    } else if (str == "sklansky") {
+        style = AdderStyle::Sklansky;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+string adderStyleName(AdderStyle style) {
+    switch (style) {
+        case AdderStyle::Ripple:
+            return "ripple";
+        case AdderStyle::CarrySelect:
+            return "carry-select";
+        case AdderStyle::KoggeStone:
+            return "ks";
+        case AdderStyle::BrentKung:
+            return "bk";
+        case AdderStyle::HanCarlson:
+            return "hc";
+        case AdderStyle::Sklansky:
+            return "sklansky";
+        default:
+            return "behavioral";
+    }
+}
+
+// Выбор архитектуры для разрядности n по первому подходящему правилу
+AdderStyle AdderSelection::select(int n) const {
+    for (const AdderRule &rule : rules) {
+        bool matches = rule.op.empty() ||
+                       (rule.op == ">=" && n >= rule.width) || (rule.op == ">" && n > rule.width) ||
+                       (rule.op == "<=" && n <= rule.width) || (rule.op == "<" && n < rule.width);
+        if (matches) {
+            return rule.style;
+        }
+    }
+    return AdderStyle::Behavioral;
+}
+
+string AdderSelection::key() const {
+    string key;
+    for (const AdderRule &rule : rules) {
+        key += (key.empty() ? "" : ",") + adderStyleName(rule.style);
+        if (!rule.op.empty()) {
+            key += ":" + rule.op + to_string(rule.width);
+        }
+    }
+    return key;
+}
+
+// Функция разбора списка правил вида стиль[:условие], перечисленных через запятую
+// Условие - один из операторов >=, >, <=, < и разрядность
+bool parseAdderSelection(const string &str, AdderSelection &selection) {
+    vector<AdderRule> rules;
+    stringstream items(str);
+    string item;
+    while (getline(items, item, ',')) {
+        AdderRule rule;
+        size_t colon = item.find(':');
+        if (!parseAdderStyle(item.substr(0, colon), rule.style)) {
+            return false;
+        }
+        if (colon != string::npos) {
+            string condition = item.substr(colon + 1);
+            size_t digits = condition.find_first_of("0123456789");
+            rule.op = condition.substr(0, digits);
+            if (digits == string::npos || (rule.op != ">=" && rule.op != ">" && rule.op != "<=" && rule.op != "<")) {
+                return false;
+            }
+            string width = condition.substr(digits);
+            if (width.find_first_not_of("0123456789") != string::npos || width.size() > 9) {
+                return false;
+            }
+            rule.width = stoi(width);
+        }
+        rules.push_back(rule);
+    }
+    if (rules.empty()) {
+        return false;
+    }
+    selection.rules = rules;
+    return true;
+}
+
+// Уровень префиксной сети: пары (i, j), для которых (G, P)[i] = (G, P)[i] o (G, P)[j]
+using PrefixLevel = vector<pair<int, int>>;
+
+// Функция построения префиксной сети заданной архитектуры для width позиций
+// После всех уровней позиция i содержит групповой перенос по позициям 0..i
+static vector<PrefixLevel> buildPrefixNetwork(int width, AdderStyle style) {
+    vector<PrefixLevel> levels;
+    auto add_level = [&levels](const PrefixLevel &level) {
+        if (!level.empty()) {
+            levels.push_back(level);
+        }
+    };
+
+    if (style == AdderStyle::KoggeStone) {
+        for (int d = 1; d < width; d *= 2) {
+            PrefixLevel level;
+            for (int i = d; i < width; ++i) {
+                level.push_back({i, i - d});
+            }
+            add_level(level);
+        }
+    } else if (style == AdderStyle::Sklansky) {
+        // В каждом блоке из 2d позиций старшая половина объединяется с последней позицией младшей
+        for (int d = 1; d < width; d *= 2) {
+            PrefixLevel level;
+            for (int i = 0; i < width; ++i) {
+                if (i & d) {
+                    level.push_back({i, (i & ~(2 * d - 1)) + d - 1});
+                }
+            }
+            add_level(level);
+        }
+    } else if (style == AdderStyle::BrentKung) {
+        // Прямой проход строит двоичное дерево, обратный дополняет промежуточные позиции
+        int top = 1;
+        for (int d = 1; d < width; d *= 2) {
+            PrefixLevel level;
+            for (int i = 2 * d - 1; i < width; i += 2 * d) {
+                level.push_back({i, i - d});
+            }
+            add_level(level);
+            top = d;
+        }
+        for (int d = top; d >= 1; d /= 2) {
+            PrefixLevel level;
+            for (int i = 3 * d - 1; i < width; i += 2 * d) {
+                level.push_back({i, i - d});
+            }
+            add_level(level);
+        }
+    } else if (style == AdderStyle::HanCarlson) {
+        // Сеть Когге-Стоуна по нечетным позициям и один дополнительный уровень для четных
+        PrefixLevel first;
+        for (int i = 1; i < width; i += 2) {
+            first.push_back({i, i - 1});
+        }
+        add_level(first);
+        for (int d = 2; d < width; d *= 2) {
+            PrefixLevel level;
+            for (int i = d + 1; i < width; i += 2) {
+                level.push_back({i, i - d});
+            }
+            add_level(level);
+        }
+        PrefixLevel last;
+        for (int i = 2; i < width; i += 2) {
+            last.push_back({i, i - 1});
+        }
+        add_level(last);
+    }
+    return levels;
+}
+
+// Функция для генерации тела сумматора sum = a + operand + cin выбранной архитектуры
+// Перенос cin добавляется позицией 0 с генерацией cin и распространением 0,
+// поэтому позиция i + 1 префиксной сети содержит перенос в разряд i
+static void generateAdderBody(int n, AdderStyle style, const string &operand, const string &cin, const string &result,
+                              ostream &out) {
+    out << "wire [" << n << ":0] g0 = {a & " << operand << ", " << cin << "};\n";
+    out << "wire [" << n << ":0] p0 = {a ^ " << operand << ", 1'b0};\n";
+
+    if (style == AdderStyle::Ripple) {
+        out << "wire [" << n << ":0] c;\n";
+        out << "assign c[0] = " << cin << ";\n";
+        for (int i = 0; i < n; ++i) {
+            out << "assign c[" << i + 1 << "] = g0[" << i + 1 << "] | (p0[" << i + 1 << "] & c[" << i << "]);\n";
+        }
+        out << "assign " << result << " = p0[" << n << ":1] ^ c[" << n - 1 << ":0];\n";
+        return;
+    }
+
+    if (style == AdderStyle::CarrySelect) {
+        // Каждый блок считает переносы для входного переноса 0 и 1, нужный вариант выбирается
+        // переносом из предыдущего блока
+        int block = max(1, static_cast<int>(ceil(sqrt(static_cast<double>(n)))));
+        out << "wire bc0 = " << cin << ";\n";
+        int index = 0;
+        for (int lo = 0; lo < n; lo += block, ++index) {
+            int hi = min(n, lo + block) - 1;
+            int len = hi - lo + 1;
+            for (int carry = 0; carry <= 1; ++carry) {
+                string chain = "c" + to_string(index) + "_" + to_string(carry);
+                out << "wire [" << len << ":0] " << chain << ";\n";
+                out << "assign " << chain << "[0] = 1'b" << carry << ";\n";
+                for (int k = 0; k < len; ++k) {
+                    out << "assign " << chain << "[" << k + 1 << "] = g0[" << lo + k + 1 << "] | (p0[" << lo + k + 1
+                        << "] & " << chain << "[" << k << "]);\n";
+                }
+            }
+            string c0 = "c" + to_string(index) + "_0";
+            string c1 = "c" + to_string(index) + "_1";
+            string bc = "bc" + to_string(index);
+            out << "wire bc" << index + 1 << " = " << bc << " ? " << c1 << "[" << len << "] : " << c0 << "[" << len << "];\n";
+            out << "assign " << result << "[" << hi << ":" << lo << "] = p0[" << hi + 1 << ":" << lo + 1 << "] ^ (" << bc
+                << " ? " << c1 << "[" << len - 1 << ":0] : " << c0 << "[" << len - 1 << ":0]);\n";
+        }
+        return;
+    }
+
+    vector<PrefixLevel> levels = buildPrefixNetwork(n + 1, style);
+    for (size_t l = 1; l <= levels.size(); ++l) {
+        string g = "g" + to_string(l), p = "p" + to_string(l);
+        string g_prev = "g" + to_string(l - 1), p_prev = "p" + to_string(l - 1);
+        out << "wire [" << n << ":0] " << g << ", " << p << ";\n";
+
+        vector<int> source(n + 1, -1);
+        for (const pair<int, int> &node : levels[l - 1]) {
+            source[node.first] = node.second;
+        }
+        for (int i = 0; i <= n;) {
+            if (source[i] >= 0) {
+                int j = source[i];
+                out << "assign " << g << "[" << i << "] = " << g_prev << "[" << i << "] | (" << p_prev << "[" << i
+                    << "] & " << g_prev << "[" << j << "]);\n";
+                out << "assign " << p << "[" << i << "] = " << p_prev << "[" << i << "] & " << p_prev << "[" << j << "];\n";
+                ++i;
+                continue;
+            }
+            // Непрерывный диапазон позиций без объединения передается на следующий уровень целиком
+            int lo = i;
+            while (i <= n && source[i] < 0) {
+                ++i;
+            }
+            string range = "[" + to_string(i - 1) + ":" + to_string(lo) + "]";
+            out << "assign " << g << range << " = " << g_prev << range << ";\n";
+            out << "assign " << p << range << " = " << p_prev << range << ";\n";
+        }
+    }
+    out << "assign " << result << " = p0[" << n << ":1] ^ g" << levels.size() << "[" << n - 1 << ":0];\n";
+}
+
+// Название архитектуры для комментария в модуле
+static string adderStyleDescription(AdderStyle style) {
+    switch (style) {
+        case AdderStyle::Ripple:
+            return "с последовательным переносом";
+        case AdderStyle::CarrySelect:
+            return "с выбором переноса";
+        case AdderStyle::KoggeStone:
+            return "Когге-Стоуна";
+        case AdderStyle::BrentKung:
+            return "Брента-Кунга";
+        case AdderStyle::HanCarlson:
+            return "Хана-Карлсона";
+        default:
+            return "Скланского";
+    }
+}
+
+// Функция для генерации структурного модуля сумматора
+void generateStructuralAdderModule(int n, AdderStyle style, ostream &out) {
+    out << "module adder_" << n << "(\n";
+    out << "    input [" << n - 1 << ":0] a,\n";
+    out << "    input [" << n - 1 << ":0] b,\n";
+    out << "    output [" << n - 1 << ":0] sum\n";
+    out << ");\n";
+    out << "// Сумматор " << adderStyleDescription(style) << "\n";
+    generateAdderBody(n, style, "b", "1'b0", "sum", out);
+    out << "endmodule\n";
+}
+
+// Функция для генерации структурного модуля вычитателя: a - b = a + ~b + 1
+void generateStructuralSubtractorModule(int n, AdderStyle style, ostream &out) {
+    out << "module subtractor_" << n << "(\n";
+    out << "    input [" << n - 1 << ":0] a,\n";
+    out << "    input [" << n - 1 << ":0] b,\n";
+    out << "    output [" << n - 1 << ":0] diff\n";
+    out << ");\n";
+    out << "// Вычитатель на сумматоре " << adderStyleDescription(style) << "\n";
+    out << "wire [" << n - 1 << ":0] b_inv = ~b;\n";
+    generateAdderBody(n, style, "b_inv", "1'b1", "diff", out);
+    out << "endmodule\n";
+}
+
+// Функция для генерации строки сжимающих ячеек 3:2: каждый разряд - полный сумматор без распространения
+// переноса, переносы сдвигаются на разряд влево, старший перенос отбрасывается
+void generateCarrySaveAdderModule(int n, ostream &out) {
+    out << "module csa_" << n << "(\n";
+    out << "    input [" << n - 1 << ":0] a,\n";
+    out << "    input [" << n - 1 << ":0] b,\n";
+    out << "    input [" << n - 1 << ":0] c,\n";
+    out << "    output [" << n - 1 << ":0] sum,\n";
+    out << "    output [" << n - 1 << ":0] carry\n";
+    out << ");\n";
+    out << "wire [" << n - 1 << ":0] majority = (a & b) | (a & c) | (b & c);\n";
+    out << "assign sum = a ^ b ^ c;\n";
+    out << "assign carry = majority << 1;\n";
+    out << "endmodule\n";
+}
@@ -0,0 +1,50 @@
+#ifndef ADDER_GENERATOR_H
+#define ADDER_GENERATOR_H
+
+#include <ostream>
+#include <string>
+#include <vector>
+using namespace std;
+
+// Архитектура сумматоров и вычитателей
+enum class AdderStyle {
+    Behavioral,   // assign sum = a + b, архитектуру выбирает синтезатор
+    Ripple,       // Сумматор с последовательным переносом
+    CarrySelect,  // Сумматор с выбором переноса по блокам длины ~sqrt(n)
+    KoggeStone,   // Префиксный сумматор Когге-Стоуна
+    BrentKung,    // Префиксный сумматор Брента-Кунга
+    HanCarlson,   // Префиксный сумматор Хана-Карлсона
+    Sklansky      // Префиксный сумматор Скланского
+};
+
+bool parseAdderStyle(const string &str, AdderStyle &style);
+string adderStyleName(AdderStyle style);
+
+// Правило выбора архитектуры: style применяется к разрядностям, удовлетворяющим
+// условию "op width"; пустой op означает любую разрядность
+struct AdderRule {
+    AdderStyle style;
+    string op;
+    int width = 0;
+};
+
+// Список правил выбора архитектуры, например "ks:>=64,ripple:<64"
+// Применяется первое подходящее правило; если подходящих нет, сумматор поведенческий
+struct AdderSelection {
+    vector<AdderRule> rules;
+
+    AdderStyle select(int n) const;
+    // Текстовая запись правил; пустая строка для поведенческих сумматоров
+    string key() const;
+};
+
+bool parseAdderSelection(const string &str, AdderSelection &selection);
+
+// Функции для генерации структурных сумматора и вычитателя разрядности n
+// Вычитатель реализован как a + ~b + 1
+void generateStructuralAdderModule(int n, AdderStyle style, ostream &out);
+void generateStructuralSubtractorModule(int n, AdderStyle style, ostream &out);
+// Функция для генерации строки сжимающих ячеек 3:2 разрядности n (a + b + c = sum + carry)
+void generateCarrySaveAdderModule(int n, ostream &out);
+
+#endif
@@ -0,0 +1,154 @@
+#include "cost_model.h"
+#include "verilog_generator.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+bool parseOptimizationGoal(const string &str, OptimizationGoal &goal) {
+    if (str == "area") {
+        goal = OptimizationGoal::Area;
+    } else if (str == "depth") {
+        goal = OptimizationGoal::Depth;
+    } else if (str == "balanced") {
+        goal = OptimizationGoal::AreaDepth;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+string optimizationGoalName(OptimizationGoal goal) {
+    switch (goal) {
+        case OptimizationGoal::Area:
+            return "area";
+        case OptimizationGoal::Depth:
+            return "depth";
+        default:
+            return "balanced";
+    }
+}
+
+CostModel::CostModel(OptimizationGoal goal, bool square, int toom_min_width, bool toom_auto, BaseMultiplier base)
+    : goal(goal), square(square), toom_min_width(toom_min_width), toom_auto(toom_auto), base(base) {
+}
+
+// Стоимость прямого умножителя n x n бит
+// n^2 конъюнкций (по 1/4 полного сумматора) и дерево сжатия из n^2 - 2n полных сумматоров
+// глубиной log_{3/2}(n), за которым следует сумматор на 2n бит
+// Плоская сумма - цепочка операторов +: синтезатор складывает строки частичных произведений одну за другой,
+// поэтому глубина - высота столбца минус один сумматор на 2n бит, а площадь близка к дереву
+// Квадратор складывает n(n + 1) / 2 битов, из них n(n - 1) / 2 конъюнкций, в столбцах высотой до (n + 1) / 2
+CircuitCost CostModel::directCost(int n, bool square, BaseMultiplier base) {
+    if (n <= 1) {
+        return {square ? 0.0 : 0.25, square ? 0.0 : 0.25};
+    }
+    double bits = square ? n * (n + 1) / 2.0 : static_cast<double>(n) * n;
+    double and_gates = square ? n * (n - 1) / 2.0 : bits;
+    double height = square ? (n + 1) / 2 : n;
+    double tree_area = max(0.0, bits - 2 * n);
+    double tree_depth = height > 1 ? ceil(log(height) / log(1.5)) : 0;
+    CircuitCost final_adder = adderCost(2 * n);
+    double sum_depth = base == BaseMultiplier::Flat ? max(1.0, height - 1) * final_adder.depth
+                                                    : tree_depth + final_adder.depth;
+    return {0.25 * and_gates + tree_area + final_adder.area, 0.25 + sum_depth};
+}
+
+// Стоимость сумматора или вычитателя разрядности n
+// Синтез реализует a + b параллельно-префиксной схемой: глубина log2(n), площадь около 1.5n
+CircuitCost CostModel::adderCost(int n) {
+    return {1.5 * n, ceil(log2(static_cast<double>(max(n, 2))))};
+}
+
+double CostModel::objective(const CircuitCost &cost) const {
+    switch (goal) {
+        case OptimizationGoal::Area:
+            return cost.area;
+        case OptimizationGoal::Depth:
+            return cost.depth;
+        default:
+            return cost.area * cost.depth;
+    }
+}
+
+// Стоимость одного уровня Карацубы для разрядности n с лучшими реализациями подмодулей
+CircuitCost CostModel::karatsubaCost(int n) {
+    KaratsubaSplit split = splitKaratsuba(n);
+    CircuitCost z2 = cost(split.m);
+    CircuitCost z0 = cost(split.n_minus_m);
+    CircuitCost p = split.p_recursive ? cost(split.s_width) : directCost(split.s_width, square, base);
+    CircuitCost sum = adderCost(split.s_width);
+    CircuitCost sub = adderCost(split.p_width);
+    CircuitCost add = adderCost(split.product_width);
+
+    // Два сумматора s1, s2 (у квадратора только s1), два вычитателя и два сумматора сборки результата
+    double area = z2.area + z0.area + p.area + (square ? 1 : 2) * sum.area + 2 * sub.area + 2 * add.area;
+    double depth = max({z2.depth, z0.depth, sum.depth + p.depth}) + 2 * sub.depth + 2 * add.depth;
+    return {area, depth};
+}
+
+// Стоимость одного уровня Toom-3 для разрядности n
+// Каждый операнд вычисляется в трех точках двумя сумматорами на точку; интерполяция - 13 сумматоров
+// и вычитателей разрядности w и цепочка сумматоров деления на 3; сборка - три сумматора на 2n бит
+CircuitCost CostModel::toomCost(int n) {
+    ToomSplit split = splitToom3(n);
+    CircuitCost r0 = cost(split.k);
+    CircuitCost r1 = cost(split.sum_width);
+    CircuitCost r2 = cost(split.point_width);
+    CircuitCost rinf = cost(split.high);
+    CircuitCost evaluation = adderCost(split.point_width);
+    CircuitCost step = adderCost(split.interpolation_width);
+    CircuitCost add = adderCost(split.product_width);
+    int division_steps = static_cast<int>(ceil(log2(split.interpolation_width / 2.0)));
+
+    double area = r0.area + r1.area + 2 * r2.area + rinf.area + (square ? 6 : 12) * evaluation.area +
+                  (13 + division_steps) * step.area + 3 * add.area;
+    double products_depth = max({r0.depth, rinf.depth, 2 * evaluation.depth + max(r1.depth, r2.depth)});
+    // Самая длинная цепочка интерполяции: a, 5a, c2, d, деление на 3 и c1
+    double depth = products_depth + (9 + division_steps) * step.depth + 2 * add.depth;
+    return {area, depth};
+}
+
+// true, если уровень разрядности n можно делить по Toom-3
+bool CostModel::toomAllowed(int n) const {
+    if (!splitToom3(n).valid) {
+        return false;
+    }
+    return toom_auto || (toom_min_width > 0 && n >= toom_min_width);
+}
+
+// true, если для разрядности n прямое умножение выгоднее рекурсии
+bool CostModel::preferDirect(int n) {
+    cost(n);
+    return choices[n].split == Split::Direct;
+}
+
+// true, если для разрядности n уровень Toom-3 выгоднее уровня Карацубы
+// Сравниваются только способы рекурсии, даже если прямое умножение выгоднее обоих
+bool CostModel::preferToom(int n) {
+    if (!toomAllowed(n)) {
+        return false;
+    }
+    if (!toom_auto) {
+        return true;
+    }
+    return objective(toomCost(n)) < objective(karatsubaCost(n));
+}
+
+// Стоимость лучшей реализации умножителя разрядности n
+CircuitCost CostModel::cost(int n) {
+    auto it = choices.find(n);
+    if (it != choices.end()) {
+        return it->second.cost;
+    }
+
+    Choice choice = {directCost(n, square, base), Split::Direct};
+    if (n > 2) {
+        CircuitCost recursive = preferToom(n) ? toomCost(n) : karatsubaCost(n);
+        if (n > MAX_DIRECT_WIDTH || objective(recursive) < objective(choice.cost)) {
+            choice = {recursive, preferToom(n) ? Split::Toom : Split::Karatsuba};
+        }
+    }
+    choices[n] = choice;
+    return choice.cost;
+}
@@ -0,0 +1,75 @@
+#ifndef COST_MODEL_H
+#define COST_MODEL_H
+
+#include "multiplier_tree.h"
+#include <map>
+#include <string>
+using namespace std;
+
+// Оценка стоимости схемы
+struct CircuitCost {
+    double area;   // Площадь в эквивалентах полного сумматора
+    double depth;  // Глубина в задержках полного сумматора
+};
+
+// Критерий выбора реализации
+enum class OptimizationGoal {
+    Area,       // Минимальная площадь
+    Depth,      // Минимальная глубина
+    AreaDepth   // Минимальное произведение площади на глубину
+};
+
+bool parseOptimizationGoal(const string &str, OptimizationGoal &goal);
+string optimizationGoalName(OptimizationGoal goal);
+
+// Наибольшая разрядность прямого умножения при выборе по модели: дальше n^2 частичных произведений
+// раздувают текст и трассировку, даже если по логической глубине дерево сжатия не хуже рекурсии
+const int MAX_DIRECT_WIDTH = 64;
+
+// Простая модель площади и глубины, по которой для каждой разрядности выбирается
+// прямое умножение или еще один уровень рекурсии Карацубы или Toom-3
+// Для квадратора (square) учитываются прямые квадраторы и одна сумма s1 на уровне
+// Toom-3 используется для разрядностей не меньше toom_min_width или, если toom_auto, там, где он выгоднее
+// Глубина прямых умножителей зависит от base: плоская сумма - цепочка сумматоров, деревья - log_{3/2}(n)
+class CostModel {
+public:
+    explicit CostModel(OptimizationGoal goal, bool square = false, int toom_min_width = 0, bool toom_auto = false,
+                       BaseMultiplier base = BaseMultiplier::Flat);
+
+    // true, если для разрядности n прямое умножение выгоднее рекурсии
+    bool preferDirect(int n);
+    // true, если для разрядности n уровень Toom-3 выгоднее уровня Карацубы
+    bool preferToom(int n);
+    // Стоимость лучшей реализации умножителя разрядности n
+    CircuitCost cost(int n);
+
+    // Стоимость прямого умножителя n x n бит или прямого квадратора
+    static CircuitCost directCost(int n, bool square = false, BaseMultiplier base = BaseMultiplier::Flat);
+    // Стоимость сумматора или вычитателя разрядности n
+    static CircuitCost adderCost(int n);
+
+private:
+    // Стоимость одного уровня Карацубы для разрядности n с лучшими реализациями подмодулей
+    CircuitCost karatsubaCost(int n);
+    // Стоимость одного уровня Toom-3 для разрядности n с лучшими реализациями подмодулей
+    CircuitCost toomCost(int n);
+    bool toomAllowed(int n) const;
+    double objective(const CircuitCost &cost) const;
+
+    // Реализация уровня
+    enum class Split { Direct, Karatsuba, Toom };
+
+    struct Choice {
+        CircuitCost cost;
+        Split split;
+    };
+
+    OptimizationGoal goal;
+    bool square;
+    int toom_min_width;
+    bool toom_auto;
+    BaseMultiplier base;
+    map<int, Choice> choices;  // Уже вычисленные решения по разрядностям
+};
+
+#endif
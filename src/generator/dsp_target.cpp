@@ -0,0 +1,121 @@
+#include "dsp_target.h"
+
+using namespace std;
+
+bool parseDspTarget(const string &str, DspTarget &target) {
+    if (str == "dsp48e1") {
+        target = DspTarget::Dsp48e1;
+    } else if (str == "dsp48e2") {
+        target = DspTarget::Dsp48e2;
+    } else if (str == "dsp27x27") {
+        target = DspTarget::Dsp27x27;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+string dspTargetName(DspTarget target) {
+    switch (target) {
+        case DspTarget::Dsp48e1:
+            return "dsp48e1";
+        case DspTarget::Dsp48e2:
+            return "dsp48e2";
+        case DspTarget::Dsp27x27:
+            return "dsp27x27";
+        default:
+            return "none";
+    }
+}
+
+// Порты знаковых блоков Xilinx теряют по одному биту на знак
+DspShape dspShape(DspTarget target) {
+    switch (target) {
+        case DspTarget::Dsp48e1:
+            return {24, 17, "use_dsp = \"yes\""};
+        case DspTarget::Dsp48e2:
+            return {26, 17, "use_dsp = \"yes\""};
+        default:
+            return {27, 27, "multstyle = \"dsp\""};
+    }
+}
+
+string dspModuleName(const DspShape &shape) {
+    return "dsp_mult_" + to_string(shape.a_width) + "x" + to_string(shape.b_width);
+}
+
+// Функция покрытия прямого умножения n x n бит блоками DSP
+// Если после отделения строк в LUT от x ничего не осталось (n <= DSP_LUT_ROWS), умножение целиком строится в LUT
+DspTiling tileDsp(int n, const DspShape &shape) {
+    DspTiling tiling;
+    int x_rest = n % shape.a_width;
+    tiling.x_rows = x_rest <= DSP_LUT_ROWS ? x_rest : 0;
+    tiling.x_parts = (n - tiling.x_rows + shape.a_width - 1) / shape.a_width;
+    int y_rest = n % shape.b_width;
+    tiling.y_rows = tiling.x_parts > 0 && y_rest <= DSP_LUT_ROWS ? y_rest : 0;
+    tiling.y_parts = tiling.x_parts > 0 ? (n - tiling.y_rows + shape.b_width - 1) / shape.b_width : 0;
+    tiling.blocks = tiling.x_parts * tiling.y_parts;
+    return tiling;
+}
+
+// Функция для генерации модуля одного блока DSP
+void generateDspModule(const DspShape &shape, ostream &out) {
+    int width = shape.a_width + shape.b_width;
+    out << "(* " << shape.attribute << " *)\n";
+    out << "module " << dspModuleName(shape) << "(\n";
+    out << "    input [" << shape.a_width - 1 << ":0] a,\n";
+    out << "    input [" << shape.b_width - 1 << ":0] b,\n";
+    out << "    output [" << width - 1 << ":0] product\n";
+    out << ");\n\n";
+    out << "assign product = a * b;\n\n";
+    out << "endmodule\n\n";
+}
+
+// Часть signal[lo + width - 1:lo], дополненная нулями до port_width бит
+static string portSlice(const string &signal, int lo, int width, int port_width) {
+    string slice = signal + "[" + to_string(lo + width - 1) + ":" + to_string(lo) + "]";
+    if (width == port_width) {
+        return slice;
+    }
+    return "{" + to_string(port_width - width) + "'b0, " + slice + "}";
+}
+
+// Функция для генерации прямого умножения n x n бит на блоках DSP
+// x * y = x_main * y_main + x_rows * y + x_main * y_rows, где x_main и y_main - покрытые блоками
+// младшие биты, а x_rows и y_rows - старшие биты, которые умножаются в LUT
+void generateDspMultiplicationLogic(int n, const string &a, const string &b, const string &product,
+                                    const DspShape &shape, ostream &out) {
+    DspTiling tiling = tileDsp(n, shape);
+    int x_main = n - tiling.x_rows;
+    int y_main = n - tiling.y_rows;
+    int width = shape.a_width + shape.b_width;
+    out << "// Прямое умножение для " << n << "-битных чисел: блоков " << dspModuleName(shape) << " - "
+        << tiling.blocks << ", строк в LUT - " << tiling.x_rows + tiling.y_rows << "\n";
+
+    string sum;
+    auto add_term = [&sum](const string &term) {
+        sum += (sum.empty() ? "" : " + ") + term;
+    };
+    for (int i = 0; i < tiling.x_parts; ++i) {
+        for (int j = 0; j < tiling.y_parts; ++j) {
+            int x_lo = i * shape.a_width, y_lo = j * shape.b_width;
+            string block = product + "_dsp_" + to_string(i) + "_" + to_string(j);
+            out << "wire [" << width - 1 << ":0] " << block << ";\n";
+            out << dspModuleName(shape) << " " << block << "_block (\n";
+            out << "    .a(" << portSlice(a, x_lo, min(shape.a_width, x_main - x_lo), shape.a_width) << "),\n";
+            out << "    .b(" << portSlice(b, y_lo, min(shape.b_width, y_main - y_lo), shape.b_width) << "),\n";
+            out << "    .product(" << block << ")\n";
+            out << ");\n";
+            add_term(x_lo + y_lo > 0 ? "(" + block + " << " + to_string(x_lo + y_lo) + ")" : block);
+        }
+    }
+    for (int k = x_main; k < n; ++k) {
+        add_term("(({" + to_string(n) + "{" + a + "[" + to_string(k) + "]}} & " + b + ") << " + to_string(k) + ")");
+    }
+    string a_main = x_main == n ? a : a + "[" + to_string(x_main - 1) + ":0]";
+    for (int k = y_main; k < n; ++k) {
+        add_term("(({" + to_string(x_main) + "{" + b + "[" + to_string(k) + "]}} & " + a_main + ") << " +
+                 to_string(k) + ")");
+    }
+    out << "assign " << product << " = " << sum << ";\n";
+}
@@ -0,0 +1,54 @@
+#ifndef DSP_TARGET_H
+#define DSP_TARGET_H
+
+#include <ostream>
+#include <string>
+using namespace std;
+
+// Блок DSP ПЛИС, на который отображаются прямые умножители
+enum class DspTarget {
+    None,      // Прямые умножители из LUT
+    Dsp48e1,   // Xilinx 7-й серии: знаковое умножение 25x18, беззнаковое 24x17
+    Dsp48e2,   // Xilinx UltraScale: знаковое умножение 27x18, беззнаковое 26x17
+    Dsp27x27   // Intel Stratix 10 и Agilex: беззнаковое умножение 27x27
+};
+
+bool parseDspTarget(const string &str, DspTarget &target);
+string dspTargetName(DspTarget target);
+
+// Беззнаковое умножение, которое выполняет один блок DSP
+struct DspShape {
+    int a_width;       // Разрядность порта A
+    int b_width;       // Разрядность порта B
+    string attribute;  // Атрибут синтеза, закрепляющий умножение за блоком DSP
+};
+
+DspShape dspShape(DspTarget target);
+// Имя модуля одного блока, например dsp_mult_26x17
+string dspModuleName(const DspShape &shape);
+
+// Старшие части операндов не длиннее DSP_LUT_ROWS бит умножаются в LUT, а не занимают отдельный блок:
+// суммы s1, s2 уровня Карацубы на бит шире половин, и этот бит не должен удваивать число блоков
+const int DSP_LUT_ROWS = 2;
+
+// Покрытие прямого умножения n x n бит блоками DSP
+// x делится на части по a_width бит для порта A, y - на части по b_width бит для порта B;
+// каждая пара частей - один блок, неполные части дополняются нулями до разрядности порта
+struct DspTiling {
+    int x_parts;   // Число частей x
+    int y_parts;   // Число частей y
+    int x_rows;    // Старшие биты x, которые умножаются в LUT на весь y
+    int y_rows;    // Старшие биты y, которые умножаются в LUT на покрытую блоками часть x
+    int blocks;    // Число блоков DSP
+};
+
+DspTiling tileDsp(int n, const DspShape &shape);
+
+// Функция для генерации модуля одного блока DSP: product = a * b с атрибутом блока
+void generateDspModule(const DspShape &shape, ostream &out);
+// Функция для генерации прямого умножения n x n бит экземплярами модуля блока и строками в LUT
+// Модуль блока должен быть выведен до модуля, использующего эту логику
+void generateDspMultiplicationLogic(int n, const string &a, const string &b, const string &product,
+                                    const DspShape &shape, ostream &out);
+
+#endif
@@ -0,0 +1,87 @@
+#include "modular_reduction.h"
+
+using namespace std;
+
+bool parseModularReduction(const string &str, ModularReduction &reduction) {
+    if (str == "montgomery") {
+        reduction = ModularReduction::Montgomery;
+    } else if (str == "barrett") {
+        reduction = ModularReduction::Barrett;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+string modularReductionName(ModularReduction reduction) {
+    switch (reduction) {
+        case ModularReduction::Montgomery:
+            return "montgomery";
+        case ModularReduction::Barrett:
+            return "barrett";
+        default:
+            return "none";
+    }
+}
+
+string modularName(ModularReduction reduction, int n) {
+    return modularReductionName(reduction) + "_mult_" + to_string(n);
+}
+
+// Монтгомери требует нечетного модуля, иначе -M^-1 mod 2^n не существует; Барретт с частным
+// из n + 1 бит ошибается не больше чем на 2, только если старший бит модуля равен 1
+bool checkModulus(ModularReduction reduction, int n, const BigUint &modulus, string &error) {
+    if (n < 2) {
+        error = "Модульное умножение требует разрядности не меньше 2.";
+        return false;
+    }
+    if (modulus.bitLength() > n) {
+        error = "Модуль 0x" + modulus.toHex() + " шире " + to_string(n) + " бит.";
+        return false;
+    }
+    if (reduction == ModularReduction::Montgomery && !modulus.bit(0)) {
+        error = "Модуль Монтгомери должен быть нечетным.";
+        return false;
+    }
+    BigUint half;
+    half.setBit(n - 1, true);
+    if (reduction == ModularReduction::Barrett && modulus <= half) {
+        error = "Модуль Барретта должен быть больше 2^" + to_string(n - 1) + ".";
+        return false;
+    }
+    return true;
+}
+
+// Обратный к M по модулю 2^n считается итерацией Ньютона inv = inv * (2 - M * inv),
+// удваивающей число верных младших битов; для нечетного M начальное inv = M верно в трех битах
+BigUint reductionConstant(ModularReduction reduction, int n, const BigUint &modulus) {
+    BigUint power;
+    power.setBit(n, true);
+    if (reduction == ModularReduction::Barrett) {
+        return (power * power) / modulus;
+    }
+    BigUint inverse = modulus.lowBits(n);
+    for (int bits = 3; bits < n; bits *= 2) {
+        BigUint correction = (BigUint(2) + power - (modulus * inverse).lowBits(n)).lowBits(n);
+        inverse = (inverse * correction).lowBits(n);
+    }
+    return (power - inverse).lowBits(n);
+}
+
+int reductionConstantWidth(ModularReduction reduction, int n) {
+    return reduction == ModularReduction::Barrett ? n + 1 : n;
+}
+
+string reductionConstantPort(ModularReduction reduction) {
+    return reduction == ModularReduction::Barrett ? "mu" : "modulus_inv";
+}
+
+// 2^-n mod M = (1 + M * M') / 2^n, где M' = -M^-1 mod 2^n
+BigUint modularProduct(ModularReduction reduction, int n, const BigUint &x, const BigUint &y, const BigUint &modulus) {
+    BigUint product = x * y;
+    if (reduction == ModularReduction::Montgomery) {
+        BigUint inverse_power = (BigUint(1) + modulus * reductionConstant(reduction, n, modulus)) >> n;
+        product = (product % modulus) * inverse_power;
+    }
+    return product % modulus;
+}
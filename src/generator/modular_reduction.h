@@ -0,0 +1,34 @@
+#ifndef MODULAR_REDUCTION_H
+#define MODULAR_REDUCTION_H
+
+#include <string>
+#include "../simulator/big_uint.h"
+using namespace std;
+
+// Редукция произведения по модулю
+enum class ModularReduction {
+    None,        // Полное произведение 2N бит
+    Montgomery,  // x * y * 2^-N mod M, модуль нечетный
+    Barrett      // x * y mod M, 2^(N-1) < M < 2^N
+};
+
+bool parseModularReduction(const string &str, ModularReduction &reduction);
+string modularReductionName(ModularReduction reduction);
+
+// Имя верхнего модуля: montgomery_mult_n или barrett_mult_n
+string modularName(ModularReduction reduction, int n);
+
+// Проверка модуля для разрядности n; false и описание в error, если редукция с ним невозможна
+bool checkModulus(ModularReduction reduction, int n, const BigUint &modulus, string &error);
+
+// Константа редукции: -M^-1 mod 2^n для Монтгомери (n бит) и floor(4^n / M) для Барретта (n + 1 бит)
+BigUint reductionConstant(ModularReduction reduction, int n, const BigUint &modulus);
+int reductionConstantWidth(ModularReduction reduction, int n);
+// Имя входа константы у модуля без постоянного модуля
+string reductionConstantPort(ModularReduction reduction);
+
+// Эталонный результат для x, y < M: x * y * 2^-n mod M для Монтгомери и x * y mod M для Барретта
+// Считается делением столбиком, независимо от схемы редукции
+BigUint modularProduct(ModularReduction reduction, int n, const BigUint &x, const BigUint &y, const BigUint &modulus);
+
+#endif
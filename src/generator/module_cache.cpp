@@ -0,0 +1,77 @@
+#include "module_cache.h"
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <iomanip>
+#include <unistd.h>
+
+using namespace std;
+
+// Хэш FNV-1a в шестнадцатеричном виде
+string hashString(const string &str) {
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : str) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    stringstream ss;
+    ss << hex << setw(16) << setfill('0') << hash;
+    return ss.str();
+}
+
+ModuleCache::ModuleCache(const string &dir, const string &options_key) {
+    directory = (filesystem::path(dir) / hashString(options_key)).string();
+    filesystem::create_directories(directory);
+
+    // Ключ сохраняется рядом с модулями, чтобы по папке кэша было видно, к каким параметрам она относится
+    string key_filename = (filesystem::path(directory) / "options.txt").string();
+    if (!filesystem::exists(key_filename)) {
+        ofstream key_file(key_filename);
+        key_file << options_key << "\n";
+    }
+}
+
+string ModuleCache::modulePath(const string &module_name) const {
+    return (filesystem::path(directory) / (module_name + ".v")).string();
+}
+
+// Запись закэшированного модуля в out; false, если модуля нет в кэше
+bool ModuleCache::load(const string &module_name, ostream &out) const {
+    ifstream file(modulePath(module_name), ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    out << file.rdbuf();
+    return true;
+}
+
+// Сохранение определения модуля в кэш
+// Файл сначала пишется под временным именем и затем переименовывается, поэтому
+// параллельные процессы и потоки никогда не увидят недописанный модуль
+void ModuleCache::store(const string &module_name, const string &definition) const {
+    string path = modulePath(module_name);
+    stringstream suffix;
+    suffix << ".tmp." << getpid() << "." << this_thread::get_id();
+    string temp_path = path + suffix.str();
+
+    {
+        ofstream file(temp_path, ios::binary);
+        if (!file.is_open()) {
+            return; // Кэш необязателен: при ошибке записи модуль просто не сохраняется
+        }
+        file << definition;
+        if (!file) {
+            file.close();
+            filesystem::remove(temp_path);
+            return;
+        }
+    }
+
+    error_code ec;
+    filesystem::rename(temp_path, path, ec);
+    if (ec) {
+        filesystem::remove(temp_path, ec);
+    }
+}
@@ -0,0 +1,29 @@
+#ifndef MODULE_CACHE_H
+#define MODULE_CACHE_H
+
+#include <ostream>
+#include <string>
+using namespace std;
+
+// Дисковый кэш определений модулей
+// Модули хранятся в папке <dir>/<хэш ключа параметров>/<имя модуля>.v, поэтому
+// результаты, полученные с разными параметрами генератора, не смешиваются
+class ModuleCache {
+public:
+    ModuleCache(const string &dir, const string &options_key);
+
+    // Запись закэшированного модуля в out; false, если модуля нет в кэше
+    bool load(const string &module_name, ostream &out) const;
+    // Сохранение определения модуля в кэш
+    void store(const string &module_name, const string &definition) const;
+
+private:
+    string modulePath(const string &module_name) const;
+
+    string directory;  // Папка кэша для текущего набора параметров
+};
+
+// Хэш FNV-1a в шестнадцатеричном виде
+string hashString(const string &str);
+
+#endif
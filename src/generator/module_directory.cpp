@@ -0,0 +1,213 @@
+#include "module_directory.h"
+#include "module_cache.h"
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <unistd.h>
+
+using namespace std;
+
+const string MANIFEST_FILENAME = "manifest.txt"; // Имя файла манифеста в папке модулей
+
+// Функция разбиения текста генератора на определения модулей в порядке следования
+// Строки до module (комментарии, `timescale) относятся к следующему модулю, пустые строки после endmodule - к предыдущему
+vector<ModuleText> splitModules(const string &verilog) {
+    vector<ModuleText> modules;
+    ModuleText current;
+    bool ended = false;
+    stringstream lines(verilog);
+    string line;
+    while (getline(lines, line)) {
+        bool blank = line.find_first_not_of(" \t\r") == string::npos;
+        if (ended && !blank) {
+            modules.push_back(current);
+            current = ModuleText();
+            ended = false;
+        }
+        if (current.name.empty() && line.rfind("module ", 0) == 0) {
+            size_t begin = line.find_first_not_of(' ', 7);
+            size_t end = line.find_first_of(" (#;", begin);
+            current.name = line.substr(begin, end == string::npos ? string::npos : end - begin);
+        } else if (!current.name.empty() && line.rfind("endmodule", 0) == 0) {
+            ended = true;
+        }
+        current.definition += line;
+        if (!lines.eof()) {
+            current.definition += "\n";
+        }
+    }
+    if (!current.definition.empty()) {
+        // Текст после последнего endmodule без нового модуля остается в последнем модуле
+        if (current.name.empty() && !modules.empty()) {
+            modules.back().definition += current.definition;
+        } else {
+            modules.push_back(current);
+        }
+    }
+    return modules;
+}
+
+// Чтение манифеста предыдущего запуска при любом ключе параметров: его файлы написаны генератором
+// Строка списка: list <имя>.f <хэш> <модуль>.v ...
+ModuleDirectory::ModuleDirectory(const string &dir, const string &options_key) : directory(dir), key(options_key) {
+    filesystem::create_directories(directory);
+
+    ifstream manifest(path(MANIFEST_FILENAME));
+    string line;
+    if (!getline(manifest, line) || line.rfind("options ", 0) != 0) {
+        return;
+    }
+    same_key = line == "options " + key;
+    while (getline(manifest, line)) {
+        stringstream fields(line);
+        string kind, name, hash;
+        if (!(fields >> kind >> name >> hash) || name.find('/') != string::npos) {
+            continue;
+        }
+        if (kind == "module") {
+            previous_modules[name] = hash;
+        } else if (kind == "list") {
+            ListEntry &entry = previous_lists[name];
+            entry.hash = hash;
+            string module;
+            while (fields >> module) {
+                entry.modules.push_back(module);
+            }
+        }
+    }
+}
+
+string ModuleDirectory::path(const string &name) const {
+    return (filesystem::path(directory) / name).string();
+}
+
+int ModuleDirectory::writtenCount() const {
+    lock_guard<mutex> guard(lock);
+    return written;
+}
+
+int ModuleDirectory::unchangedCount() const {
+    lock_guard<mutex> guard(lock);
+    return unchanged;
+}
+
+int ModuleDirectory::removedCount() const {
+    lock_guard<mutex> guard(lock);
+    return removed;
+}
+
+// Функция записи файла name, если его содержимое отличается от content
+// Хэш сравнивается с хэшем файла на диске, а не с манифестом, поэтому правка файла вручную тоже
+// приводит к перезаписи. Новый файл пишется под временным именем и переименовывается, поэтому
+// параллельная сборка никогда не увидит недописанный файл
+bool ModuleDirectory::writeIfChanged(const string &name, const string &content, bool &changed, string &error) {
+    string file_path = path(name);
+    string hash = hashString(content);
+
+    ifstream existing(file_path, ios::binary);
+    if (existing.is_open()) {
+        stringstream ss;
+        ss << existing.rdbuf();
+        if (hashString(ss.str()) == hash) {
+            changed = false;
+            return true;
+        }
+    }
+    existing.close();
+
+    stringstream suffix;
+    suffix << ".tmp." << getpid() << "." << this_thread::get_id();
+    string temp_path = file_path + suffix.str();
+    {
+        ofstream file(temp_path, ios::binary);
+        file << content;
+        if (!file) {
+            error = "Не удалось записать файл: " + file_path;
+            file.close();
+            filesystem::remove(temp_path);
+            return false;
+        }
+    }
+    error_code ec;
+    filesystem::rename(temp_path, file_path, ec);
+    if (ec) {
+        error = "Не удалось записать файл: " + file_path;
+        filesystem::remove(temp_path, ec);
+        return false;
+    }
+    changed = true;
+    return true;
+}
+
+// Функция записи модулей и списка файлов <list_name>.f
+// Одинаковые модули разных списков пишутся в один файл: при общем ключе параметров их текст совпадает
+bool ModuleDirectory::write(const string &list_name, const vector<ModuleText> &modules, string &error) {
+    lock_guard<mutex> guard(lock);
+    string list;
+    for (const ModuleText &module : modules) {
+        bool changed;
+        if (!writeIfChanged(module.name + ".v", module.definition, changed, error)) {
+            return false;
+        }
+        hashes[module.name + ".v"] = hashString(module.definition);
+        (changed ? written : unchanged)++;
+        list += path(module.name + ".v") + "\n";
+    }
+    ListEntry &entry = lists[list_name + ".f"];
+    entry.hash = hashString(list);
+    entry.modules.clear();
+    for (const ModuleText &module : modules) {
+        entry.modules.push_back(module.name + ".v");
+    }
+    bool changed;
+    return writeIfChanged(list_name + ".f", list, changed, error);
+}
+
+// Функция записи манифеста: ключ параметров генератора, хэши модулей и списки файлов с их модулями
+// При том же ключе списки предыдущих запусков, которых нет в этом запуске, остаются, если файл списка
+// на месте; модули предыдущего манифеста, которые не входят ни в один оставшийся список, удаляются
+// При другом ключе удаляются все файлы предыдущего манифеста, которые этот запуск не записал
+bool ModuleDirectory::writeManifest(string &error) {
+    lock_guard<mutex> guard(lock);
+    error_code ec;
+    for (const auto &[name, entry] : previous_lists) {
+        if (lists.count(name)) {
+            continue;
+        }
+        if (same_key && filesystem::exists(path(name), ec)) {
+            lists[name] = entry;
+        } else if (filesystem::remove(path(name), ec)) {
+            removed++;
+        }
+    }
+    for (const auto &[name, entry] : lists) {
+        for (const string &module : entry.modules) {
+            auto previous = previous_modules.find(module);
+            if (!hashes.count(module) && previous != previous_modules.end()) {
+                hashes[module] = previous->second;
+            }
+        }
+    }
+    for (const auto &[name, hash] : previous_modules) {
+        if (!hashes.count(name) && filesystem::remove(path(name), ec)) {
+            removed++;
+        }
+    }
+    previous_lists.clear();
+    previous_modules.clear();
+
+    string manifest = "options " + key + "\n";
+    for (const auto &[name, hash] : hashes) {
+        manifest += "module " + name + " " + hash + "\n";
+    }
+    for (const auto &[name, entry] : lists) {
+        manifest += "list " + name + " " + entry.hash;
+        for (const string &module : entry.modules) {
+            manifest += " " + module;
+        }
+        manifest += "\n";
+    }
+    bool changed;
+    return writeIfChanged(MANIFEST_FILENAME, manifest, changed, error);
+}
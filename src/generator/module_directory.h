@@ -0,0 +1,67 @@
+#ifndef MODULE_DIRECTORY_H
+#define MODULE_DIRECTORY_H
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+using namespace std;
+
+// Определение модуля, выделенное из текста Verilog
+struct ModuleText {
+    string name;
+    string definition;  // Текст от комментариев перед module до пустой строки после endmodule
+};
+
+// Функция разбиения текста генератора на определения модулей в порядке следования
+// Генератор выводит подмодули раньше использующих их модулей, поэтому порядок - порядок зависимостей
+vector<ModuleText> splitModules(const string &verilog);
+
+// Папка с модулями в отдельных файлах <имя модуля>.v, списками файлов .f и манифестом manifest.txt
+// Файл перезаписывается, только если хэш его содержимого изменился, поэтому у неизменных модулей
+// сохраняется время изменения и make или САПР пересобирают только то, что действительно изменилось
+// Манифест хранит ключ параметров генератора, хэши файлов и модули каждого списка. При том же ключе
+// списки предыдущих запусков, которые этот запуск не перезаписал, сохраняются вместе с их модулями,
+// а удаляются только модули, которые не входят ни в один список. При другом ключе файлы предыдущего
+// манифеста, которые этот запуск не записал, удаляются все
+// Методы можно вызывать из нескольких потоков
+class ModuleDirectory {
+public:
+    ModuleDirectory(const string &dir, const string &options_key);
+
+    // Запись модулей и списка файлов <list_name>.f в порядке modules; false и error при ошибке записи
+    bool write(const string &list_name, const vector<ModuleText> &modules, string &error);
+    // Удаление устаревших файлов и запись манифеста; вызывается после всех write
+    bool writeManifest(string &error);
+
+    // Путь к файлу name в папке
+    string path(const string &name) const;
+    // Число перезаписанных и оставленных без изменений файлов модулей
+    int writtenCount() const;
+    int unchangedCount() const;
+    // Число удаленных устаревших файлов модулей и списков
+    int removedCount() const;
+
+private:
+    // Список файлов: хэш содержимого и имена файлов его модулей
+    struct ListEntry {
+        string hash;
+        vector<string> modules;
+    };
+
+    bool writeIfChanged(const string &name, const string &content, bool &changed, string &error);
+
+    string directory;
+    string key;                     // Ключ параметров генератора
+    map<string, string> hashes;           // Хэши модулей этого запуска по именам файлов
+    map<string, ListEntry> lists;         // Списки файлов этого запуска по именам файлов
+    bool same_key = false;                // Манифест предыдущего запуска записан с тем же ключом
+    map<string, string> previous_modules; // Модули из манифеста предыдущего запуска
+    map<string, ListEntry> previous_lists; // Списки файлов из манифеста предыдущего запуска
+    int written = 0;
+    int unchanged = 0;
+    int removed = 0;
+    mutable mutex lock;
+};
+
+#endif
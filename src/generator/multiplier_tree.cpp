@@ -0,0 +1,243 @@
+#include "multiplier_tree.h"
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+
+bool parseBaseMultiplier(const string &str, BaseMultiplier &base) {
+    if (str == "flat") {
+        base = BaseMultiplier::Flat;
+    } else if (str == "wallace") {
+        base = BaseMultiplier::Wallace;
+    } else if (str == "dadda") {
+        base = BaseMultiplier::Dadda;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+string baseMultiplierName(BaseMultiplier base) {
+    switch (base) {
+        case BaseMultiplier::Wallace:
+            return "wallace";
+        case BaseMultiplier::Dadda:
+            return "dadda";
+        default:
+            return "flat";
+    }
+}
+
+// Построитель дерева сжатия: хранит столбцы битов одного веса и выводит ячейки сумматоров
+class CompressionTree {
+public:
+    CompressionTree(const string &prefix, int width, ostream &out) : columns(width), prefix(prefix), out(out) {
+    }
+
+    vector<vector<string>> columns;  // Биты столбцов, столбец i имеет вес 2^i
+
+    // Высота самого высокого столбца
+    size_t maxHeight() const {
+        size_t height = 0;
+        for (const vector<string> &column : columns) {
+            height = max(height, column.size());
+        }
+        return height;
+    }
+
+    // Полный сумматор: три бита столбца i дают сумму в столбец i и перенос в столбец i + 1
+    void fullAdder(const string &a, const string &b, const string &c, int i, vector<vector<string>> &next) {
+        string sum = prefix + "_fs" + to_string(cell_count);
+        string carry = prefix + "_fc" + to_string(cell_count);
+        out << "wire " << sum << ", " << carry << ";\n";
+        out << "full_adder " << prefix << "_fa" << cell_count << " (.a(" << a << "), .b(" << b << "), .cin(" << c
+            << "), .sum(" << sum << "), .cout(" << carry << "));\n";
+        cell_count++;
+        place(sum, carry, i, next);
+    }
+
+    // Полусумматор: два бита столбца i дают сумму в столбец i и перенос в столбец i + 1
+    void halfAdder(const string &a, const string &b, int i, vector<vector<string>> &next) {
+        string sum = prefix + "_hs" + to_string(cell_count);
+        string carry = prefix + "_hc" + to_string(cell_count);
+        out << "wire " << sum << ", " << carry << ";\n";
+        out << "half_adder " << prefix << "_ha" << cell_count << " (.a(" << a << "), .b(" << b
+            << "), .sum(" << sum << "), .cout(" << carry << "));\n";
+        cell_count++;
+        place(sum, carry, i, next);
+    }
+
+    // Строка из битов с номером index в каждом столбце; отсутствующие биты равны нулю
+    string row(size_t index) const {
+        string result = "{";
+        for (int i = static_cast<int>(columns.size()) - 1; i >= 0; --i) {
+            result += index < columns[i].size() ? columns[i][index] : "1'b0";
+            result += i > 0 ? ", " : "}";
+        }
+        return result;
+    }
+
+private:
+    // Переносы из старшего столбца отбрасываются: произведение помещается в columns.size() бит
+    void place(const string &sum, const string &carry, int i, vector<vector<string>> &next) {
+        next[i].push_back(sum);
+        if (i + 1 < static_cast<int>(next.size())) {
+            next[i + 1].push_back(carry);
+        }
+    }
+
+    string prefix;
+    ostream &out;
+    int cell_count = 0;
+};
+
+// Шаг дерева Уоллеса: в каждом столбце высоты больше 2 все тройки битов сжимаются полными
+// сумматорами, оставшаяся пара - полусумматором
+static void wallaceStage(CompressionTree &tree) {
+    vector<vector<string>> next(tree.columns.size());
+    for (size_t i = 0; i < tree.columns.size(); ++i) {
+        const vector<string> &column = tree.columns[i];
+        size_t k = 0;
+        if (column.size() > 2) {
+            for (; k + 3 <= column.size(); k += 3) {
+                tree.fullAdder(column[k], column[k + 1], column[k + 2], i, next);
+            }
+            if (k + 2 == column.size()) {
+                tree.halfAdder(column[k], column[k + 1], i, next);
+                k += 2;
+            }
+        }
+        for (; k < column.size(); ++k) {
+            next[i].push_back(column[k]);
+        }
+    }
+    tree.columns = next;
+}
+
+// Шаг дерева Дадды: каждый столбец вместе с переносами этого шага сжимается ровно до target
+// битов минимальным числом ячеек; полусумматор ставится, только если не хватает одного бита
+static void daddaStage(CompressionTree &tree, size_t target) {
+    vector<vector<string>> next(tree.columns.size());
+    for (size_t i = 0; i < tree.columns.size(); ++i) {
+        const vector<string> &column = tree.columns[i];
+        size_t k = 0;
+        while (column.size() - k + next[i].size() > target && column.size() - k >= 2) {
+            if (column.size() - k + next[i].size() == target + 1 || column.size() - k == 2) {
+                tree.halfAdder(column[k], column[k + 1], i, next);
+                k += 2;
+            } else {
+                tree.fullAdder(column[k], column[k + 1], column[k + 2], i, next);
+                k += 3;
+            }
+        }
+        for (; k < column.size(); ++k) {
+            next[i].push_back(column[k]);
+        }
+    }
+    tree.columns = next;
+}
+
+// Функция для сжатия столбцов дерева до двух строк и их сложения одним сумматором по числу столбцов
+static void reduceCompressionTree(CompressionTree &tree, const string &product, BaseMultiplier style, ostream &out) {
+    if (style == BaseMultiplier::Dadda) {
+        // Последовательность высот Дадды 2, 3, 4, 6, 9, 13, ... ниже высоты исходных столбцов
+        vector<size_t> targets = {2};
+        while (targets.back() * 3 / 2 < tree.maxHeight()) {
+            targets.push_back(targets.back() * 3 / 2);
+        }
+        for (auto it = targets.rbegin(); it != targets.rend(); ++it) {
+            daddaStage(tree, *it);
+        }
+    }
+    while (tree.maxHeight() > 2) {
+        wallaceStage(tree);
+    }
+
+    // Итоговый сумматор двух строк
+    out << "adder_" << tree.columns.size() << " " << product << "_final (\n";
+    out << "    .a(" << tree.row(0) << "),\n";
+    out << "    .b(" << tree.row(1) << "),\n";
+    out << "    .sum(" << product << ")\n";
+    out << ");\n";
+}
+
+// Функция для генерации умножения n x n бит деревом сжатия
+// Частичные произведения a[i] & b[j] попадают в столбец i + j, дерево сжимает столбцы до высоты 2,
+// после чего две строки складываются одним сумматором adder_{2n}
+void generateCompressionTreeLogic(int n, const string &a, const string &b, const string &product,
+                                  BaseMultiplier style, ostream &out) {
+    out << "// Умножение " << n << "-битных чисел деревом " << (style == BaseMultiplier::Dadda ? "Дадды" : "Уоллеса") << "\n";
+    CompressionTree tree(product, 2 * n, out);
+    for (int i = 0; i < n; ++i) {
+        string row = product + "_pp" + to_string(i);
+        out << "wire [" << n - 1 << ":0] " << row << " = {" << n << "{" << a << "[" << i << "]}} & " << b << ";\n";
+        for (int j = 0; j < n; ++j) {
+            tree.columns[i + j].push_back(row + "[" + to_string(j) + "]");
+        }
+    }
+    reduceCompressionTree(tree, product, style, out);
+}
+
+// Функция для генерации возведения в квадрат n-битного числа деревом сжатия
+// a[i] & a[j] и a[j] & a[i] при i < j дают один бит в столбце i + j + 1, а a[i] & a[i] = a[i] -
+// бит в столбце 2i, поэтому частичных произведений n(n + 1) / 2 вместо n^2
+void generateSquareTreeLogic(int n, const string &a, const string &product, BaseMultiplier style, ostream &out) {
+    out << "// Возведение в квадрат " << n << "-битного числа деревом " << (style == BaseMultiplier::Dadda ? "Дадды" : "Уоллеса") << "\n";
+    CompressionTree tree(product, 2 * n, out);
+    for (int i = 0; i < n; ++i) {
+        tree.columns[2 * i].push_back(a + "[" + to_string(i) + "]");
+        if (i + 1 < n) {
+            string row = product + "_pp" + to_string(i);
+            out << "wire [" << n - i - 2 << ":0] " << row << " = {" << n - i - 1 << "{" << a << "[" << i << "]}} & "
+                << a << "[" << n - 1 << ":" << i + 1 << "];\n";
+            for (int j = i + 1; j < n; ++j) {
+                tree.columns[i + j + 1].push_back(row + "[" + to_string(j - i - 1) + "]");
+            }
+        }
+    }
+    reduceCompressionTree(tree, product, style, out);
+}
+
+// Функция для генерации части [lo, hi) произведения n x n бит деревом сжатия
+// В дерево попадают только a[i] & b[j] с lo <= i + j < hi, в столбец i + j - lo; переносы из столбца
+// hi - 1 отбрасываются. При lo = 0 результат - x * y mod 2^hi, при hi = 2n - приближение
+// floor(x * y / 2^lo) снизу без частичных произведений веса меньше 2^lo
+void generateTruncatedTreeLogic(int n, const string &a, const string &b, const string &product, int lo, int hi,
+                                BaseMultiplier style, ostream &out) {
+    out << "// Разряды [" << hi - 1 << ":" << lo << "] умножения " << n << "-битных чисел деревом "
+        << (style == BaseMultiplier::Dadda ? "Дадды" : "Уоллеса") << "\n";
+    CompressionTree tree(product, hi - lo, out);
+    for (int i = 0; i < n; ++i) {
+        for (int j = max(0, lo - i); j < n && i + j < hi; ++j) {
+            tree.columns[i + j - lo].push_back("(" + a + "[" + to_string(i) + "] & " + b + "[" + to_string(j) + "])");
+        }
+    }
+    reduceCompressionTree(tree, product, style, out);
+}
+
+// Функция для генерации ячейки полного сумматора
+void generateFullAdderModule(ostream &out) {
+    out << "module full_adder(\n";
+    out << "    input a,\n";
+    out << "    input b,\n";
+    out << "    input cin,\n";
+    out << "    output sum,\n";
+    out << "    output cout\n";
+    out << ");\n";
+    out << "assign sum = a ^ b ^ cin;\n";
+    out << "assign cout = (a & b) | (cin & (a ^ b));\n";
+    out << "endmodule\n";
+}
+
+// Функция для генерации ячейки полусумматора
+void generateHalfAdderModule(ostream &out) {
+    out << "module half_adder(\n";
+    out << "    input a,\n";
+    out << "    input b,\n";
+    out << "    output sum,\n";
+    out << "    output cout\n";
+    out << ");\n";
+    out << "assign sum = a ^ b;\n";
+    out << "assign cout = a & b;\n";
+    out << "endmodule\n";
+}
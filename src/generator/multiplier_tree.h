@@ -0,0 +1,33 @@
+#ifndef MULTIPLIER_TREE_H
+#define MULTIPLIER_TREE_H
+
+#include <ostream>
+#include <string>
+using namespace std;
+
+// Реализация базового (прямого) умножителя
+enum class BaseMultiplier {
+    Flat,     // Одна сумма всех частичных произведений, дерево строит синтезатор
+    Wallace,  // Дерево Уоллеса: на каждом шаге сжимаются все тройки битов столбца
+    Dadda     // Дерево Дадды: столбцы сжимаются ровно до высот 2, 3, 4, 6, 9, ...
+};
+
+bool parseBaseMultiplier(const string &str, BaseMultiplier &base);
+string baseMultiplierName(BaseMultiplier base);
+
+// Функция для генерации умножения n x n бит деревом сжатия из ячеек full_adder/half_adder
+// Две оставшиеся строки складываются модулем adder_{2n}; определения ячеек и сумматора
+// должны быть выведены до модуля, использующего эту логику
+void generateCompressionTreeLogic(int n, const string &a, const string &b, const string &product,
+                                  BaseMultiplier style, ostream &out);
+// Функция для генерации возведения в квадрат n-битного числа деревом сжатия: каждое
+// произведение a[i] & a[j] при i != j встречается дважды и заменяется одним битом на разряд выше
+void generateSquareTreeLogic(int n, const string &a, const string &product, BaseMultiplier style, ostream &out);
+// Функция для генерации разрядов [lo, hi) произведения n x n бит деревом сжатия только из частичных
+// произведений a[i] & b[j] с lo <= i + j < hi; итоговый сумматор - adder_{hi-lo}
+void generateTruncatedTreeLogic(int n, const string &a, const string &b, const string &product, int lo, int hi,
+                                BaseMultiplier style, ostream &out);
+void generateFullAdderModule(ostream &out);
+void generateHalfAdderModule(ostream &out);
+
+#endif
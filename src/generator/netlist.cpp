@@ -0,0 +1,430 @@
+#include "netlist.h"
+#include <algorithm>
+#include <climits>
+
+using namespace std;
+
+Bus constantBus(int width, uint64_t value) {
+    Bus bus;
+    for (int i = 0; i < width; ++i) {
+        bus.push_back({CONSTANT_NET, i < 64 ? static_cast<int>((value >> i) & 1) : 0});
+    }
+    return bus;
+}
+
+Bus sliceBus(const Bus &bus, int lo, int width) {
+    return Bus(bus.begin() + lo, bus.begin() + lo + width);
+}
+
+Bus concatBus(const Bus &low, const Bus &high) {
+    Bus bus = low;
+    bus.insert(bus.end(), high.begin(), high.end());
+    return bus;
+}
+
+Bus resizeBus(const Bus &bus, int width) {
+    Bus result = bus;
+    result.resize(width, {CONSTANT_NET, 0});
+    return result;
+}
+
+static bool isConstant(const NetlistBit &bit) {
+    return bit.net == CONSTANT_NET;
+}
+
+static bool isZero(const NetlistBit &bit) {
+    return bit.net == CONSTANT_NET && bit.index == 0;
+}
+
+static NetlistBit constantBit(int value) {
+    return {CONSTANT_NET, value};
+}
+
+int Netlist::addInput(const string &name, int width) {
+    nets.push_back({name, width, {}});
+    inputs.push_back(static_cast<int>(nets.size()) - 1);
+    return inputs.back();
+}
+
+Bus Netlist::bus(int net) const {
+    Bus bus;
+    for (int i = 0; i < nets[net].width; ++i) {
+        bus.push_back({net, i});
+    }
+    return bus;
+}
+
+vector<Bus> Netlist::addCell(CellKind kind, const string &name, int width, const vector<Bus> &inputs,
+                             const vector<string> &output_names, int cycles, bool direct) {
+    NetlistCell cell;
+    cell.kind = kind;
+    cell.name = name;
+    cell.width = width;
+    cell.cycles = cycles;
+    cell.direct = direct;
+    cell.inputs = inputs;
+
+    vector<Bus> outputs;
+    for (const string &output_name : output_names) {
+        nets.push_back({output_name, kind == CellKind::Multiplier ? 2 * width : width, {}});
+        cell.outputs.push_back(static_cast<int>(nets.size()) - 1);
+        outputs.push_back(bus(cell.outputs.back()));
+    }
+    cells.push_back(cell);
+    return outputs;
+}
+
+void Netlist::setOutput(const string &name, const Bus &bus) {
+    output_name = name;
+    output = bus;
+}
+
+NetlistBit Netlist::resolve(NetlistBit bit) const {
+    while (!isConstant(bit) && !nets[bit.net].alias.empty()) {
+        bit = nets[bit.net].alias[bit.index];
+    }
+    return bit;
+}
+
+Bus Netlist::resolve(const Bus &bus) const {
+    Bus result;
+    for (const NetlistBit &bit : bus) {
+        result.push_back(resolve(bit));
+    }
+    return result;
+}
+
+// Функция для записи шины выражением Verilog: подряд идущие биты одной цепи объединяются в диапазон,
+// подряд идущие константы - в одну константу
+string Netlist::expression(const Bus &bus) const {
+    Bus bits = resolve(bus);
+    vector<string> parts;
+    int i = static_cast<int>(bits.size()) - 1;
+    while (i >= 0) {
+        int j = i;
+        if (isConstant(bits[i])) {
+            while (j > 0 && isConstant(bits[j - 1])) {
+                j--;
+            }
+            string digits;
+            bool any_one = false;
+            for (int k = i; k >= j; --k) {
+                digits += bits[k].index ? '1' : '0';
+                any_one = any_one || bits[k].index;
+            }
+            parts.push_back(to_string(i - j + 1) + "'b" + (any_one ? digits : "0"));
+        } else {
+            while (j > 0 && bits[j - 1].net == bits[i].net && bits[j - 1].index == bits[j].index - 1) {
+                j--;
+            }
+            const NetlistNet &net = nets[bits[i].net];
+            int hi = bits[i].index, lo = bits[j].index;
+            if (lo == 0 && hi == net.width - 1) {
+                parts.push_back(net.name);
+            } else if (lo == hi) {
+                parts.push_back(net.name + "[" + to_string(hi) + "]");
+            } else {
+                parts.push_back(net.name + "[" + to_string(hi) + ":" + to_string(lo) + "]");
+            }
+        }
+        i = j - 1;
+    }
+
+    if (parts.size() == 1) {
+        return parts[0];
+    }
+    string result = "{";
+    for (size_t k = 0; k < parts.size(); ++k) {
+        result += (k ? ", " : "") + parts[k];
+    }
+    return result + "}";
+}
+
+// Функция для замены ячейки ее частью, обрабатывающей позиции [lo, hi)
+// Выходные цепи заменяются новыми меньшей разрядности; у CarrySave бит lo переноса
+// формируется позицией lo - 1, поэтому он тоже задается bit_outside
+void Netlist::narrowCell(size_t index, int lo, int hi, const function<NetlistBit(int output, int position)> &bit_outside) {
+    NetlistCell &cell = cells[index];
+    int width = hi - lo;
+    if (width <= 0) {
+        cell.removed = true;
+    } else {
+        cell.width = width;
+        for (Bus &input : cell.inputs) {
+            input = sliceBus(resolve(input), lo, width);
+        }
+    }
+
+    for (size_t o = 0; o < cell.outputs.size(); ++o) {
+        int old_net = cell.outputs[o];
+        int new_net = -1;
+        if (!cell.removed) {
+            nets.push_back({nets[old_net].name, width, {}});
+            new_net = static_cast<int>(nets.size()) - 1;
+            cell.outputs[o] = new_net;
+        }
+        int first_mapped = (cell.kind == CellKind::CarrySave && o == 1) ? lo + 1 : lo;
+        Bus alias;
+        for (int i = 0; i < nets[old_net].width; ++i) {
+            if (!cell.removed && i >= first_mapped && i < hi) {
+                alias.push_back({new_net, i - lo});
+            } else {
+                alias.push_back(bit_outside(static_cast<int>(o), i));
+            }
+        }
+        nets[old_net].alias = alias;
+    }
+}
+
+// Прямой проход: биты, значение которых известно без вычисления, убираются из ячеек
+// Младшие позиции сумматора с нулевым операндом дают второй операнд без переноса,
+// старшие позиции с двумя нулевыми операндами дают нули
+bool Netlist::propagateConstants() {
+    bool changed = false;
+    for (size_t c = 0; c < cells.size(); ++c) {
+        if (cells[c].removed) {
+            continue;
+        }
+        for (Bus &input : cells[c].inputs) {
+            input = resolve(input);
+        }
+        const NetlistCell cell = cells[c];
+        int w = cell.width;
+        int lo = 0, hi = w;
+
+        switch (cell.kind) {
+            case CellKind::Adder: {
+                const Bus &a = cell.inputs[0], &b = cell.inputs[1];
+                int top = -1;
+                for (int i = 0; i < w; ++i) {
+                    if (!isZero(a[i]) || !isZero(b[i])) {
+                        top = i;
+                    }
+                }
+                while (lo < w && (isZero(a[lo]) || isZero(b[lo]))) {
+                    lo++;
+                }
+                hi = max(lo, min(w, top + 2));
+                if (lo > 0 || hi < w) {
+                    narrowCell(c, lo, hi, [&](int, int i) {
+                        return i < lo ? (isZero(a[i]) ? b[i] : a[i]) : constantBit(0);
+                    });
+                    changed = true;
+                }
+                break;
+            }
+            case CellKind::Subtractor: {
+                const Bus &a = cell.inputs[0], &b = cell.inputs[1];
+                while (lo < w && isZero(b[lo])) {
+                    lo++;
+                }
+                if (lo > 0) {
+                    narrowCell(c, lo, hi, [&](int, int i) { return a[i]; });
+                    changed = true;
+                }
+                break;
+            }
+            case CellKind::CarrySave: {
+                const Bus &a = cell.inputs[0], &b = cell.inputs[1], &d = cell.inputs[2];
+                int top = -1;
+                for (int i = 0; i < w; ++i) {
+                    if (!isZero(a[i]) || !isZero(b[i]) || !isZero(d[i])) {
+                        top = i;
+                    }
+                }
+                while (lo < w && isConstant(a[lo]) && isConstant(b[lo]) && isConstant(d[lo])) {
+                    lo++;
+                }
+                hi = max(lo, min(w, top + 2));
+                if (lo > 0 || hi < w) {
+                    narrowCell(c, lo, hi, [&](int output, int i) {
+                        if (output == 0) {
+                            return constantBit(i < lo ? a[i].index ^ b[i].index ^ d[i].index : 0);
+                        }
+                        if (i == 0 || i - 1 >= lo) {
+                            return constantBit(0);
+                        }
+                        int ones = a[i - 1].index + b[i - 1].index + d[i - 1].index;
+                        return constantBit(ones >= 2 ? 1 : 0);
+                    });
+                    changed = true;
+                }
+                break;
+            }
+            case CellKind::Invert:
+            case CellKind::Delay: {
+                // Инверсия константы - константа; регистр со сбросом в 0 хранит постоянный 0
+                const Bus &a = cell.inputs[0];
+                bool invert = cell.kind == CellKind::Invert;
+                auto known = [&](const NetlistBit &bit) { return invert ? isConstant(bit) : isZero(bit); };
+                while (lo < w && known(a[lo])) {
+                    lo++;
+                }
+                while (hi > lo && known(a[hi - 1])) {
+                    hi--;
+                }
+                if (lo > 0 || hi < w) {
+                    narrowCell(c, lo, hi, [&](int, int i) { return constantBit(invert ? 1 - a[i].index : 0); });
+                    changed = true;
+                }
+                break;
+            }
+            case CellKind::Multiplier: {
+                // Умножение на константный 0
+                auto zero = [](const Bus &bus) { return all_of(bus.begin(), bus.end(), isZero); };
+                if (any_of(cell.inputs.begin(), cell.inputs.end(), zero)) {
+                    narrowCell(c, 0, 0, [](int, int) { return constantBit(0); });
+                    changed = true;
+                }
+                break;
+            }
+        }
+    }
+    return changed;
+}
+
+// Обратный проход: ячейки сужаются до позиций, выходы которых кто-то читает
+// Сумматоры и вычитатели считают по модулю 2^w, поэтому отбрасываются только старшие позиции;
+// побитовые ячейки сужаются с обеих сторон, ячейки без читаемых выходов удаляются
+bool Netlist::trimUnusedBits() {
+    vector<vector<char>> used(nets.size());
+    for (size_t i = 0; i < nets.size(); ++i) {
+        used[i].assign(nets[i].width, 0);
+    }
+    auto mark = [&](const Bus &bus) {
+        for (const NetlistBit &bit : bus) {
+            NetlistBit resolved = resolve(bit);
+            if (!isConstant(resolved)) {
+                used[resolved.net][resolved.index] = 1;
+            }
+        }
+    };
+    mark(output);
+
+    bool changed = false;
+    for (size_t c = cells.size(); c-- > 0;) {
+        if (cells[c].removed) {
+            continue;
+        }
+        const NetlistCell &cell = cells[c];
+        int lo = INT_MAX, hi = 0;
+        for (size_t o = 0; o < cell.outputs.size(); ++o) {
+            int net = cell.outputs[o];
+            for (int i = 0; i < nets[net].width; ++i) {
+                if (used[net][i]) {
+                    int position = (cell.kind == CellKind::CarrySave && o == 1) ? i - 1 : i;
+                    lo = min(lo, max(position, 0));
+                    hi = max(hi, i + 1);
+                }
+            }
+        }
+
+        if (hi == 0) {
+            narrowCell(c, 0, 0, [](int, int) { return constantBit(0); });
+            changed = true;
+            continue;
+        }
+        if (cell.kind == CellKind::Adder || cell.kind == CellKind::Subtractor) {
+            lo = 0;
+        }
+        if (cell.kind != CellKind::Multiplier && (lo > 0 || hi < cell.width)) {
+            narrowCell(c, lo, hi, [](int, int) { return constantBit(0); });
+            changed = true;
+        }
+        for (const Bus &input : cells[c].inputs) {
+            mark(input);
+        }
+    }
+    return changed;
+}
+
+void Netlist::optimize() {
+    bool changed = true;
+    while (changed) {
+        changed = propagateConstants();
+        changed = trimUnusedBits() || changed;
+    }
+}
+
+// Функция для вывода списка соединений в виде тела модуля Verilog
+void printNetlist(const Netlist &netlist,
+                  const function<void(const NetlistCell &, const string &, const string &, const string &, ostream &)> &print_multiplier,
+                  ostream &out) {
+    for (const NetlistCell &cell : netlist.cells) {
+        if (cell.removed) {
+            continue;
+        }
+        string range = "[" + to_string(cell.width - 1) + ":0]";
+        const string &result = netlist.nets[cell.outputs[0]].name;
+
+        switch (cell.kind) {
+            case CellKind::Adder:
+            case CellKind::Subtractor: {
+                bool adder = cell.kind == CellKind::Adder;
+                out << "wire " << range << " " << result << ";\n";
+                out << (adder ? "adder_" : "subtractor_") << cell.width << " " << cell.name << " (\n";
+                out << "    .a(" << netlist.expression(cell.inputs[0]) << "),\n";
+                out << "    .b(" << netlist.expression(cell.inputs[1]) << "),\n";
+                out << "    ." << (adder ? "sum" : "diff") << "(" << result << ")\n";
+                out << ");\n";
+                break;
+            }
+            case CellKind::CarrySave: {
+                const string &carry = netlist.nets[cell.outputs[1]].name;
+                out << "wire " << range << " " << result << ", " << carry << ";\n";
+                out << "csa_" << cell.width << " " << cell.name << " (\n";
+                out << "    .a(" << netlist.expression(cell.inputs[0]) << "),\n";
+                out << "    .b(" << netlist.expression(cell.inputs[1]) << "),\n";
+                out << "    .c(" << netlist.expression(cell.inputs[2]) << "),\n";
+                out << "    .sum(" << result << "),\n";
+                out << "    .carry(" << carry << ")\n";
+                out << ");\n";
+                break;
+            }
+            case CellKind::Invert:
+                out << "wire " << range << " " << result << " = ~" << netlist.expression(cell.inputs[0]) << ";\n";
+                break;
+            case CellKind::Delay: {
+                // Регистры name_d1, ..., name_d<cycles>, как у generateDelayLine
+                string stage = netlist.expression(cell.inputs[0]);
+                out << "reg " << range;
+                for (int i = 1; i <= cell.cycles; ++i) {
+                    out << (i == 1 ? " " : ", ") << cell.name << "_d" << i;
+                }
+                out << ";\n";
+                out << "always @(posedge clk) begin\n";
+                out << "    if (rst) begin\n";
+                for (int i = 1; i <= cell.cycles; ++i) {
+                    out << "        " << cell.name << "_d" << i << " <= 0;\n";
+                }
+                out << "    end else begin\n";
+                for (int i = 1; i <= cell.cycles; ++i) {
+                    out << "        " << cell.name << "_d" << i << " <= " << stage << ";\n";
+                    stage = cell.name + "_d" + to_string(i);
+                }
+                out << "    end\n";
+                out << "end\n\n";
+                break;
+            }
+            case CellKind::Multiplier: {
+                // Прямому умножению нужны имена цепей операндов, поэтому части цепей получают собственные имена
+                vector<string> operands;
+                for (size_t k = 0; k < cell.inputs.size(); ++k) {
+                    Bus operand = netlist.resolve(cell.inputs[k]);
+                    string expression = netlist.expression(operand);
+                    bool whole_net = !isConstant(operand[0]) && expression == netlist.nets[operand[0].net].name;
+                    if (whole_net || !cell.direct) {
+                        operands.push_back(expression);
+                    } else {
+                        operands.push_back(cell.name + (k == 0 ? "_a" : "_b"));
+                        out << "wire " << range << " " << operands.back() << " = " << expression << ";\n";
+                    }
+                }
+                out << "wire [" << 2 * cell.width - 1 << ":0] " << result << ";\n";
+                print_multiplier(cell, operands[0], operands.back(), result, out);
+                break;
+            }
+        }
+    }
+    out << "assign " << netlist.output_name << " = " << netlist.expression(netlist.output) << ";\n";
+}
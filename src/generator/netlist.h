@@ -0,0 +1,98 @@
+#ifndef NETLIST_H
+#define NETLIST_H
+
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+using namespace std;
+
+// Номер "цепи" константных битов
+const int CONSTANT_NET = -1;
+
+// Бит сигнала: бит index цепи net или константа index (0 или 1), если net == CONSTANT_NET
+struct NetlistBit {
+    int net;
+    int index;
+};
+
+// Шина: биты от младшего к старшему
+using Bus = vector<NetlistBit>;
+
+Bus constantBus(int width, uint64_t value);
+Bus sliceBus(const Bus &bus, int lo, int width);
+// Шина {high, low}
+Bus concatBus(const Bus &low, const Bus &high);
+// Дополнение нулями или усечение до width бит
+Bus resizeBus(const Bus &bus, int width);
+
+// Вид ячейки списка соединений
+enum class CellKind {
+    Adder,       // adder_w: sum = a + b по модулю 2^w
+    Subtractor,  // subtractor_w: diff = a - b по модулю 2^w
+    CarrySave,   // csa_w: a + b + c = sum + carry
+    Invert,      // Побитовая инверсия ~a
+    Delay,       // Линия задержки на cycles тактов с синхронным сбросом в 0
+    Multiplier   // Умножитель w x w бит: подмодуль Карацубы или прямое умножение; с одним входом - квадрат
+};
+
+struct NetlistCell {
+    CellKind kind;
+    string name;           // Имя экземпляра; для линии задержки - основа имен регистров
+    int width;             // Разрядность операндов
+    int cycles = 0;        // Delay: число тактов
+    bool direct = false;   // Multiplier: прямое умножение вместо подмодуля
+    vector<Bus> inputs;
+    vector<int> outputs;   // Номера выходных цепей
+    bool removed = false;
+};
+
+struct NetlistNet {
+    string name;
+    int width;
+    Bus alias;             // Если не пуст, цепь заменена этими битами и не выводится
+};
+
+// Список соединений тела модуля Карацубы: входы, ячейки в порядке зависимостей и выходная шина
+// Оптимизации работают на уровне битов: известные константы и биты, проходящие через ячейку
+// без изменений, подставляются в потребителей, а ячейки сужаются до нужных битов
+class Netlist {
+public:
+    int addInput(const string &name, int width);
+    Bus bus(int net) const;
+    // Добавление ячейки; возвращает выходные шины (две у CarrySave, по одной у остальных)
+    vector<Bus> addCell(CellKind kind, const string &name, int width, const vector<Bus> &inputs,
+                        const vector<string> &output_names, int cycles = 0, bool direct = false);
+    void setOutput(const string &name, const Bus &bus);
+
+    // Распространение констант, сужение ячеек и удаление неиспользуемой логики до неподвижной точки
+    void optimize();
+
+    NetlistBit resolve(NetlistBit bit) const;
+    Bus resolve(const Bus &bus) const;
+    // Выражение Verilog для шины, например {z2_0[5:0], 3'b0}
+    string expression(const Bus &bus) const;
+
+    vector<NetlistNet> nets;
+    vector<NetlistCell> cells;
+    vector<int> inputs;
+    string output_name;
+    Bus output;
+
+private:
+    bool propagateConstants();
+    bool trimUnusedBits();
+    // Замена ячейки index на ее часть, обрабатывающую позиции [lo, hi);
+    // bit_outside задает значения выходных битов вне этого диапазона
+    void narrowCell(size_t index, int lo, int hi, const function<NetlistBit(int output, int position)> &bit_outside);
+};
+
+// Функция для вывода списка соединений в виде тела модуля Verilog
+// Умножители выводит print_multiplier(cell, a, b, product, out); для прямого умножения a и b -
+// имена цепей, для подмодуля - выражения; у квадратора b совпадает с a
+void printNetlist(const Netlist &netlist,
+                  const function<void(const NetlistCell &, const string &, const string &, const string &, ostream &)> &print_multiplier,
+                  ostream &out);
+
+#endif
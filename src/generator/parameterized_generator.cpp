@@ -0,0 +1,157 @@
+#include "parameterized_generator.h"
+
+using namespace std;
+
+// Функция для генерации параметризованного сумматора
+void generateParameterizedAdderModule(ostream &out) {
+    out << "module adder #(parameter N = 1) (\n";
+    out << "    input [N-1:0] a,\n";
+    out << "    input [N-1:0] b,\n";
+    out << "    output [N-1:0] sum\n";
+    out << ");\n";
+    out << "assign sum = a + b;\n";
+    out << "endmodule\n";
+}
+
+// Функция для генерации параметризованного вычитателя
+void generateParameterizedSubtractorModule(ostream &out) {
+    out << "module subtractor #(parameter N = 1) (\n";
+    out << "    input [N-1:0] a,\n";
+    out << "    input [N-1:0] b,\n";
+    out << "    output [N-1:0] diff\n";
+    out << ");\n";
+    out << "assign diff = a - b;\n";
+    out << "endmodule\n";
+}
+
+// Функция для генерации параметризованного прямого умножителя
+// Сумма первых K строк строится рекурсией по K: строка i - это b, умноженное на бит a[i] и сдвинутое на i.
+// Та же сумма частичных произведений a[i] & b[j] со сдвигами i + j, что и у generateMultiplicationLogic
+void generateParameterizedDirectModule(ostream &out) {
+    out << "module direct_mult #(parameter N = 1, parameter K = N) (\n";
+    out << "    input [N-1:0] a,\n";
+    out << "    input [N-1:0] b,\n";
+    out << "    output [2*N-1:0] product\n";
+    out << ");\n\n";
+
+    out << "generate\n";
+    out << "    if (K == 1) begin : first_row\n";
+    out << "        assign product = {{N{1'b0}}, {N{a[0]}} & b};\n";
+    out << "    end else begin : next_row\n";
+    out << "        // Сумма строк 0..K-2 и строка K-1\n";
+    out << "        wire [2*N-1:0] rows;\n";
+    out << "        direct_mult #(.N(N), .K(K - 1)) previous (\n";
+    out << "            .a(a),\n";
+    out << "            .b(b),\n";
+    out << "            .product(rows)\n";
+    out << "        );\n";
+    out << "        assign product = rows + ({{N{1'b0}}, {N{a[K-1]}} & b} << (K - 1));\n";
+    out << "    end\n";
+    out << "endgenerate\n";
+    out << "endmodule\n";
+}
+
+// Функция для генерации параметризованного модуля Карацубы
+// Разбиение, разрядности сумм и порядок сумматоров повторяют generateKaratsubaModuleBody:
+// x1 - старшие M = N / 2 бит, x0 - младшие H = N - M, суммы частей - S = H + 1 бит
+void generateParameterizedKaratsubaModule(int cutoff, ostream &out) {
+    out << "module karatsuba_mult #(parameter N = 1, parameter CUTOFF = " << cutoff << ") (\n";
+    out << "    input [N-1:0] x,\n";
+    out << "    input [N-1:0] y,\n";
+    out << "    output [2*N-1:0] product\n";
+    out << ");\n\n";
+
+    out << "localparam M = N / 2;\n";
+    out << "localparam H = N - M;\n";
+    out << "localparam S = H + 1;\n";
+    out << "localparam P = 2 * S;\n\n";
+
+    out << "generate\n";
+    out << "    if (N <= 2 || N <= CUTOFF) begin : direct\n";
+    out << "        // Прямое умножение без дальнейшей рекурсии\n";
+    out << "        direct_mult #(.N(N)) base (\n";
+    out << "            .a(x),\n";
+    out << "            .b(y),\n";
+    out << "            .product(product)\n";
+    out << "        );\n";
+    out << "    end else begin : level\n";
+    out << "        wire [H-1:0] x0 = x[H-1:0];\n";
+    out << "        wire [M-1:0] x1 = x[N-1:H];\n";
+    out << "        wire [H-1:0] y0 = y[H-1:0];\n";
+    out << "        wire [M-1:0] y1 = y[N-1:H];\n\n";
+
+    out << "        // z2 = x1 * y1, z0 = x0 * y0\n";
+    out << "        wire [2*M-1:0] z2;\n";
+    out << "        karatsuba_mult #(.N(M), .CUTOFF(CUTOFF)) mult_z2 (\n";
+    out << "            .x(x1),\n";
+    out << "            .y(y1),\n";
+    out << "            .product(z2)\n";
+    out << "        );\n";
+    out << "        wire [2*H-1:0] z0;\n";
+    out << "        karatsuba_mult #(.N(H), .CUTOFF(CUTOFF)) mult_z0 (\n";
+    out << "            .x(x0),\n";
+    out << "            .y(y0),\n";
+    out << "            .product(z0)\n";
+    out << "        );\n\n";
+
+    out << "        // s1 = x1 + x0, s2 = y1 + y0\n";
+    out << "        wire [S-1:0] s1, s2;\n";
+    out << "        adder #(.N(S)) adder_s1 (\n";
+    out << "            .a({{S-M{1'b0}}, x1}),\n";
+    out << "            .b({{S-H{1'b0}}, x0}),\n";
+    out << "            .sum(s1)\n";
+    out << "        );\n";
+    out << "        adder #(.N(S)) adder_s2 (\n";
+    out << "            .a({{S-M{1'b0}}, y1}),\n";
+    out << "            .b({{S-H{1'b0}}, y0}),\n";
+    out << "            .sum(s2)\n";
+    out << "        );\n\n";
+
+    out << "        // p = s1 * s2; при S >= N рекурсия не уменьшает разрядность, поэтому p вычисляется напрямую\n";
+    out << "        wire [P-1:0] p;\n";
+    out << "        if (S < N) begin : recursive_p\n";
+    out << "            karatsuba_mult #(.N(S), .CUTOFF(CUTOFF)) mult_p (\n";
+    out << "                .x(s1),\n";
+    out << "                .y(s2),\n";
+    out << "                .product(p)\n";
+    out << "            );\n";
+    out << "        end else begin : direct_p\n";
+    out << "            direct_mult #(.N(S)) base_p (\n";
+    out << "                .a(s1),\n";
+    out << "                .b(s2),\n";
+    out << "                .product(p)\n";
+    out << "            );\n";
+    out << "        end\n\n";
+
+    out << "        // z1 = p - z2 - z0\n";
+    out << "        wire [P-1:0] temp_sub1, z1;\n";
+    out << "        subtractor #(.N(P)) sub1 (\n";
+    out << "            .a(p),\n";
+    out << "            .b({{P-2*M{1'b0}}, z2}),\n";
+    out << "            .diff(temp_sub1)\n";
+    out << "        );\n";
+    out << "        subtractor #(.N(P)) sub2 (\n";
+    out << "            .a(temp_sub1),\n";
+    out << "            .b({{P-2*H{1'b0}}, z0}),\n";
+    out << "            .diff(z1)\n";
+    out << "        );\n\n";
+
+    out << "        // product = z2 * 2^(2H) + z1 * 2^H + z0\n";
+    out << "        wire [2*N-1:0] z2_shift = {z2, {2*H{1'b0}}};\n";
+    out << "        wire [2*N-1:0] z1_shift = {z1, {H{1'b0}}};\n";
+    out << "        wire [2*N-1:0] z0_ext = {{2*N-2*H{1'b0}}, z0};\n";
+    out << "        wire [2*N-1:0] temp_sum1;\n";
+    out << "        adder #(.N(2*N)) adder1 (\n";
+    out << "            .a(z2_shift),\n";
+    out << "            .b(z1_shift),\n";
+    out << "            .sum(temp_sum1)\n";
+    out << "        );\n";
+    out << "        adder #(.N(2*N)) adder2 (\n";
+    out << "            .a(temp_sum1),\n";
+    out << "            .b(z0_ext),\n";
+    out << "            .sum(product)\n";
+    out << "        );\n";
+    out << "    end\n";
+    out << "endgenerate\n";
+    out << "endmodule\n";
+}
@@ -0,0 +1,19 @@
+#ifndef PARAMETERIZED_GENERATOR_H
+#define PARAMETERIZED_GENERATOR_H
+
+#include <ostream>
+using namespace std;
+
+// Параметризованные модули: одно рекурсивное определение на все разрядности вместо модуля на каждую
+// Структура совпадает с karatsuba_mult_n, adder_n и subtractor_n поведенческого комбинационного умножителя
+// с прямыми умножителями суммой частичных произведений, поэтому после элаборации схема та же
+
+// adder #(.N(w)) и subtractor #(.N(w)): sum = a + b и diff = a - b по модулю 2^w
+void generateParameterizedAdderModule(ostream &out);
+void generateParameterizedSubtractorModule(ostream &out);
+// direct_mult #(.N(w)): сумма строк частичных произведений ({N{a[i]}} & b) << i
+void generateParameterizedDirectModule(ostream &out);
+// karatsuba_mult #(.N(w), .CUTOFF(c)): уровень Карацубы или прямое умножение при N <= 2 или N <= CUTOFF
+void generateParameterizedKaratsubaModule(int cutoff, ostream &out);
+
+#endif
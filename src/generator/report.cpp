@@ -0,0 +1,804 @@
+#include "report.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace {
+
+// Глубина отсутствующего пути
+const int NO_PATH = -1;
+
+int extend(int depth, int levels) {
+    return depth == NO_PATH || levels == NO_PATH ? NO_PATH : depth + levels;
+}
+
+// Глубина сигнала в уровнях сумматоров от входов модуля и от ближайшего регистра
+struct Arrival {
+    int from_input = NO_PATH;
+    int from_register = NO_PATH;
+};
+
+// Глубина путей модуля в уровнях сумматоров
+struct Timing {
+    int input_to_register = NO_PATH;     // От входов до регистров
+    int register_to_register = NO_PATH; // Между регистрами
+    int input_to_output = NO_PATH;       // Комбинационный путь от входов до выхода
+    int register_to_output = NO_PATH;    // От регистров до выхода
+};
+
+Timing combinational(int levels) {
+    Timing timing;
+    timing.input_to_output = levels;
+    return timing;
+}
+
+// Сведения о модуле иерархии
+struct ModuleInfo {
+    int width = 0;
+    bool multiplier = false;  // karatsuba_mult_k, karatsuba_square_k или karatsuba_seq_k
+    LogicEstimate own;        // Логика тела модуля без подмодулей
+    vector<pair<string, long long>> children;  // Экземпляры подмодулей
+    Timing timing;
+};
+
+void addLogic(LogicEstimate &to, const LogicEstimate &from, long long count) {
+    to.gates += from.gates * count;
+    to.luts += from.luts * count;
+    to.registers += from.registers * count;
+    to.dsps += from.dsps * count;
+}
+
+// Функция для прохода сигнала через подмодуль с глубинами timing
+// Пути, которые заканчиваются на регистрах подмодуля, учитываются в глубинах модуля module
+Arrival passThrough(const Timing &timing, const Arrival &input, Timing &module) {
+    module.input_to_register = max(module.input_to_register, extend(input.from_input, timing.input_to_register));
+    module.register_to_register = max({module.register_to_register, timing.register_to_register,
+                                       extend(input.from_register, timing.input_to_register)});
+    Arrival output;
+    output.from_input = extend(input.from_input, timing.input_to_output);
+    output.from_register = max(extend(input.from_register, timing.input_to_output), timing.register_to_output);
+    return output;
+}
+
+// Функция для записи сигнала в регистр модуля module
+Arrival registerSignal(const Arrival &input, Timing &module) {
+    module.input_to_register = max(module.input_to_register, input.from_input);
+    module.register_to_register = max(module.register_to_register, input.from_register);
+    return {NO_PATH, 0};
+}
+
+// Оценка сумматора разрядности w в архитектуре style; вычитатель дополнительно инвертирует вычитаемое
+// Полный сумматор - пять вентилей; на ПЛИС бит сумматора с цепочкой переноса занимает один LUT,
+// а префиксная ячейка (g, p) - отдельный LUT
+LogicEstimate adderEstimate(int w, AdderStyle style, bool subtract) {
+    LogicEstimate estimate;
+    int levels = static_cast<int>(ceil(log2(static_cast<double>(max(w, 2)))));
+    double prefix_cells = 0;
+    switch (style) {
+        case AdderStyle::Behavioral:
+        case AdderStyle::Ripple:
+            estimate.gates = 5.0 * w;
+            estimate.luts = w;
+            break;
+        case AdderStyle::CarrySelect:
+            // Блоки считаются для обоих значений переноса, результат выбирается мультиплексором
+            estimate.gates = 13.0 * w;
+            estimate.luts = 2.0 * w;
+            break;
+        case AdderStyle::KoggeStone:
+            prefix_cells = max(0.0, static_cast<double>(w) * levels - (pow(2.0, levels) - 1));
+            break;
+        case AdderStyle::BrentKung:
+            prefix_cells = max(0, 2 * w - levels - 2);
+            break;
+        default:
+            prefix_cells = w / 2.0 * levels;
+            break;
+    }
+    if (estimate.gates == 0) {
+        // Сигналы g, p и сумма - три вентиля на бит, префиксная ячейка - еще три
+        estimate.gates = 3.0 * w + 3.0 * prefix_cells;
+        estimate.luts = w + prefix_cells;
+    }
+    if (subtract) {
+        estimate.gates += w;
+    }
+    return estimate;
+}
+
+// Оценка прямого умножителя n x n бит без сумматора adder_{2n}, который дерево сжатия
+// использует как отдельный модуль; плоское умножение включает итоговое сложение
+// n^2 конъюнкций и n^2 - 2n полных сумматоров, как в CostModel::directCost
+// Прямой квадратор складывает n(n + 1) / 2 битов, из которых n(n - 1) / 2 - конъюнкции
+LogicEstimate baseEstimate(int n, BaseMultiplier base, bool square) {
+    LogicEstimate estimate;
+    double bits = square ? n * (n + 1) / 2.0 : static_cast<double>(n) * n;
+    double and_gates = square ? n * (n - 1) / 2.0 : bits;
+    double full_adders = max(0.0, bits - 2 * n);
+    estimate.gates = and_gates + 5.0 * full_adders;
+    estimate.luts = max(full_adders, ceil(bits / 6.0));
+    if (base == BaseMultiplier::Flat) {
+        addLogic(estimate, adderEstimate(2 * n, AdderStyle::Behavioral, false), 1);
+    }
+    return estimate;
+}
+
+// Глубина прямого умножителя в уровнях сумматоров, как у CostModel::directCost: плоская сумма - цепочка
+// из height - 1 сумматоров, дерево сжатия - ceil(log_{3/2}(height)) уровней и итоговый сумматор, где
+// height - высота самого высокого столбца частичных произведений
+int baseLevels(int n, BaseMultiplier base, bool square) {
+    int height = square ? (n + 1) / 2 : n;
+    if (height <= 1) {
+        return 1;
+    }
+    if (base == BaseMultiplier::Flat) {
+        return height - 1;
+    }
+    return static_cast<int>(ceil(log(height) / log(1.5))) + 1;
+}
+
+// Оценка прямого умножителя n x n бит на блоках DSP: блоки покрытия tileDsp, конъюнкции строк в LUT
+// и поведенческие сумматоры разрядности 2n, складывающие произведения блоков и строки
+LogicEstimate dspEstimate(int n, const DspShape &shape) {
+    DspTiling tiling = tileDsp(n, shape);
+    LogicEstimate estimate;
+    estimate.dsps = tiling.blocks;
+    estimate.gates = static_cast<double>(tiling.x_rows) * n + static_cast<double>(tiling.y_rows) * (n - tiling.x_rows);
+    int terms = tiling.blocks + tiling.x_rows + tiling.y_rows;
+    addLogic(estimate, adderEstimate(2 * n, AdderStyle::Behavioral, false), max(0, terms - 1));
+    if (tiling.blocks == 0) {
+        estimate.luts = max(estimate.luts, ceil(estimate.gates / 6.0));
+    }
+    return estimate;
+}
+
+// Оценка разрядов [lo, hi) прямого умножения n x n бит: те же ячейки, что у baseEstimate,
+// но только для частичных произведений a[i] & b[j] с lo <= i + j < hi и сумматора разрядности hi - lo
+LogicEstimate truncatedEstimate(int n, int lo, int hi, BaseMultiplier base) {
+    double bits = 0;
+    for (int s = lo; s < hi && s <= 2 * n - 2; ++s) {
+        bits += min(s, 2 * n - 2 - s) + 1;
+    }
+    double full_adders = max(0.0, bits - 2 * (hi - lo));
+    LogicEstimate estimate;
+    estimate.gates = bits + 5.0 * full_adders;
+    estimate.luts = max(full_adders, ceil(bits / 6.0));
+    if (base == BaseMultiplier::Flat) {
+        addLogic(estimate, adderEstimate(hi - lo, AdderStyle::Behavioral, false), 1);
+    }
+    return estimate;
+}
+
+// Построение сведений о модулях в порядке их вывода генератором
+class ReportBuilder {
+public:
+    ReportBuilder(KaratsubaGenerator &generator, const GeneratorOptions &options)
+        : generator(generator), options(options) {
+    }
+
+    string multiplier(int n);
+    string sequential(int n);
+    string rectangular(int n, int m);
+    string modular(int n);
+    string stream(int n);
+    string low(int n);
+    string high(int n, int t);
+
+    map<string, ModuleInfo> modules;
+    vector<string> order;  // Подмодули раньше использующих их модулей
+
+private:
+    string leaf(const string &name, int width, const LogicEstimate &own, int levels);
+    string adder(int w, bool subtract);
+    Timing addBase(ModuleInfo &info, int n);
+    Timing addTruncated(ModuleInfo &info, int n, int lo, int hi);
+    Arrival addDelayed(ModuleInfo &info, const string &child, int width, int delay);
+    Arrival addCells(ModuleInfo &info, const Netlist &netlist, const string &shared);
+
+    KaratsubaGenerator &generator;
+    const GeneratorOptions &options;
+};
+
+string ReportBuilder::leaf(const string &name, int width, const LogicEstimate &own, int levels) {
+    if (modules.find(name) == modules.end()) {
+        ModuleInfo info;
+        info.width = width;
+        info.own = own;
+        info.timing = combinational(levels);
+        modules[name] = info;
+        order.push_back(name);
+    }
+    return name;
+}
+
+string ReportBuilder::adder(int w, bool subtract) {
+    string name = (subtract ? "subtractor_" : "adder_") + to_string(w);
+    return leaf(name, w, adderEstimate(w, options.adders.select(w), subtract), 1);
+}
+
+// Прямое умножение в теле модуля info; глубина - baseLevels, а на блоках DSP - уровень блоков
+// и цепочка сумматоров, складывающая произведения блоков и строки в LUT
+Timing ReportBuilder::addBase(ModuleInfo &info, int n) {
+    if (options.target != DspTarget::None) {
+        addLogic(info.own, dspEstimate(n, dspShape(options.target)), 1);
+        DspTiling tiling = tileDsp(n, dspShape(options.target));
+        return combinational(max(1, tiling.blocks + tiling.x_rows + tiling.y_rows));
+    }
+    addLogic(info.own, baseEstimate(n, options.base, options.square), 1);
+    if (options.base != BaseMultiplier::Flat) {
+        info.children.push_back({adder(2 * n, false), 1});
+    }
+    return combinational(baseLevels(n, options.base, options.square));
+}
+
+// Разряды [lo, hi) прямого умножения в теле модуля info; глубина - baseLevels для n бит
+Timing ReportBuilder::addTruncated(ModuleInfo &info, int n, int lo, int hi) {
+    addLogic(info.own, truncatedEstimate(n, lo, hi, options.base), 1);
+    if (options.base != BaseMultiplier::Flat) {
+        info.children.push_back({adder(hi - lo, false), 1});
+    }
+    return combinational(baseLevels(n, options.base, false));
+}
+
+// Подмодуль child со входами модуля info, выход которого разрядности width задерживается на delay тактов
+Arrival ReportBuilder::addDelayed(ModuleInfo &info, const string &child, int width, int delay) {
+    info.children.push_back({child, 1});
+    Arrival output = passThrough(modules.at(child).timing, {0, NO_PATH}, info.timing);
+    if (delay > 0) {
+        info.own.registers += static_cast<long long>(width) * delay;
+        output = registerSignal(output, info.timing);
+    }
+    return output;
+}
+
+// Функция для учета ячеек списка соединений в модуле info; возвращает глубину выхода
+// Если задан shared, все умножители - один общий подмодуль последовательного модуля,
+// их результаты записываются в регистры, а входы модуля уже хранятся в регистрах
+Arrival ReportBuilder::addCells(ModuleInfo &info, const Netlist &netlist, const string &shared) {
+    bool folded = !shared.empty();
+    vector<Arrival> arrivals(netlist.nets.size());
+    for (int net : netlist.inputs) {
+        arrivals[net] = folded ? Arrival{NO_PATH, 0} : Arrival{0, NO_PATH};
+    }
+    auto arrival = [&](const vector<Bus> &buses) {
+        Arrival result;
+        for (const Bus &bus : buses) {
+            for (NetlistBit bit : netlist.resolve(bus)) {
+                if (bit.net != CONSTANT_NET) {
+                    result.from_input = max(result.from_input, arrivals[bit.net].from_input);
+                    result.from_register = max(result.from_register, arrivals[bit.net].from_register);
+                }
+            }
+        }
+        return result;
+    };
+
+    for (const NetlistCell &cell : netlist.cells) {
+        if (cell.removed) {
+            continue;
+        }
+        Arrival input = arrival(cell.inputs);
+        Arrival output = input;
+        if (cell.kind == CellKind::Multiplier) {
+            if (folded) {
+                output = registerSignal(passThrough(modules.at(shared).timing, input, info.timing), info.timing);
+            } else if (cell.direct) {
+                output = passThrough(addBase(info, cell.width), input, info.timing);
+            } else {
+                string child = multiplier(cell.width);
+                info.children.push_back({child, 1});
+                output = passThrough(modules.at(child).timing, input, info.timing);
+            }
+        } else if (cell.kind == CellKind::Adder || cell.kind == CellKind::Subtractor) {
+            string child = adder(cell.width, cell.kind == CellKind::Subtractor);
+            info.children.push_back({child, 1});
+            output = passThrough(combinational(1), input, info.timing);
+        } else if (cell.kind == CellKind::CarrySave) {
+            LogicEstimate row;
+            row.gates = 5.0 * cell.width;
+            row.luts = cell.width;
+            info.children.push_back({leaf("csa_" + to_string(cell.width), cell.width, row, 0), 1});
+        } else if (cell.kind == CellKind::Invert) {
+            info.own.gates += cell.width;
+        } else if (cell.kind == CellKind::Delay && !folded) {
+            info.own.registers += static_cast<long long>(cell.width) * cell.cycles;
+            output = registerSignal(input, info.timing);
+        }
+        for (int net : cell.outputs) {
+            arrivals[net] = output;
+        }
+    }
+    return arrival({netlist.output});
+}
+
+// Функция для сбора сведений о модуле karatsuba_mult_n или karatsuba_square_n и его подмодулях
+string ReportBuilder::multiplier(int n) {
+    string name = generator.karatsubaName(n);
+    if (modules.find(name) != modules.end()) {
+        return name;
+    }
+
+    ModuleInfo info;
+    info.width = n;
+    info.multiplier = true;
+    Arrival output;
+    if (generator.isDirect(n)) {
+        output = passThrough(addBase(info, n), {0, NO_PATH}, info.timing);
+    } else {
+        output = addCells(info, generator.moduleNetlist(n), "");
+    }
+    if (generator.isRegistered(n)) {
+        info.own.registers += 2 * n;
+        output = registerSignal(output, info.timing);
+    }
+    info.timing.input_to_output = output.from_input;
+    info.timing.register_to_output = output.from_register;
+
+    modules[name] = info;
+    order.push_back(name);
+    return name;
+}
+
+// Функция для сбора сведений о модуле karatsuba_seq_n и его подмодулях
+string ReportBuilder::sequential(int n) {
+    string name = "karatsuba_seq_" + to_string(n);
+    if (modules.find(name) != modules.end()) {
+        return name;
+    }
+
+    ModuleInfo info;
+    info.width = n;
+    info.multiplier = true;
+    // Регистры операндов и результата, sub_start и done
+    info.own.registers = 4 * n + 2;
+    Arrival output;
+    if (generator.isFolded(n)) {
+        KaratsubaSplit split = splitKaratsuba(n);
+        int s_width = split.s_width;
+        string shared = generator.isFolded(s_width) ? sequential(s_width) : multiplier(s_width);
+        info.children.push_back({shared, 1});
+        // Состояние автомата, регистры частичных произведений и ожидание общего подмодуля
+        info.own.registers += 3 + 2 * split.m + 2 * split.n_minus_m + split.p_width;
+        if (!generator.isFolded(s_width)) {
+            info.own.registers += generator.latency(s_width);
+        }
+        // Мультиплексоры 3:1 операндов общего подмодуля
+        info.own.gates += 2 * 6.0 * s_width;
+        info.own.luts += 2 * s_width;
+        output = addCells(info, generator.moduleNetlist(n, false), shared);
+    } else {
+        string child = multiplier(n);
+        info.children.push_back({child, 1});
+        info.own.registers += 1 + generator.latency(n);
+        output = passThrough(modules.at(child).timing, {NO_PATH, 0}, info.timing);
+    }
+    registerSignal(output, info.timing);
+    info.timing.input_to_register = max(info.timing.input_to_register, 0);
+    info.timing.input_to_output = NO_PATH;
+    info.timing.register_to_output = 0;
+
+    modules[name] = info;
+    order.push_back(name);
+    return name;
+}
+
+// Функция для сбора сведений о прямоугольном модуле karatsuba_mult_n_m и его подмодулях
+// Части широкого операнда умножаются на узкий операнд, выровненные задержками произведения
+// складываются одним сумматором adder_{n+m}
+string ReportBuilder::rectangular(int n, int m) {
+    if (n == m) {
+        return multiplier(n);
+    }
+    string name = multiplierName(n, m);
+    if (modules.find(name) != modules.end()) {
+        return name;
+    }
+
+    RectangularSplit split = splitRectangular(n, m);
+    ModuleInfo info;
+    info.width = n;
+    info.multiplier = true;
+    int level_latency = generator.latency(n, m);
+    Arrival rows;
+    for (int i = 0; i < split.parts; ++i) {
+        int width = i + 1 < split.parts ? split.narrow : split.last_width;
+        string child = rectangular(width, split.narrow);
+        info.children.push_back({child, 1});
+        Arrival output = passThrough(modules.at(child).timing, {0, NO_PATH}, info.timing);
+        int delay = level_latency - generator.latency(width, split.narrow);
+        if (delay > 0) {
+            info.own.registers += static_cast<long long>(width + split.narrow) * delay;
+            output = registerSignal(output, info.timing);
+        }
+        rows.from_input = max(rows.from_input, output.from_input);
+        rows.from_register = max(rows.from_register, output.from_register);
+    }
+    info.children.push_back({adder(n + m, false), 1});
+    Arrival output = passThrough(combinational(1), rows, info.timing);
+    info.timing.input_to_output = output.from_input;
+    info.timing.register_to_output = output.from_register;
+
+    modules[name] = info;
+    order.push_back(name);
+    return name;
+}
+
+// Функция для сбора сведений о модуле младшей половины karatsuba_low_n и его подмодулях
+// Полное произведение z0 и две младшие половины разрядности n/2 складываются двумя сумматорами adder_{n/2}
+string ReportBuilder::low(int n) {
+    string name = KaratsubaGenerator::lowName(n);
+    if (modules.find(name) != modules.end()) {
+        return name;
+    }
+
+    ModuleInfo info;
+    info.width = n;
+    info.multiplier = true;
+    Arrival output;
+    if (generator.isDirect(n)) {
+        output = passThrough(addTruncated(info, n, 0, n), {0, NO_PATH}, info.timing);
+    } else {
+        KaratsubaSplit split = splitKaratsuba(n);
+        int level_latency = generator.lowLatency(n);
+        int h = split.n_minus_m;
+        Arrival rows = addDelayed(info, multiplier(h), 2 * h, level_latency - generator.latency(h));
+        string cross = low(split.m);
+        for (int i = 0; i < 2; ++i) {
+            Arrival row = addDelayed(info, cross, split.m, level_latency - generator.lowLatency(split.m));
+            rows = {max(rows.from_input, row.from_input), max(rows.from_register, row.from_register)};
+        }
+        info.children.push_back({adder(split.m, false), 2});
+        output = passThrough(combinational(2), rows, info.timing);
+    }
+    info.timing.input_to_output = output.from_input;
+    info.timing.register_to_output = output.from_register;
+
+    modules[name] = info;
+    order.push_back(name);
+    return name;
+}
+
+// Функция для сбора сведений о модуле старшей половины karatsuba_high_n_t и его подмодулях
+// Слагаемые уровня из highTerms складываются цепочкой сумматоров разрядности 2n - t
+string ReportBuilder::high(int n, int t) {
+    string name = KaratsubaGenerator::highName(n, t);
+    if (modules.find(name) != modules.end()) {
+        return name;
+    }
+
+    ModuleInfo info;
+    info.width = n;
+    info.multiplier = true;
+    Arrival output;
+    if (generator.isDirect(n)) {
+        output = passThrough(addTruncated(info, n, t, 2 * n), {0, NO_PATH}, info.timing);
+    } else {
+        int level_latency = generator.highLatency(n, t);
+        vector<HighTerm> terms = generator.highTerms(n, t);
+        Arrival rows;
+        for (const HighTerm &term : terms) {
+            bool full = term.threshold <= 0;
+            string child = full ? multiplier(term.width) : high(term.width, term.threshold);
+            int term_latency = full ? generator.latency(term.width) : generator.highLatency(term.width, term.threshold);
+            Arrival row = addDelayed(info, child, full ? 2 * term.width : 2 * term.width - term.threshold,
+                                     level_latency - term_latency);
+            rows = {max(rows.from_input, row.from_input), max(rows.from_register, row.from_register)};
+        }
+        int adders = static_cast<int>(terms.size()) - 1;
+        if (adders > 0) {
+            info.children.push_back({adder(2 * n - t, false), adders});
+        }
+        output = passThrough(combinational(adders), rows, info.timing);
+    }
+    info.timing.input_to_output = output.from_input;
+    info.timing.register_to_output = output.from_register;
+
+    modules[name] = info;
+    order.push_back(name);
+    return name;
+}
+
+// Функция для сбора сведений о модульном умножителе montgomery_mult_n или barrett_mult_n
+// Три умножения идут одно за другим; t ждет в линии задержки оценку q * M, затем Монтгомери
+// складывает старшие половины и вычитает M, а Барретт вычитает q * M и параллельно M и 2M
+// q у Монтгомери и q * M у Барретта - модули младшей половины
+string ReportBuilder::modular(int n) {
+    string name = modularName(options.reduction, n);
+    bool barrett = options.reduction == ModularReduction::Barrett;
+    bool fixed = !options.modulus.isZero();
+
+    ModuleInfo info;
+    info.width = n;
+    info.multiplier = true;
+    string product = multiplier(n);
+    string quotient = barrett ? multiplier(n + 1) : low(n);
+    string quotient_product = barrett ? low(n + 2) : product;
+    if (barrett) {
+        info.children = {{product, 1}, {quotient, 1}, {quotient_product, 1}};
+    } else {
+        info.children = {{product, 2}, {quotient, 1}};
+    }
+    Arrival t = passThrough(modules.at(product).timing, {0, NO_PATH}, info.timing);
+    Arrival q = passThrough(modules.at(quotient).timing, t, info.timing);
+    Arrival qm = passThrough(modules.at(quotient_product).timing, q, info.timing);
+
+    int product_latency = generator.latency(n);
+    int quotient_latency = barrett ? generator.latency(n + 1) : generator.lowLatency(n);
+    int qm_latency = barrett ? generator.lowLatency(n + 2) : generator.latency(n);
+    if (quotient_latency + qm_latency > 0) {
+        info.own.registers += 2LL * n * (quotient_latency + qm_latency);
+        t = registerSignal(t, info.timing);
+    }
+    if (!fixed) {
+        info.own.registers += static_cast<long long>(n) * (product_latency + quotient_latency + qm_latency) +
+                              static_cast<long long>(reductionConstantWidth(options.reduction, n)) * product_latency;
+    }
+    Arrival joined = {max(t.from_input, qm.from_input), max(t.from_register, qm.from_register)};
+
+    // Выбор результата: мультиплексор 2:1 у Монтгомери и 3:1 у Барретта; у Монтгомери еще проверка t mod 2^n != 0
+    info.own.gates += (barrett ? 6.0 : 3.0) * n + (barrett ? 0 : n);
+    info.own.luts += barrett ? n : n + ceil(n / 6.0);
+    if (barrett) {
+        info.children.push_back({adder(n + 2, true), 3});
+    } else {
+        info.children.push_back({adder(n + 2, false), 1});
+        info.children.push_back({adder(n + 2, true), 1});
+    }
+    Arrival output = passThrough(combinational(2), joined, info.timing);
+    info.timing.input_to_output = output.from_input;
+    info.timing.register_to_output = output.from_register;
+
+    modules[name] = info;
+    order.push_back(name);
+    return name;
+}
+
+// Функция для сбора сведений о потоковой обертке karatsuba_stream_n
+// Входы и выход очереди - регистры, поэтому комбинационного пути от входов до выхода нет
+// Мультиплексор чтения очереди считается деревом 2:1 (4:1 на LUT), счетчики и указатели - инкрементами
+string ReportBuilder::stream(int n) {
+    string name = "karatsuba_stream_" + to_string(n);
+    bool accumulate = options.accumulator_bits > 0;
+    int width = 2 * n + options.accumulator_bits;
+    int depth = generator.streamLatency(n);
+    auto bit_width = [](int value) {
+        int bits = 1;
+        while ((value >> bits) > 0) {
+            bits++;
+        }
+        return bits;
+    };
+    int counter_bits = 2 * bit_width(depth) + 2 * bit_width(depth - 1);
+
+    ModuleInfo info;
+    info.width = n;
+    info.multiplier = true;
+    string core = multiplier(n);
+    info.children.push_back({core, 1});
+    Arrival output = passThrough(modules.at(core).timing, {NO_PATH, 0}, info.timing);
+    if (accumulate) {
+        string acc = adder(width, false);
+        info.children.push_back({acc, 1});
+        output = passThrough(modules.at(acc).timing, output, info.timing);
+        info.own.registers += width;
+    }
+    registerSignal(output, info.timing);
+    info.timing.register_to_output = 0;
+
+    // Входной регистр и буфер skid, линии задержки valid и last, счетчики, указатели и очередь
+    info.own.registers += 2LL * (2 * n + 2) + 2LL * generator.latency(n) + counter_bits +
+                          static_cast<long long>(depth) * (width + 1);
+    info.own.gates += 3.0 * (2 * n + 1) + 3.0 * (depth - 1) * (width + 1) + 5.0 * counter_bits;
+    info.own.luts += (2 * n + 1) + ceil((depth - 1) / 3.0) * (width + 1) + counter_bits;
+
+    modules[name] = info;
+    order.push_back(name);
+    return name;
+}
+
+// Порядок модулей в отчете: умножители, сумматоры, вычитатели, строки сжатия, от больших разрядностей к меньшим
+int moduleRank(const string &name) {
+    const vector<string> prefixes = {"montgomery_mult_", "barrett_mult_", "karatsuba_stream_", "karatsuba_seq_", "karatsuba_mult_", "karatsuba_square_", "karatsuba_low_", "karatsuba_high_", "adder_", "subtractor_", "csa_"};
+    for (size_t i = 0; i < prefixes.size(); ++i) {
+        if (name.compare(0, prefixes[i].size(), prefixes[i]) == 0) {
+            return static_cast<int>(i);
+        }
+    }
+    return static_cast<int>(prefixes.size());
+}
+
+// Выравнивание текста по ширине столбца в символах UTF-8
+string pad(const string &text, size_t width, bool align_left) {
+    size_t length = count_if(text.begin(), text.end(), [](char c) { return (c & 0xC0) != 0x80; });
+    string padding(width > length ? width - length : 0, ' ');
+    return align_left ? text + padding : padding + text;
+}
+
+string formatCount(double value) {
+    return to_string(llround(value));
+}
+
+// Разрядности умножителей уровня, например "50x2 51"
+string formatWidths(const map<int, long long> &widths) {
+    string result;
+    for (const auto &[width, count] : widths) {
+        result += (result.empty() ? "" : " ") + to_string(width) + (count > 1 ? "x" + to_string(count) : "");
+    }
+    return result;
+}
+
+// Число блоков DSP выводится только для отчета с -target
+void printLogicJson(const LogicEstimate &logic, long long count, bool dsp, ostream &out) {
+    out << "\"gates\": " << formatCount(logic.gates * count) << ", \"luts\": " << formatCount(logic.luts * count)
+        << ", \"registers\": " << logic.registers * count;
+    if (dsp) {
+        out << ", \"dsps\": " << logic.dsps * count;
+    }
+}
+
+} // namespace
+
+// Функция построения отчета о схеме умножителя разрядности n
+// Иерархия и разрядности сумматоров берутся у KaratsubaGenerator, поэтому отчет учитывает
+// порог рекурсии, сборку деревом сжатия, оптимизацию списка соединений, конвейер и последовательный режим
+DesignReport buildReport(int n, const GeneratorOptions &options, int m) {
+    GeneratorOptions report_options = options;
+    report_options.cache_dir.clear();
+    ostream null_stream(nullptr);
+    KaratsubaGenerator generator(null_stream, report_options);
+    ReportBuilder builder(generator, report_options);
+
+    DesignReport report;
+    report.n = n;
+    report.m = m > 0 ? m : n;
+    report.sequential = options.fold_levels > 0;
+    if (options.target != DspTarget::None) {
+        report.target = dspTargetName(options.target);
+    }
+    if (options.reduction != ModularReduction::None) {
+        report.top = builder.modular(n);
+        report.latency = generator.modularLatency(n);
+    } else if (options.stream) {
+        report.top = builder.stream(n);
+        report.latency = generator.streamLatency(n);
+    } else if (options.half == ProductHalf::Low) {
+        report.top = builder.low(n);
+        report.latency = generator.lowLatency(n);
+    } else if (options.half == ProductHalf::High) {
+        int threshold = generator.highThreshold(n);
+        report.top = builder.high(n, threshold);
+        report.latency = generator.highLatency(n, threshold);
+    } else {
+        report.top = report.sequential ? builder.sequential(n) : builder.rectangular(n, report.m);
+        report.latency = report.sequential ? generator.cycles(n) : generator.latency(n, report.m);
+    }
+    const Timing &timing = builder.modules.at(report.top).timing;
+    report.depth = max({0, timing.input_to_register, timing.register_to_register,
+                        timing.input_to_output, timing.register_to_output});
+
+    // Число экземпляров: каждый модуль обрабатывается раньше своих подмодулей
+    map<string, long long> instances = {{report.top, 1}};
+    for (auto it = builder.order.rbegin(); it != builder.order.rend(); ++it) {
+        const ModuleInfo &info = builder.modules.at(*it);
+        long long count = instances[*it];
+        for (const auto &[child, child_count] : info.children) {
+            instances[child] += count * child_count;
+        }
+        report.modules.push_back({*it, count, info.own});
+        addLogic(report.total, info.own, count);
+    }
+    sort(report.modules.begin(), report.modules.end(), [&builder](const ModuleReport &a, const ModuleReport &b) {
+        int rank_a = moduleRank(a.name), rank_b = moduleRank(b.name);
+        if (rank_a != rank_b) {
+            return rank_a < rank_b;
+        }
+        return builder.modules.at(a.name).width > builder.modules.at(b.name).width;
+    });
+
+    // Уровни рекурсии: умножители уровня вместе с их сумматорами
+    map<string, long long> current = {{report.top, 1}};
+    for (int level = 0; !current.empty(); ++level) {
+        LevelReport level_report;
+        level_report.level = level;
+        map<string, long long> next;
+        for (const auto &[name, count] : current) {
+            const ModuleInfo &info = builder.modules.at(name);
+            level_report.multipliers += count;
+            level_report.widths[info.width] += count;
+            addLogic(level_report.logic, info.own, count);
+            for (const auto &[child, child_count] : info.children) {
+                const ModuleInfo &child_info = builder.modules.at(child);
+                if (child_info.multiplier) {
+                    next[child] += count * child_count;
+                } else {
+                    level_report.adders += count * child_count;
+                    addLogic(level_report.logic, child_info.own, count * child_count);
+                }
+            }
+        }
+        report.levels.push_back(level_report);
+        current = next;
+    }
+    return report;
+}
+
+// Функция для вывода отчета в виде таблиц
+void printReportText(const DesignReport &report, ostream &out) {
+    out << "Умножитель N=" << report.n << (report.m != report.n ? ", M=" + to_string(report.m) : "") << ", верхний модуль " << report.top << "\n";
+    out << "Критический путь: " << report.depth << " уровней сумматоров"
+        << (report.latency > 0 && !report.sequential ? " на ступень конвейера" : "") << "\n";
+    out << (report.sequential ? "Тактов от start до done: " : "Латентность, тактов: ") << report.latency << "\n";
+    // Столбец блоков DSP выводится только для отчета с -target
+    bool dsp = !report.target.empty();
+    out << "Оценка: " << formatCount(report.total.gates) << " вентилей, " << formatCount(report.total.luts) << " LUT, "
+        << report.total.registers << " бит регистров"
+        << (dsp ? ", " + to_string(report.total.dsps) + " блоков " + report.target : "") << "\n\n";
+
+    out << pad("Модуль", 24, true) << pad("Экземпляров", 14, false) << pad("Вентилей", 14, false)
+        << pad("LUT", 12, false) << pad("Регистров", 12, false) << (dsp ? pad("DSP", 8, false) : "") << "\n";
+    for (const ModuleReport &module : report.modules) {
+        out << pad(module.name, 24, true) << pad(to_string(module.instances), 14, false)
+            << pad(formatCount(module.own.gates * module.instances), 14, false)
+            << pad(formatCount(module.own.luts * module.instances), 12, false)
+            << pad(to_string(module.own.registers * module.instances), 12, false)
+            << (dsp ? pad(to_string(module.own.dsps * module.instances), 8, false) : "") << "\n";
+    }
+    out << "\n";
+
+    out << pad("Уровень", 10, true) << pad("Умножители", 32, true) << pad("Сумматоров", 12, false)
+        << pad("Вентилей", 14, false) << pad("LUT", 12, false) << pad("Регистров", 12, false)
+        << (dsp ? pad("DSP", 8, false) : "") << "\n";
+    for (const LevelReport &level : report.levels) {
+        out << pad(to_string(level.level), 10, true) << pad(formatWidths(level.widths), 32, true)
+            << pad(to_string(level.adders), 12, false) << pad(formatCount(level.logic.gates), 14, false)
+            << pad(formatCount(level.logic.luts), 12, false) << pad(to_string(level.logic.registers), 12, false)
+            << (dsp ? pad(to_string(level.logic.dsps), 8, false) : "") << "\n";
+    }
+}
+
+// Функция для вывода отчетов в формате JSON
+void printReportJson(const vector<DesignReport> &reports, ostream &out) {
+    out << "[\n";
+    for (size_t r = 0; r < reports.size(); ++r) {
+        const DesignReport &report = reports[r];
+        out << "  {\n";
+        out << "    \"n\": " << report.n << ",\n";
+        if (report.m != report.n) {
+            out << "    \"m\": " << report.m << ",\n";
+        }
+        out << "    \"top\": \"" << report.top << "\",\n";
+        if (!report.target.empty()) {
+            out << "    \"target\": \"" << report.target << "\",\n";
+        }
+        out << "    \"depth\": " << report.depth << ",\n";
+        out << "    \"" << (report.sequential ? "cycles" : "latency") << "\": " << report.latency << ",\n";
+        out << "    ";
+        printLogicJson(report.total, 1, !report.target.empty(), out);
+        out << ",\n";
+        out << "    \"modules\": [\n";
+        for (size_t i = 0; i < report.modules.size(); ++i) {
+            const ModuleReport &module = report.modules[i];
+            out << "      {\"name\": \"" << module.name << "\", \"instances\": " << module.instances << ", ";
+            printLogicJson(module.own, module.instances, !report.target.empty(), out);
+            out << "}" << (i + 1 < report.modules.size() ? "," : "") << "\n";
+        }
+        out << "    ],\n";
+        out << "    \"levels\": [\n";
+        for (size_t i = 0; i < report.levels.size(); ++i) {
+            const LevelReport &level = report.levels[i];
+            out << "      {\"level\": " << level.level << ", \"multipliers\": {";
+            bool first = true;
+            for (const auto &[width, count] : level.widths) {
+                out << (first ? "" : ", ") << "\"" << width << "\": " << count;
+                first = false;
+            }
+            out << "}, \"adders\": " << level.adders << ", ";
+            printLogicJson(level.logic, 1, !report.target.empty(), out);
+            out << "}" << (i + 1 < report.levels.size() ? "," : "") << "\n";
+        }
+        out << "    ]\n";
+        out << "  }" << (r + 1 < reports.size() ? "," : "") << "\n";
+    }
+    out << "]\n";
+}
@@ -0,0 +1,58 @@
+#ifndef REPORT_H
+#define REPORT_H
+
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "verilog_generator.h"
+using namespace std;
+
+// Оценка логики: вентили с двумя входами, LUT с шестью входами, биты регистров и блоки DSP
+struct LogicEstimate {
+    double gates = 0;
+    double luts = 0;
+    long long registers = 0;
+    long long dsps = 0;
+};
+
+// Модуль иерархии: число экземпляров во всей схеме и логика одного экземпляра без подмодулей
+struct ModuleReport {
+    string name;
+    long long instances = 0;
+    LogicEstimate own;
+};
+
+// Вклад уровня рекурсии: умножители уровня, их собственная логика и сумматоры
+struct LevelReport {
+    int level = 0;
+    map<int, long long> widths;  // Число умножителей уровня по разрядностям
+    long long multipliers = 0;
+    long long adders = 0;        // Экземпляры adder_k, subtractor_k и csa_k
+    LogicEstimate logic;
+};
+
+// Отчет о схеме умножителя n x m бит
+struct DesignReport {
+    int n = 0;
+    int m = 0;                     // Разрядность второго операнда; m == n для квадратного умножителя
+    string top;                    // Имя верхнего модуля
+    int depth = 0;                 // Критический путь в уровнях сумматоров; для конвейера - самая длинная ступень
+    int latency = 0;               // Латентность в тактах; для последовательного режима - такты от start до done
+    bool sequential = false;       // true для последовательного режима
+    string target;                 // Блок DSP прямых умножителей; пустая строка - умножители из LUT
+    LogicEstimate total;
+    vector<ModuleReport> modules;  // Модули от верхнего к листовым
+    vector<LevelReport> levels;
+};
+
+// Функция построения отчета по той же иерархии, которую выводит KaratsubaGenerator
+// Параметры конвейера и последовательного режима должны быть уже пересчитаны для n
+// m > 0 и m != n задают прямоугольный умножитель karatsuba_mult_n_m
+DesignReport buildReport(int n, const GeneratorOptions &options, int m = 0);
+
+void printReportText(const DesignReport &report, ostream &out);
+// Отчеты для нескольких разрядностей выводятся одним массивом JSON
+void printReportJson(const vector<DesignReport> &reports, ostream &out);
+
+#endif
@@ -2,93 +2,1478 @@
 #include <string>
 #include <sstream>
 #include <set>
+#include <vector>
 
 using namespace std;
 
-// Глобальные переменные для хранения определений модулей
-string module_definitions = "";           // Для хранения всех определений модулей
-set<int> generated_modules;               // Множество уже сгенерированных модулей
-set<int> adder_sizes;                     // Множество размеров сумматоров
-set<int> subtractor_sizes;                // Множество размеров вычитателей
-
 // Функция для генерации Verilog-модуля умножителя Карацубы
+// Каждый модуль записывается в out ровно один раз, сразу после своих зависимостей,
+// поэтому время генерации линейно по размеру результата, а память не зависит от него
+void generateVerilogModule(int n, ostream &out) {
+    KaratsubaGenerator generator(out);
+    generator.generate(n);
+}
+
+// Функция для генерации Verilog-модуля умножителя Карацубы в виде строки
 string generateVerilogModule(int n) {
-    int module_count = 0; // Счетчик модулей для генерации уникальных имен
-    module_definitions = ""; // Очистка определений модулей
-    generated_modules.clear(); // Очистка множества сгенерированных модулей
-    adder_sizes.clear();       // Очистка размеров сумматоров
-    subtractor_sizes.clear();  // Очистка размеров вычитателей
+    stringstream ss;
+    generateVerilogModule(n, ss);
+    return ss.str();
+}
+
+// Функция для вычисления параметров разбиения уровня Карацубы
+KaratsubaSplit splitKaratsuba(int n) {
+    KaratsubaSplit split;
+    split.n = n;
+    split.m = n / 2;
+    split.n_minus_m = n - split.m;
+    split.s_width = max(split.m, split.n_minus_m) + 1;
+    split.p_width = 2 * split.s_width;
+    split.product_width = 2 * n;
+    // При s_width >= n рекурсия для p не уменьшает разрядность, поэтому p вычисляется напрямую
+    split.p_recursive = split.s_width < n;
+    return split;
+}
+
+// Функция для вычисления параметров разбиения уровня Toom-3
+// Старшая часть может быть короче младших; уровень допустим, если самое широкое произведение
+// x(2) * y(2) разрядности k + 3 уже n
+ToomSplit splitToom3(int n) {
+    ToomSplit split;
+    split.n = n;
+    split.k = (n + 2) / 3;
+    split.high = n - 2 * split.k;
+    split.sum_width = split.k + 2;
+    split.point_width = split.k + 3;
+    // x(2) * y(2) < 49 * 2^(2k): значения до деления на 2 помещаются в 2k + 6 бит
+    split.interpolation_width = 2 * split.k + 6;
+    // c2 = x0 * y2 + x1 * y1 + x2 * y0 < 3 * 2^(2k)
+    split.coefficient_width = 2 * split.k + 2;
+    split.product_width = 2 * n;
+    split.valid = split.high >= 1 && split.point_width < n;
+    return split;
+}
+
+// Версия формата генерируемых модулей; увеличивается при любом изменении их текста,
+// чтобы не использовать устаревшие модули из дискового кэша
+const string GENERATOR_VERSION = "1";
+
+// Ключ параметров, влияющих на текст модулей; используется для кэширования
+string GeneratorOptions::key() const {
+    string key = "version=" + GENERATOR_VERSION;
+    if (auto_cutoff) {
+        key += ";cutoff=auto;optimize=" + optimizationGoalName(goal);
+    } else {
+        key += ";cutoff=" + to_string(cutoff);
+    }
+    if (base != BaseMultiplier::Flat) {
+        key += ";base=" + baseMultiplierName(base);
+    }
+    if (target != DspTarget::None) {
+        key += ";target=" + dspTargetName(target);
+    }
+    if (!adders.key().empty()) {
+        key += ";adder=" + adders.key();
+    }
+    if (carry_save) {
+        key += ";csa";
+    }
+    if (optimize_netlist) {
+        key += ";netlist";
+    }
+    if (pipeline_every > 0) {
+        key += ";pipeline_every=" + to_string(pipeline_every);
+    }
+    if (fold_levels > 0) {
+        key += ";fold_min_width=" + to_string(fold_min_width);
+    }
+    if (parameterized) {
+        key += ";parameterized";
+    }
+    if (toom_auto) {
+        key += ";toom3=auto";
+    } else if (toom_min_width > 0) {
+        key += ";toom3=" + to_string(toom_min_width);
+    }
+    return key;
+}
+
+// Функция полного ключа параметров для манифеста папки модулей
+string GeneratorOptions::manifestKey() const {
+    string manifest = key();
+    if (pipeline_stages > 0) {
+        manifest += ";pipeline_stages=" + to_string(pipeline_stages);
+    }
+    if (fold_levels > 0) {
+        manifest += ";fold_levels=" + to_string(fold_levels);
+    }
+    if (square) {
+        manifest += ";square";
+    }
+    if (reduction != ModularReduction::None) {
+        manifest += ";modular=" + modularReductionName(reduction);
+        if (!modulus.isZero()) {
+            manifest += ";modulus=" + modulus.toHex();
+        }
+    }
+    if (half != ProductHalf::Full) {
+        manifest += half == ProductHalf::Low ? ";low_half" : ";high_half;guard_bits=" + to_string(guard_bits);
+    }
+    if (stream) {
+        manifest += ";stream;accumulate=" + to_string(accumulator_bits);
+    }
+    return manifest;
+}
+
+// Пересчет числа ступеней конвейера в интервал между регистрами для умножителя разрядности n
+// Регистры ставятся на выходах модулей высоты k-1, 2k-1, ..., поэтому умножитель высоты H
+// получает floor((H + 1) / k) ступеней; выбирается наименьший k, дающий не больше pipeline_stages
+void GeneratorOptions::resolvePipelineStages(int n) {
+    if (pipeline_stages <= 0) {
+        return;
+    }
+    ostream null_stream(nullptr);
+    int levels = KaratsubaGenerator(null_stream, *this).height(n) + 1;
+    pipeline_every = max(1, (levels + pipeline_stages - 1) / pipeline_stages);
+}
+
+// Пересчет числа уровней последовательного режима в порог разрядности для умножителя разрядности n
+// Уровни идут по цепочке n -> s_width -> ..., поскольку общий подмодуль уровня имеет разрядность s_width;
+// порог вместо числа уровней нужен, чтобы модуль одной разрядности был одинаковым в любой библиотеке
+void GeneratorOptions::resolveFolding(int n) {
+    if (fold_levels <= 0) {
+        return;
+    }
+    GeneratorOptions all_levels = *this;
+    all_levels.fold_min_width = 0;
+    ostream null_stream(nullptr);
+    KaratsubaGenerator generator(null_stream, all_levels);
+
+    int width = n;
+    for (int level = 0; level < fold_levels && generator.isFolded(width); ++level) {
+        width = splitKaratsuba(width).s_width;
+    }
+    fold_min_width = width;
+}
+
+KaratsubaGenerator::KaratsubaGenerator(ostream &out, const GeneratorOptions &options)
+    : out(out), options(options),
+      cost_model(options.goal, options.square, options.toom_auto ? 0 : options.toom_min_width, options.toom_auto,
+                 options.base) {
+    if (!options.cache_dir.empty()) {
+        cache = make_unique<ModuleCache>(options.cache_dir, options.key());
+    }
+}
+
+// Разбиение широкого операнда прямоугольного умножителя n x m на части разрядности узкого
+RectangularSplit splitRectangular(int n, int m) {
+    RectangularSplit split;
+    split.wide = max(n, m);
+    split.narrow = min(n, m);
+    split.parts = (split.wide + split.narrow - 1) / split.narrow;
+    split.last_width = split.wide - (split.parts - 1) * split.narrow;
+    return split;
+}
+
+string multiplierName(int n, int m) {
+    return "karatsuba_mult_" + to_string(n) + (n == m ? "" : "_" + to_string(m));
+}
+
+// Генерация умножителя разрядности n вместе со всеми еще не выведенными подмодулями
+void KaratsubaGenerator::generate(int n) {
+    if (options.reduction != ModularReduction::None) {
+        generateModularModule(n);
+    } else if (options.stream) {
+        generateStreamModule(n);
+    } else if (options.parameterized) {
+        generateParameterizedModule(n);
+    } else if (options.half == ProductHalf::Low) {
+        generateLowModule(n);
+    } else if (options.half == ProductHalf::High) {
+        generateHighModule(n, highThreshold(n));
+    } else if (options.fold_levels > 0) {
+        generateSequentialModule(n);
+    } else {
+        generateKaratsubaModule(n);
+    }
+}
+
+// Генерация прямоугольного умножителя n x m; при n == m - обычный квадратный умножитель
+void KaratsubaGenerator::generate(int n, int m) {
+    if (n == m) {
+        generate(n);
+    } else {
+        generateRectangularModule(n, m);
+    }
+}
+
+// Функция для генерации модуля сумматора в архитектуре, выбранной для разрядности n, если он еще не был сгенерирован
+void KaratsubaGenerator::emitAdderOnce(int n) {
+    if (adder_sizes.insert(n).second) {
+        AdderStyle style = options.adders.select(n);
+        emitModule("adder_" + to_string(n), [n, style](ostream &module_out) {
+            if (style == AdderStyle::Behavioral) {
+                generateAdderModule(n, module_out);
+            } else {
+                generateStructuralAdderModule(n, style, module_out);
+            }
+            module_out << "\n";
+        });
+    }
+}
+
+// Функция для генерации модуля вычитателя в архитектуре, выбранной для разрядности n, если он еще не был сгенерирован
+void KaratsubaGenerator::emitSubtractorOnce(int n) {
+    if (subtractor_sizes.insert(n).second) {
+        AdderStyle style = options.adders.select(n);
+        emitModule("subtractor_" + to_string(n), [n, style](ostream &module_out) {
+            if (style == AdderStyle::Behavioral) {
+                generateSubtractorModule(n, module_out);
+            } else {
+                generateStructuralSubtractorModule(n, style, module_out);
+            }
+            module_out << "\n";
+        });
+    }
+}
+
+// Функция для генерации модуля строки сжимающих ячеек 3:2, если он еще не был сгенерирован
+void KaratsubaGenerator::emitCarrySaveAdderOnce(int n) {
+    if (csa_sizes.insert(n).second) {
+        emitModule("csa_" + to_string(n), [n](ostream &module_out) {
+            generateCarrySaveAdderModule(n, module_out);
+            module_out << "\n";
+        });
+    }
+}
+
+// Функция для генерации ячеек полного сумматора и полусумматора, если они еще не были сгенерированы
+void KaratsubaGenerator::emitCellsOnce() {
+    if (cells_emitted) {
+        return;
+    }
+    cells_emitted = true;
+    emitModule("full_adder", [](ostream &module_out) {
+        generateFullAdderModule(module_out);
+        module_out << "\n";
+    });
+    emitModule("half_adder", [](ostream &module_out) {
+        generateHalfAdderModule(module_out);
+        module_out << "\n";
+    });
+}
+
+// Функция для вывода модуля блока DSP, если он еще не выведен
+void KaratsubaGenerator::emitDspOnce() {
+    if (dsp_emitted) {
+        return;
+    }
+    dsp_emitted = true;
+    DspShape shape = dspShape(options.target);
+    emitModule(dspModuleName(shape), [shape](ostream &module_out) {
+        generateDspModule(shape, module_out);
+    });
+}
+
+// Функция для вывода определения модуля
+// Если включен кэш, определение берется из него, а новые определения сохраняются в кэш
+void KaratsubaGenerator::emitModule(const string &module_name, const function<void(ostream &)> &write_definition) {
+    if (!cache) {
+        write_definition(out);
+        return;
+    }
+    if (cache->load(module_name, out)) {
+        return;
+    }
+
+    stringstream ss;
+    write_definition(ss);
+    string definition = ss.str();
+    cache->store(module_name, definition);
+    out << definition;
+}
+
+string KaratsubaGenerator::karatsubaName(int n) const {
+    return (options.square ? "karatsuba_square_" : "karatsuba_mult_") + to_string(n);
+}
+
+// Функция для генерации модуля Карацубы заданной разрядности n
+// Квадратор на каждом уровне возводит в квадрат x1, x0 и s1 = x1 + x0, поэтому ему нужен
+// один вход, одна сумма s1 и прямые квадраторы с вдвое меньшим числом частичных произведений
+void KaratsubaGenerator::generateKaratsubaModule(int n) {
+    string module_name = karatsubaName(n);
+
+    // Проверка, был ли уже сгенерирован модуль для данного n
+    if (generated_modules.find(n) != generated_modules.end()) {
+        return;
+    }
+    generated_modules.insert(n); // Добавляем n в множество сгенерированных модулей
+
+    // Подмодули выводятся раньше использующего их модуля, поэтому верхний модуль будет последним
+    generateKaratsubaDependencies(n);
+
+    emitModule(module_name, [this, n, &module_name](ostream &module_out) {
+        bool pipelined = options.pipeline_every > 0;
+        bool registered = isRegistered(n);
+        string result = registered ? "product_comb" : "product";
+
+        // Начало определения модуля
+        module_out << "module " << module_name << "(\n";
+        if (pipelined) {
+            module_out << "    input clk,\n";
+            module_out << "    input rst,\n";
+        }
+        module_out << "    input [" << n - 1 << ":0] x,\n";
+        if (!options.square) {
+            module_out << "    input [" << n - 1 << ":0] y,\n";
+        }
+        module_out << "    output [" << 2 * n - 1 << ":0] product\n";
+        module_out << ");\n\n";
+
+        if (registered) {
+            module_out << "wire [" << 2 * n - 1 << ":0] " << result << ";\n";
+        }
+
+        if (isDirect(n)) {
+            // Прямое умножение без дальнейшей рекурсии
+            generateBaseMultiplication(n, "x", options.square ? "x" : "y", result, module_out);
+        } else if (usesNetlist(n)) {
+            // Тело модуля из оптимизированного списка соединений
+            Netlist &netlist = netlists[n];
+            netlist.output_name = result;
+            printNetlist(netlist, [this](const NetlistCell &cell, const string &a, const string &b,
+                                         const string &product, ostream &out) {
+                if (cell.direct) {
+                    generateBaseMultiplication(cell.width, a, b, product, out);
+                } else {
+                    generateKaratsubaModuleCall(cell.width, a, b, product, cell.name, out);
+                }
+            }, module_out);
+        } else {
+            int module_count = 0;
+            // Генерация тела модуля
+            generateKaratsubaModuleBody(n, module_count, result, module_out);
+        }
+
+        // Выходной регистр ступени конвейера
+        if (registered) {
+            module_out << "\n";
+            string product_reg = generateDelayLine(result, 2 * n, 1, module_out);
+            module_out << "assign product = " << product_reg << ";\n";
+        }
+
+        // Конец определения модуля
+        module_out << "endmodule\n\n";
+    });
+    netlists.erase(n);
+}
+
+// Функция для генерации всех модулей, от которых зависит модуль Карацубы разрядности n
+void KaratsubaGenerator::generateKaratsubaDependencies(int n) {
+    if (isDirect(n)) {
+        generateBaseDependencies(n); // Прямое умножение использует только ячейки дерева сжатия
+        return;
+    }
+
+    if (usesNetlist(n)) {
+        // После оптимизации разрядности сумматоров и вычитателей известны только по списку соединений
+        Netlist &netlist = netlists[n];
+        buildKaratsubaNetlist(n, netlist);
+        if (options.optimize_netlist) {
+            netlist.optimize();
+        }
+        for (const NetlistCell &cell : netlist.cells) {
+            if (cell.removed) {
+                continue;
+            }
+            if (cell.kind == CellKind::Multiplier) {
+                if (cell.direct) {
+                    generateBaseDependencies(cell.width);
+                } else {
+                    generateKaratsubaModule(cell.width);
+                }
+            } else if (cell.kind == CellKind::Adder) {
+                emitAdderOnce(cell.width);
+            } else if (cell.kind == CellKind::Subtractor) {
+                emitSubtractorOnce(cell.width);
+            } else if (cell.kind == CellKind::CarrySave) {
+                emitCarrySaveAdderOnce(cell.width);
+            }
+        }
+        return;
+    }
+
+    KaratsubaSplit split = splitKaratsuba(n);
+    generateKaratsubaModule(split.m);
+    generateKaratsubaModule(split.n_minus_m);
+    emitAdderOnce(split.s_width);
+    if (split.p_recursive) {
+        generateKaratsubaModule(split.s_width);
+    } else {
+        generateBaseDependencies(split.s_width);
+    }
+    generateRecombinationDependencies(split);
+}
+
+// Функция выбора прямого умножения вместо рекурсии для разрядности n
+// При n <= 2 разбиение не уменьшает задачу, поэтому такие разрядности всегда умножаются напрямую
+// С блоками DSP умножение прямое, если покрытие блоками занимает их не больше, чем три подмодуля уровня Карацубы;
+// при равенстве прямое умножение выигрывает, потому что не требует сумматоров уровня
+bool KaratsubaGenerator::isDirect(int n) {
+    if (n <= 2 || n <= options.cutoff) {
+        return true;
+    }
+    if (options.target != DspTarget::None) {
+        KaratsubaSplit split = splitKaratsuba(n);
+        DspShape shape = dspShape(options.target);
+        int recursive_blocks = dspBlocks(split.m) + dspBlocks(split.n_minus_m) +
+                               (split.p_recursive ? dspBlocks(split.s_width) : tileDsp(split.s_width, shape).blocks);
+        return tileDsp(n, shape).blocks <= recursive_blocks;
+    }
+    return options.auto_cutoff && cost_model.preferDirect(n);
+}
+
+// Функция подсчета блоков DSP умножителя разрядности n: покрытие блоками или сумма по подмодулям уровня
+int KaratsubaGenerator::dspBlocks(int n) {
+    if (options.target == DspTarget::None) {
+        return 0;
+    }
+    auto it = dsp_blocks.find(n);
+    if (it != dsp_blocks.end()) {
+        return it->second;
+    }
+    int blocks = 0;
+    if (isDirect(n)) {
+        blocks = tileDsp(n, dspShape(options.target)).blocks;
+    } else {
+        KaratsubaSplit split = splitKaratsuba(n);
+        blocks = dspBlocks(split.m) + dspBlocks(split.n_minus_m) +
+                 (split.p_recursive ? dspBlocks(split.s_width) : tileDsp(split.s_width, dspShape(options.target)).blocks);
+    }
+    dsp_blocks[n] = blocks;
+    return blocks;
+}
+
+// Функция выбора Toom-3 для уровня разрядности n: начиная с toom_min_width или по модели стоимости
+bool KaratsubaGenerator::isToom(int n) {
+    if (isDirect(n) || !splitToom3(n).valid) {
+        return false;
+    }
+    if (options.toom_auto) {
+        return cost_model.preferToom(n);
+    }
+    return options.toom_min_width > 0 && n >= options.toom_min_width;
+}
+
+// Разрядности подмодулей уровня n: z2, z0 и p для Карацубы или пять произведений Toom-3
+vector<int> KaratsubaGenerator::childWidths(int n) {
+    if (isToom(n)) {
+        ToomSplit split = splitToom3(n);
+        return {split.k, split.high, split.sum_width, split.point_width};
+    }
+    KaratsubaSplit split = splitKaratsuba(n);
+    vector<int> widths = {split.m, split.n_minus_m};
+    if (split.p_recursive) {
+        widths.push_back(split.s_width);
+    }
+    return widths;
+}
+
+// Высота модуля разрядности n в дереве рекурсии: 0 для прямого умножения,
+// иначе на единицу больше максимальной высоты подмодулей
+int KaratsubaGenerator::height(int n) {
+    if (isDirect(n)) {
+        return 0;
+    }
+    auto it = heights.find(n);
+    if (it != heights.end()) {
+        return it->second;
+    }
+
+    int child_height = 0;
+    for (int width : childWidths(n)) {
+        child_height = max(child_height, height(width));
+    }
+    heights[n] = child_height + 1;
+    return child_height + 1;
+}
+
+// true, если выход модуля разрядности n регистрируется: регистры ставятся каждые
+// pipeline_every уровней рекурсии, начиная снизу
+bool KaratsubaGenerator::isRegistered(int n) {
+    int every = options.pipeline_every;
+    return every > 0 && height(n) % every == every - 1;
+}
+
+// Латентность модуля разрядности n в тактах
+// Результаты подмодулей выравниваются по самому медленному из них, поэтому латентность
+// равна максимальной латентности подмодулей плюс выходной регистр, если он есть
+int KaratsubaGenerator::latency(int n) {
+    auto it = latencies.find(n);
+    if (it != latencies.end()) {
+        return it->second;
+    }
+
+    int child_latency = 0;
+    if (!isDirect(n)) {
+        for (int width : childWidths(n)) {
+            child_latency = max(child_latency, latency(width));
+        }
+    }
+    latencies[n] = child_latency + (isRegistered(n) ? 1 : 0);
+    return latencies[n];
+}
+
+// Латентность прямоугольного модуля: произведения частей выравниваются по самому медленному
+int KaratsubaGenerator::latency(int n, int m) {
+    if (n == m) {
+        return latency(n);
+    }
+    auto it = rectangular_latencies.find({n, m});
+    if (it != rectangular_latencies.end()) {
+        return it->second;
+    }
+    RectangularSplit split = splitRectangular(n, m);
+    int result = max(latency(split.narrow), latency(split.last_width, split.narrow));
+    rectangular_latencies[{n, m}] = result;
+    return result;
+}
+
+// Латентность потоковой обертки: входной регистр, умножитель и запись в выходную очередь
+int KaratsubaGenerator::streamLatency(int n) {
+    return latency(n) + 2;
+}
+
+// Латентность модуля младшей половины: полное произведение z0 и младшие половины x1 * y0 и x0 * y1
+// выравниваются по самому медленному из них, собственного регистра у модуля нет
+int KaratsubaGenerator::lowLatency(int n) {
+    if (isDirect(n)) {
+        return 0;
+    }
+    KaratsubaSplit split = splitKaratsuba(n);
+    return max(latency(split.n_minus_m), lowLatency(split.m));
+}
+
+// Латентность модуля старшей половины: максимальная латентность его подмодулей
+int KaratsubaGenerator::highLatency(int n, int t) {
+    auto it = high_latencies.find({n, t});
+    if (it != high_latencies.end()) {
+        return it->second;
+    }
+
+    int result = 0;
+    if (!isDirect(n)) {
+        for (const HighTerm &term : highTerms(n, t)) {
+            result = max(result, term.threshold <= 0 ? latency(term.width) : highLatency(term.width, term.threshold));
+        }
+    }
+    high_latencies[{n, t}] = result;
+    return result;
+}
+
+string KaratsubaGenerator::lowName(int n) {
+    return "karatsuba_low_" + to_string(n);
+}
+
+string KaratsubaGenerator::highName(int n, int t) {
+    return "karatsuba_high_" + to_string(n) + "_" + to_string(t);
+}
+
+// Подмодули уровня модуля старшей половины (n, t): x = x1 * 2^h + x0, h = n - n/2
+// x * y = x1 * y1 * 2^(2h) + (x1 * y0 + x0 * y1) * 2^h + x0 * y0; порог каждого слагаемого - t минус его сдвиг
+// Разность p - z2 - z0 Карацубы нельзя усечь снизу, поэтому уровень с порогом t > 0 состоит из четырех
+// произведений; x1 и y1 в перекрестных слагаемых дополняются нулем до h бит. Слагаемые, у которых
+// все частичные произведения легче 2^t (порог не меньше 2 * width - 1), отбрасываются целиком
+vector<HighTerm> KaratsubaGenerator::highTerms(int n, int t) {
+    KaratsubaSplit split = splitKaratsuba(n);
+    int m = split.m;
+    int h = split.n_minus_m;
+    string x1 = "x[" + to_string(n - 1) + ":" + to_string(h) + "]";
+    string y1 = "y[" + to_string(n - 1) + ":" + to_string(h) + "]";
+    string x0 = "x[" + to_string(h - 1) + ":0]";
+    string y0 = "y[" + to_string(h - 1) + ":0]";
+    string x1_padded = m < h ? "{1'b0, " + x1 + "}" : x1;
+    string y1_padded = m < h ? "{1'b0, " + y1 + "}" : y1;
+
+    vector<HighTerm> terms = {
+        {m, t - 2 * h, 2 * h, x1, y1, "z2"},
+        {h, t - h, h, x1_padded, y0, "c1"},
+        {h, t - h, h, x0, y1_padded, "c2"},
+        {h, t, 0, x0, y0, "z0"},
+    };
+    vector<HighTerm> result;
+    for (const HighTerm &term : terms) {
+        if (term.threshold < 2 * term.width - 1) {
+            result.push_back(term);
+        }
+    }
+    return result;
+}
+
+// Граница ошибки модуля старшей половины: сумма отброшенных частичных произведений при операндах из единиц
+// У прямого умножения отброшены a[i] & b[j] с i + j < t, у рекурсивного - ошибки подмодулей с их сдвигами
+// и целиком отброшенные слагаемые
+BigUint KaratsubaGenerator::highErrorBound(int n, int t) {
+    if (t <= 0) {
+        return BigUint();
+    }
+    if (t >= 2 * n - 1) {
+        BigUint all_ones = BigUint::allOnes(n);
+        return all_ones * all_ones;
+    }
+    auto it = high_error_bounds.find({n, t});
+    if (it != high_error_bounds.end()) {
+        return it->second;
+    }
+
+    BigUint bound;
+    if (isDirect(n)) {
+        // Столбец веса 2^s содержит min(s, 2n - 2 - s) + 1 частичных произведений
+        for (int s = 0; s < t; ++s) {
+            bound = bound + (BigUint(min(s, 2 * n - 2 - s) + 1) << s);
+        }
+    } else {
+        KaratsubaSplit split = splitKaratsuba(n);
+        int h = split.n_minus_m;
+        bound = (highErrorBound(split.m, t - 2 * h) << (2 * h)) + (highErrorBound(h, t - h) << (h + 1)) +
+                highErrorBound(h, t);
+    }
+    high_error_bounds[{n, t}] = bound;
+    return bound;
+}
+
+// Порог верхнего модуля старшей половины: n минус защитные биты
+// Без явного числа защитных битов выбирается наименьшее, при котором ошибка меньше 2^n, то есть
+// старшие n бит результата меньше точных не больше чем на единицу
+int KaratsubaGenerator::highThreshold(int n) {
+    if (options.guard_bits >= 0) {
+        return n - options.guard_bits;
+    }
+    BigUint limit = BigUint(1) << n;
+    int guard_bits = 0;
+    while (guard_bits + 1 < n && !(highErrorBound(n, n - guard_bits) < limit)) {
+        guard_bits++;
+    }
+    return n - guard_bits;
+}
+
+// Латентность модульного умножителя: три умножения идут одно за другим, редукция комбинационная
+// У Монтгомери q - младшая половина n x n бит, у Барретта оценка частного - полное произведение
+// (n + 1) x (n + 1) бит, а q * M - младшая половина (n + 2) x (n + 2) бит
+int KaratsubaGenerator::modularLatency(int n) {
+    if (options.reduction == ModularReduction::Barrett) {
+        return latency(n) + latency(n + 1) + lowLatency(n + 2);
+    }
+    return 2 * latency(n) + lowLatency(n);
+}
+
+// true, если модуль разрядности n вычисляет z0, z2 и p по очереди на одном подмодуле разрядности s_width
+// Уровни с прямым умножением или без уменьшения разрядности p не сворачиваются
+bool KaratsubaGenerator::isFolded(int n) {
+    return options.fold_levels > 0 && n > options.fold_min_width && !isDirect(n) && !isToom(n) &&
+           splitKaratsuba(n).p_recursive;
+}
+
+// Число тактов от приема start до установки done у модуля karatsuba_seq_n
+// Свернутый уровень трижды ждет общий подмодуль и тратит еще такт на сборку результата;
+// несвернутая разрядность ждет комбинационный или конвейерный karatsuba_mult_n
+int KaratsubaGenerator::cycles(int n) {
+    if (!isFolded(n)) {
+        return latency(n) + 1;
+    }
+    int s_width = splitKaratsuba(n).s_width;
+    int product_cycles = isFolded(s_width) ? cycles(s_width) + 2 : latency(s_width) + 1;
+    return 3 * product_cycles + 1;
+}
+
+// Функция для генерации последовательного модуля karatsuba_seq_n с сигналами start/done
+// Свернутый модуль хранит операнды и частичные произведения в регистрах и по очереди подает
+// на единственный подмодуль пары (x0, y0), (x1, y1) и (s1, s2); иначе модуль оборачивает karatsuba_mult_n
+void KaratsubaGenerator::generateSequentialModule(int n) {
+    if (!sequential_modules.insert(n).second) {
+        return;
+    }
+
+    bool folded = isFolded(n);
+    KaratsubaSplit split = splitKaratsuba(n);
+    int s_width = split.s_width;
+    if (folded) {
+        if (isFolded(s_width)) {
+            generateSequentialModule(s_width);
+        } else {
+            generateKaratsubaModule(s_width);
+        }
+        emitAdderOnce(s_width);
+        generateRecombinationDependencies(split);
+    } else {
+        generateKaratsubaModule(n);
+    }
+
+    string module_name = "karatsuba_seq_" + to_string(n);
+    emitModule(module_name, [this, n, folded, &split, &module_name](ostream &module_out) {
+        int m = split.m;
+        int n_minus_m = split.n_minus_m;
+        int s_width = split.s_width;
+
+        // Начало определения модуля
+        module_out << "module " << module_name << "(\n";
+        module_out << "    input clk,\n";
+        module_out << "    input rst,\n";
+        module_out << "    input start,\n";
+        module_out << "    input [" << n - 1 << ":0] x,\n";
+        module_out << "    input [" << n - 1 << ":0] y,\n";
+        module_out << "    output reg [" << 2 * n - 1 << ":0] product,\n";
+        module_out << "    output reg done\n";
+        module_out << ");\n\n";
+
+        // Состояния автомата
+        if (folded) {
+            module_out << "localparam IDLE = 3'd0, Z0 = 3'd1, Z2 = 3'd2, P = 3'd3, FINISH = 3'd4;\n";
+            module_out << "reg [2:0] state;\n\n";
+        } else {
+            module_out << "localparam IDLE = 1'd0, BUSY = 1'd1;\n";
+            module_out << "reg state;\n\n";
+        }
+
+        // Операнды фиксируются по сигналу start и не меняются до done
+        module_out << "reg [" << n - 1 << ":0] x_reg;\n";
+        module_out << "reg [" << n - 1 << ":0] y_reg;\n";
+        module_out << "reg sub_start;\n\n";
+
+        if (folded) {
+            generateOperandSplit(split, "x_reg", "y_reg", module_out);
+            generateOperandSums(split, module_out);
+
+            // Операнды общего подмодуля выбираются по состоянию автомата
+            module_out << "wire [" << s_width - 1 << ":0] sub_x = (state == Z0) ? {{" << (s_width - n_minus_m) << "{1'b0}}, x0} :\n";
+            module_out << "                     (state == Z2) ? {{" << (s_width - m) << "{1'b0}}, x1} : s1;\n";
+            module_out << "wire [" << s_width - 1 << ":0] sub_y = (state == Z0) ? {{" << (s_width - n_minus_m) << "{1'b0}}, y0} :\n";
+            module_out << "                     (state == Z2) ? {{" << (s_width - m) << "{1'b0}}, y1} : s2;\n";
+            generateSharedMultiplierCall(s_width, "sub_x", "sub_y", module_out);
+
+            // Частичные произведения и сборка результата из регистров
+            module_out << "reg [" << 2 * m - 1 << ":0] z2_reg;\n";
+            module_out << "reg [" << 2 * n_minus_m - 1 << ":0] z0_reg;\n";
+            module_out << "reg [" << split.p_width - 1 << ":0] p_reg;\n";
+            module_out << "wire [" << 2 * n - 1 << ":0] product_comb;\n\n";
+            generateRecombination(split, "z2_reg", "z0_reg", "p_reg", "z1", "product_comb", module_out);
+            module_out << "\n";
+        } else {
+            generateSharedMultiplierCall(n, "x_reg", "y_reg", module_out);
+        }
+
+        // Автомат управления; sub_start и done держатся в единице ровно один такт
+        module_out << "always @(posedge clk) begin\n";
+        module_out << "    if (rst) begin\n";
+        module_out << "        state <= IDLE;\n";
+        module_out << "        sub_start <= 0;\n";
+        module_out << "        product <= 0;\n";
+        module_out << "        done <= 0;\n";
+        module_out << "    end else begin\n";
+        module_out << "        sub_start <= 0;\n";
+        module_out << "        done <= 0;\n";
+        module_out << "        case (state)\n";
+        module_out << "            IDLE: if (start) begin\n";
+        module_out << "                x_reg <= x;\n";
+        module_out << "                y_reg <= y;\n";
+        module_out << "                sub_start <= 1;\n";
+        module_out << "                state <= " << (folded ? "Z0" : "BUSY") << ";\n";
+        module_out << "            end\n";
+        if (folded) {
+            module_out << "            Z0: if (sub_done) begin\n";
+            module_out << "                z0_reg <= sub_product[" << 2 * n_minus_m - 1 << ":0];\n";
+            module_out << "                sub_start <= 1;\n";
+            module_out << "                state <= Z2;\n";
+            module_out << "            end\n";
+            module_out << "            Z2: if (sub_done) begin\n";
+            module_out << "                z2_reg <= sub_product[" << 2 * m - 1 << ":0];\n";
+            module_out << "                sub_start <= 1;\n";
+            module_out << "                state <= P;\n";
+            module_out << "            end\n";
+            module_out << "            P: if (sub_done) begin\n";
+            module_out << "                p_reg <= sub_product;\n";
+            module_out << "                state <= FINISH;\n";
+            module_out << "            end\n";
+            module_out << "            FINISH: begin\n";
+            module_out << "                product <= product_comb;\n";
+            module_out << "                done <= 1;\n";
+            module_out << "                state <= IDLE;\n";
+            module_out << "            end\n";
+            module_out << "            default: state <= IDLE;\n";
+        } else {
+            module_out << "            BUSY: if (sub_done) begin\n";
+            module_out << "                product <= sub_product;\n";
+            module_out << "                done <= 1;\n";
+            module_out << "                state <= IDLE;\n";
+            module_out << "            end\n";
+        }
+        module_out << "        endcase\n";
+        module_out << "    end\n";
+        module_out << "end\n";
+
+        // Конец определения модуля
+        module_out << "endmodule\n\n";
+    });
+}
+
+// Функция для генерации прямоугольного модуля karatsuba_mult_n_m (x - n бит, y - m бит, n != m)
+// Широкий операнд делится на части разрядности узкого. Полные части умножаются квадратным
+// модулем Карацубы, старшая неполная часть - прямоугольным модулем меньшей разрядности.
+// Произведения частей с четными номерами не перекрываются, с нечетными - тоже, поэтому они
+// собираются конкатенацией в две строки, которые складываются одним сумматором
+void KaratsubaGenerator::generateRectangularModule(int n, int m) {
+    if (!rectangular_modules.insert({n, m}).second) {
+        return;
+    }
+
+    RectangularSplit split = splitRectangular(n, m);
+    int narrow = split.narrow;
+    int last_width = split.last_width;
+    generateKaratsubaModule(narrow);
+    if (last_width != narrow) {
+        generateRectangularModule(last_width, narrow);
+    }
+    emitAdderOnce(n + m);
+
+    string module_name = multiplierName(n, m);
+    emitModule(module_name, [this, n, m, &split, &module_name](ostream &module_out) {
+        bool pipelined = options.pipeline_every > 0;
+        int narrow = split.narrow;
+        string wide_port = n > m ? "x" : "y";
+        string narrow_port = n > m ? "y" : "x";
+
+        // Начало определения модуля
+        module_out << "module " << module_name << "(\n";
+        if (pipelined) {
+            module_out << "    input clk,\n";
+            module_out << "    input rst,\n";
+        }
+        module_out << "    input [" << n - 1 << ":0] x,\n";
+        module_out << "    input [" << m - 1 << ":0] y,\n";
+        module_out << "    output [" << n + m - 1 << ":0] product\n";
+        module_out << ");\n\n";
+
+        // Произведения частей широкого операнда на узкий операнд
+        int level_latency = latency(n, m);
+        vector<string> even_row, odd_row;
+        for (int i = 0; i < split.parts; ++i) {
+            int width = i + 1 < split.parts ? narrow : split.last_width;
+            string part = "part_" + to_string(i);
+            string part_product = "pp_" + to_string(i);
+            module_out << "wire [" << width - 1 << ":0] " << part << " = " << wide_port << "["
+                       << i * narrow + width - 1 << ":" << i * narrow << "];\n";
+            module_out << "wire [" << width + narrow - 1 << ":0] " << part_product << ";\n";
+            generateModuleCall(multiplierName(width, narrow), part, narrow_port, part_product,
+                               "mult_" + to_string(i), module_out);
+            part_product = generateDelayLine(part_product, width + narrow, level_latency - latency(width, narrow), module_out);
+            vector<string> &row = i % 2 == 0 ? even_row : odd_row;
+            row.insert(row.begin(), part_product);
+        }
+
+        // Строки из непересекающихся произведений: четные части со сдвигом 0, нечетные - со сдвигом narrow
+        odd_row.push_back(to_string(narrow) + "'b0");
+        auto concat = [](const vector<string> &row) {
+            string result;
+            for (const string &item : row) {
+                result += (result.empty() ? "" : ", ") + item;
+            }
+            return "{" + result + "}";
+        };
+        module_out << "wire [" << n + m - 1 << ":0] row_even = " << concat(even_row) << ";\n";
+        module_out << "wire [" << n + m - 1 << ":0] row_odd = " << concat(odd_row) << ";\n";
+        module_out << "adder_" << n + m << " adder_rows (\n";
+        module_out << "    .a(row_even),\n";
+        module_out << "    .b(row_odd),\n";
+        module_out << "    .sum(product)\n";
+        module_out << ");\n";
+
+        // Конец определения модуля
+        module_out << "endmodule\n\n";
+    });
+}
+
+// Функция для генерации модульного умножителя разрядности n из модулей Карацубы
+// Монтгомери (R = 2^n): t = x * y, q = (t mod R) * M' mod R - модуль младшей половины karatsuba_low_n,
+// u = (t + q * M) / R - старшая половина q * M плюс перенос из младших половин, равный 1 при t mod R != 0;
+// u < 2M, поэтому результат - u или u - M
+// Барретт: q = floor(floor(t / 2^(n-1)) * mu / 2^(n+1)) - старшая половина произведения, остаток
+// r = t - q * M < 3M считается по модулю 2^(n+2) по младшей половине q * M из karatsuba_low_{n+2},
+// затем вычитается M или 2M
+// Без постоянного модуля M и константа редукции подаются на входы и задерживаются вместе с конвейером
+// Модуль с постоянным M не кэшируется: его имя не зависит от M
+void KaratsubaGenerator::generateModularModule(int n) {
+    if (!modular_modules.insert(n).second) {
+        return;
+    }
+
+    bool barrett = options.reduction == ModularReduction::Barrett;
+    generateKaratsubaModule(n);
+    if (barrett) {
+        generateKaratsubaModule(n + 1);
+        generateLowModule(n + 2);
+        emitSubtractorOnce(n + 2);
+    } else {
+        generateLowModule(n);
+        emitAdderOnce(n + 2);
+        emitSubtractorOnce(n + 2);
+    }
+
+    bool pipelined = options.pipeline_every > 0;
+    bool fixed = !options.modulus.isZero();
+    int constant_width = reductionConstantWidth(options.reduction, n);
+    string constant_port = reductionConstantPort(options.reduction);
+    int product_latency = latency(n);
+    int quotient_latency = barrett ? latency(n + 1) : lowLatency(n);
+    int qm_latency = barrett ? lowLatency(n + 2) : latency(n);
+    int cycles = product_latency + quotient_latency + qm_latency;
+
+    // Модуль и константа редукции: литералы или входы, задержанные на cycles тактов
+    string modulus_literal, constant_literal;
+    if (fixed) {
+        modulus_literal = to_string(n) + "'h" + options.modulus.toHex();
+        constant_literal = to_string(constant_width) + "'h" +
+                           reductionConstant(options.reduction, n, options.modulus).toHex();
+    }
+    auto modulus = [&](int cycles) {
+        return fixed ? modulus_literal : cycles > 0 ? "modulus_d" + to_string(cycles) : "modulus";
+    };
+    auto constant = [&](int cycles) {
+        return fixed ? constant_literal : cycles > 0 ? constant_port + "_d" + to_string(cycles) : constant_port;
+    };
+
+    // Начало определения модуля
+    out << "module " << modularName(options.reduction, n) << "(\n";
+    if (pipelined) {
+        out << "    input clk,\n";
+        out << "    input rst,\n";
+    }
+    out << "    input [" << n - 1 << ":0] x,\n";
+    out << "    input [" << n - 1 << ":0] y,\n";
+    if (!fixed) {
+        out << "    input [" << n - 1 << ":0] modulus,\n";
+        out << "    input [" << constant_width - 1 << ":0] " << constant_port << ",\n";
+    }
+    out << "    output [" << n - 1 << ":0] product\n";
+    out << ");\n\n";
+
+    if (!fixed) {
+        generateDelayLine("modulus", n, cycles, out);
+        generateDelayLine(constant_port, constant_width, product_latency, out);
+    }
+
+    out << "// Полное произведение t = x * y\n";
+    out << "wire [" << 2 * n - 1 << ":0] t;\n";
+    generateModuleCall(karatsubaName(n), "x", "y", "t", "mult_t", out);
+    string t_delayed = generateDelayLine("t", 2 * n, quotient_latency + qm_latency, out);
+
+    if (barrett) {
+        out << "// Оценка частного q = floor(floor(t / 2^" << n - 1 << ") * mu / 2^" << n + 1
+            << ") - старшая половина произведения\n";
+        out << "wire [" << 2 * n + 1 << ":0] q_full;\n";
+        generateModuleCall(karatsubaName(n + 1), "t[" + to_string(2 * n - 1) + ":" + to_string(n - 1) + "]",
+                           constant(product_latency), "q_full", "mult_q", out);
+        out << "// Младшая половина q * M: остаток r = t - q * M < 3M считается по модулю 2^" << n + 2 << "\n";
+        out << "wire [" << n + 1 << ":0] qm;\n";
+        generateModuleCall(lowName(n + 2), "{1'b0, q_full[" + to_string(2 * n + 1) + ":" + to_string(n + 1) + "]}",
+                           "{2'b0, " + modulus(product_latency + quotient_latency) + "}", "qm", "mult_qm", out);
+
+        out << "wire [" << n + 1 << ":0] r;\n";
+        out << "subtractor_" << n + 2 << " subtractor_r (\n";
+        out << "    .a(" << t_delayed << "[" << n + 1 << ":0]),\n";
+        out << "    .b(qm),\n";
+        out << "    .diff(r)\n";
+        out << ");\n\n";
+        out << "// Поправки r - M и r - 2M считаются параллельно; знак разности - старший бит\n";
+        out << "wire [" << n + 1 << ":0] r1, r2;\n";
+        out << "subtractor_" << n + 2 << " subtractor_r1 (\n";
+        out << "    .a(r),\n";
+        out << "    .b({2'b0, " << modulus(cycles) << "}),\n";
+        out << "    .diff(r1)\n";
+        out << ");\n\n";
+        out << "subtractor_" << n + 2 << " subtractor_r2 (\n";
+        out << "    .a(r),\n";
+        out << "    .b({1'b0, " << modulus(cycles) << ", 1'b0}),\n";
+        out << "    .diff(r2)\n";
+        out << ");\n\n";
+        out << "assign product = !r2[" << n + 1 << "] ? r2[" << n - 1 << ":0] : !r1[" << n + 1 << "] ? r1["
+            << n - 1 << ":0] : r[" << n - 1 << ":0];\n";
+    } else {
+        out << "// q = (t mod 2^" << n << ") * M' mod 2^" << n << " - младшая половина произведения\n";
+        out << "wire [" << n - 1 << ":0] q;\n";
+        generateModuleCall(lowName(n), "t[" + to_string(n - 1) + ":0]", constant(product_latency), "q", "mult_q", out);
+        out << "// Старшая половина q * M\n";
+        out << "wire [" << 2 * n - 1 << ":0] qm;\n";
+        generateModuleCall(karatsubaName(n), "q", modulus(product_latency + quotient_latency), "qm", "mult_qm", out);
+
+        out << "// u = (t + q * M) / 2^" << n << ": младшие половины в сумме дают 0 или 2^" << n
+            << ", перенос равен 1 при t mod 2^" << n << " != 0;\n";
+        out << "// младшие разряды слагаемых {перенос, 1} прибавляют его к сумме старших половин\n";
+        out << "wire carry = " << t_delayed << "[" << n - 1 << ":0] != 0;\n";
+        out << "wire [" << n + 1 << ":0] u_sum;\n";
+        out << "adder_" << n + 2 << " adder_u (\n";
+        out << "    .a({1'b0, " << t_delayed << "[" << 2 * n - 1 << ":" << n << "], carry}),\n";
+        out << "    .b({1'b0, qm[" << 2 * n - 1 << ":" << n << "], 1'b1}),\n";
+        out << "    .sum(u_sum)\n";
+        out << ");\n";
+        out << "wire [" << n << ":0] u = u_sum[" << n + 1 << ":1];\n\n";
+        out << "// Поправка u - M; знак разности - старший бит\n";
+        out << "wire [" << n + 1 << ":0] u1;\n";
+        out << "subtractor_" << n + 2 << " subtractor_u1 (\n";
+        out << "    .a({1'b0, u}),\n";
+        out << "    .b({2'b0, " << modulus(cycles) << "}),\n";
+        out << "    .diff(u1)\n";
+        out << ");\n\n";
+        out << "assign product = u1[" << n + 1 << "] ? u[" << n - 1 << ":0] : u1[" << n - 1 << ":0];\n";
+    }
+
+    // Конец определения модуля
+    out << "endmodule\n\n";
+}
+
+// Функция для генерации потоковой обертки karatsuba_stream_n с интерфейсом valid/ready вокруг karatsuba_mult_n
+// Вход - регистр с буфером skid: s_ready - выход регистра, поэтому m_ready не влияет на s_ready комбинационно.
+// Конвейер умножителя не останавливается: вектор подается на него, только если для результата уже есть место
+// в выходной очереди (pending - поданные и еще не выданные результаты), поэтому очереди глубиной
+// latency(n) + 2 достаточно, чтобы при m_ready = 1 принимать и выдавать по вектору каждый такт
+// С аккумулятором результаты пачки до s_last включительно складываются в регистре разрядности
+// 2n + accumulator_bits, и в очередь попадает только сумма пачки
+// Модуль не кэшируется: его имя не зависит от разрядности аккумулятора
+void KaratsubaGenerator::generateStreamModule(int n) {
+    if (!stream_modules.insert(n).second) {
+        return;
+    }
 
-    // Генерация верхнего модуля и его тело
     generateKaratsubaModule(n);
+    bool accumulate = options.accumulator_bits > 0;
+    int width = 2 * n + options.accumulator_bits;
+    if (accumulate) {
+        emitAdderOnce(width);
+    }
+
+    int core_latency = latency(n);
+    int depth = streamLatency(n);
+    auto bit_width = [](int value) {
+        int bits = 1;
+        while ((value >> bits) > 0) {
+            bits++;
+        }
+        return bits;
+    };
+    int count_width = bit_width(depth);
+    int pointer_width = bit_width(depth - 1);
+    string full = to_string(count_width) + "'d" + to_string(depth);
+
+    // Начало определения модуля
+    out << "module karatsuba_stream_" << n << "(\n";
+    out << "    input clk,\n";
+    out << "    input rst,\n";
+    out << "    input s_valid,\n";
+    out << "    output s_ready,\n";
+    out << "    input s_last,\n";
+    out << "    input [" << n - 1 << ":0] x,\n";
+    out << "    input [" << n - 1 << ":0] y,\n";
+    out << "    output m_valid,\n";
+    out << "    input m_ready,\n";
+    out << "    output m_last,\n";
+    out << "    output [" << width - 1 << ":0] product\n";
+    out << ");\n\n";
+
+    out << "// Входной регистр и буфер skid: вектор, пришедший при занятом входном регистре, ждет в буфере\n";
+    out << "reg in_valid, in_last, skid_valid, skid_last;\n";
+    out << "reg [" << n - 1 << ":0] in_x, in_y, skid_x, skid_y;\n";
+    out << "assign s_ready = !skid_valid;\n\n";
+
+    out << "// Вектор подается на умножитель, если в выходной очереди есть место для его результата\n";
+    out << "reg [" << count_width - 1 << ":0] pending;\n";
+    out << "wire issue = in_valid && pending != " << full << ";\n";
+    out << "wire issue_last = in_last;\n";
+    out << "wire advance = !in_valid || issue;\n\n";
+
+    out << "always @(posedge clk) begin\n";
+    out << "    if (rst) begin\n";
+    out << "        in_valid <= 0;\n";
+    out << "        skid_valid <= 0;\n";
+    out << "    end else if (advance) begin\n";
+    out << "        if (skid_valid) begin\n";
+    out << "            in_valid <= 1;\n";
+    out << "            in_last <= skid_last;\n";
+    out << "            in_x <= skid_x;\n";
+    out << "            in_y <= skid_y;\n";
+    out << "            skid_valid <= 0;\n";
+    out << "        end else begin\n";
+    out << "            in_valid <= s_valid;\n";
+    out << "            in_last <= s_last;\n";
+    out << "            in_x <= x;\n";
+    out << "            in_y <= y;\n";
+    out << "        end\n";
+    out << "    end else if (s_valid && !skid_valid) begin\n";
+    out << "        skid_valid <= 1;\n";
+    out << "        skid_last <= s_last;\n";
+    out << "        skid_x <= x;\n";
+    out << "        skid_y <= y;\n";
+    out << "    end\n";
+    out << "end\n\n";
+
+    out << "// Умножитель; признаки поданного вектора идут по линиям задержки вместе с ним\n";
+    out << "wire [" << 2 * n - 1 << ":0] core_product;\n";
+    generateModuleCall(karatsubaName(n), "in_x", "in_y", "core_product", "core", out);
+    string core_valid = generateDelayLine("issue", 1, core_latency, out);
+    string core_last = generateDelayLine("issue_last", 1, core_latency, out);
+
+    string push_data = "core_product";
+    string push_last = core_last;
+    if (accumulate) {
+        out << "// Аккумулятор пачки: после s_last сумма уходит в очередь, а аккумулятор обнуляется\n";
+        out << "reg [" << width - 1 << ":0] acc;\n";
+        out << "wire [" << width - 1 << ":0] acc_sum;\n";
+        out << "adder_" << width << " adder_acc (\n";
+        out << "    .a(acc),\n";
+        out << "    .b({" << options.accumulator_bits << "'b0, core_product}),\n";
+        out << "    .sum(acc_sum)\n";
+        out << ");\n";
+        out << "always @(posedge clk) begin\n";
+        out << "    if (rst) begin\n";
+        out << "        acc <= 0;\n";
+        out << "    end else if (" << core_valid << ") begin\n";
+        out << "        acc <= " << core_last << " ? 0 : acc_sum;\n";
+        out << "    end\n";
+        out << "end\n\n";
+        push_data = "acc_sum";
+        push_last = "1'b1";
+    }
+    out << "wire push = " << core_valid << (accumulate ? " && " + core_last : "") << ";\n";
+    if (accumulate) {
+        out << "wire absorb = " << core_valid << " && !" << core_last << ";\n";
+    }
+    out << "\n";
+
+    out << "// Выходная очередь на " << depth << " результатов\n";
+    out << "reg [" << width - 1 << ":0]";
+    for (int i = 0; i < depth; ++i) {
+        out << (i == 0 ? " " : ", ") << "queue_" << i;
+    }
+    out << ";\n";
+    out << "reg";
+    for (int i = 0; i < depth; ++i) {
+        out << (i == 0 ? " " : ", ") << "queue_last_" << i;
+    }
+    out << ";\n";
+    out << "reg [" << pointer_width - 1 << ":0] write_ptr, read_ptr;\n";
+    out << "reg [" << count_width - 1 << ":0] stored;\n";
+    out << "assign m_valid = stored != 0;\n";
+    out << "wire pop = m_valid && m_ready;\n";
+    auto select = [&](const string &prefix) {
+        string result = prefix + to_string(depth - 1);
+        for (int i = depth - 2; i >= 0; --i) {
+            result = "read_ptr == " + to_string(i) + " ? " + prefix + to_string(i) + " : " + result;
+        }
+        return result;
+    };
+    out << "assign product = " << select("queue_") << ";\n";
+    out << "assign m_last = " << select("queue_last_") << ";\n\n";
+
+    auto next_pointer = [&](const string &pointer) {
+        return pointer + " == " + to_string(depth - 1) + " ? 0 : " + pointer + " + 1";
+    };
+    out << "always @(posedge clk) begin\n";
+    out << "    if (rst) begin\n";
+    out << "        pending <= 0;\n";
+    out << "        stored <= 0;\n";
+    out << "        write_ptr <= 0;\n";
+    out << "        read_ptr <= 0;\n";
+    out << "    end else begin\n";
+    out << "        pending <= pending + issue - pop" << (accumulate ? " - absorb" : "") << ";\n";
+    out << "        stored <= stored + push - pop;\n";
+    out << "        if (push) begin\n";
+    out << "            write_ptr <= " << next_pointer("write_ptr") << ";\n";
+    out << "        end\n";
+    out << "        if (pop) begin\n";
+    out << "            read_ptr <= " << next_pointer("read_ptr") << ";\n";
+    out << "        end\n";
+    out << "    end\n";
+    out << "end\n\n";
+
+    out << "always @(posedge clk) begin\n";
+    out << "    if (push) begin\n";
+    out << "        case (write_ptr)\n";
+    for (int i = 0; i < depth; ++i) {
+        out << "            " << i << ": begin\n";
+        out << "                queue_" << i << " <= " << push_data << ";\n";
+        out << "                queue_last_" << i << " <= " << push_last << ";\n";
+        out << "            end\n";
+    }
+    out << "        endcase\n";
+    out << "    end\n";
+    out << "end\n";
+
+    // Конец определения модуля
+    out << "endmodule\n\n";
+}
+
+// Функция для генерации обертки karatsuba_mult_n над параметризованным модулем karatsuba_mult #(.N(n))
+// Параметризованные модули выводятся один раз на контекст, обертки - по одной на разрядность;
+// порог рекурсии передается значением по умолчанию параметра CUTOFF
+void KaratsubaGenerator::generateParameterizedModule(int n) {
+    if (!parameterized_emitted) {
+        parameterized_emitted = true;
+        emitModule("adder", [](ostream &module_out) {
+            generateParameterizedAdderModule(module_out);
+            module_out << "\n";
+        });
+        emitModule("subtractor", [](ostream &module_out) {
+            generateParameterizedSubtractorModule(module_out);
+            module_out << "\n";
+        });
+        emitModule("direct_mult", [](ostream &module_out) {
+            generateParameterizedDirectModule(module_out);
+            module_out << "\n";
+        });
+        emitModule("karatsuba_mult", [this](ostream &module_out) {
+            generateParameterizedKaratsubaModule(options.cutoff, module_out);
+            module_out << "\n";
+        });
+    }
+    if (!parameterized_wrappers.insert(n).second) {
+        return;
+    }
+
+    string module_name = karatsubaName(n);
+    emitModule(module_name, [n, &module_name](ostream &module_out) {
+        module_out << "module " << module_name << "(\n";
+        module_out << "    input [" << n - 1 << ":0] x,\n";
+        module_out << "    input [" << n - 1 << ":0] y,\n";
+        module_out << "    output [" << 2 * n - 1 << ":0] product\n";
+        module_out << ");\n\n";
+        module_out << "karatsuba_mult #(.N(" << n << ")) mult (\n";
+        module_out << "    .x(x),\n";
+        module_out << "    .y(y),\n";
+        module_out << "    .product(product)\n";
+        module_out << ");\n";
+        module_out << "endmodule\n\n";
+    });
+}
 
-    // Генерация модулей сумматоров и вычитателей для всех необходимых размеров
-    string adder_modules = "";
-    for (int size : adder_sizes) {
-        adder_modules += generateAdderModule(size) + "\n";
+// Функция для генерации модуля младшей половины произведения karatsuba_low_n: product = x * y mod 2^n
+// x = x1 * 2^h + x0, h = n - n/2: слагаемое x1 * y1 * 2^(2h) не влияет на младшие n бит, поэтому
+// уровень состоит из полного произведения z0 = x0 * y0 и младших половин c1 = x1 * y0 и c2 = x0 * y1
+// разрядности n/2, которые прибавляются к старшим n/2 битам z0
+void KaratsubaGenerator::generateLowModule(int n) {
+    if (!low_modules.insert(n).second) {
+        return;
     }
 
-    string subtractor_modules = "";
-    for (int size : subtractor_sizes) {
-        subtractor_modules += generateSubtractorModule(size) + "\n";
+    KaratsubaSplit split = splitKaratsuba(n);
+    int m = split.m;
+    int h = split.n_minus_m;
+    bool direct = isDirect(n);
+    if (direct) {
+        if (options.base != BaseMultiplier::Flat) {
+            emitCellsOnce();
+            emitAdderOnce(n);
+        }
+    } else {
+        generateKaratsubaModule(h);
+        generateLowModule(m);
+        emitAdderOnce(m);
     }
 
-    // Комбинирование всех модулей
-    stringstream ss;
-    ss << adder_modules;
-    ss << subtractor_modules;
-    ss << module_definitions; // Все модули уже добавлены в module_definitions
+    string module_name = lowName(n);
+    emitModule(module_name, [this, n, m, h, direct, &module_name](ostream &module_out) {
+        // Начало определения модуля
+        module_out << "module " << module_name << "(\n";
+        if (options.pipeline_every > 0) {
+            module_out << "    input clk,\n";
+            module_out << "    input rst,\n";
+        }
+        module_out << "    input [" << n - 1 << ":0] x,\n";
+        module_out << "    input [" << n - 1 << ":0] y,\n";
+        module_out << "    output [" << n - 1 << ":0] product\n";
+        module_out << ");\n\n";
 
-    return ss.str();
+        if (direct) {
+            generateTruncatedMultiplication(n, "x", "y", "product", 0, n, module_out);
+        } else {
+            int level_latency = lowLatency(n);
+            string x1 = "x[" + to_string(n - 1) + ":" + to_string(h) + "]";
+            string y1 = "y[" + to_string(n - 1) + ":" + to_string(h) + "]";
+
+            module_out << "wire [" << 2 * h - 1 << ":0] z0;\n";
+            generateModuleCall(karatsubaName(h), "x[" + to_string(h - 1) + ":0]", "y[" + to_string(h - 1) + ":0]",
+                               "z0", "mult_z0", module_out);
+            string z0 = generateDelayLine("z0", 2 * h, level_latency - latency(h), module_out);
+            module_out << "// Младшие половины перекрестных произведений x1 * y0 и x0 * y1\n";
+            module_out << "wire [" << m - 1 << ":0] c1, c2;\n";
+            generateModuleCall(lowName(m), x1, "y[" + to_string(m - 1) + ":0]", "c1", "mult_c1", module_out);
+            generateModuleCall(lowName(m), "x[" + to_string(m - 1) + ":0]", y1, "c2", "mult_c2", module_out);
+            string c1 = generateDelayLine("c1", m, level_latency - lowLatency(m), module_out);
+            string c2 = generateDelayLine("c2", m, level_latency - lowLatency(m), module_out);
+
+            module_out << "wire [" << m - 1 << ":0] high_c1, high;\n";
+            module_out << "adder_" << m << " adder_c1 (\n";
+            module_out << "    .a(" << z0 << "[" << n - 1 << ":" << h << "]),\n";
+            module_out << "    .b(" << c1 << "),\n";
+            module_out << "    .sum(high_c1)\n";
+            module_out << ");\n\n";
+            module_out << "adder_" << m << " adder_c2 (\n";
+            module_out << "    .a(high_c1),\n";
+            module_out << "    .b(" << c2 << "),\n";
+            module_out << "    .sum(high)\n";
+            module_out << ");\n\n";
+            module_out << "assign product = {high, " << z0 << "[" << h - 1 << ":0]};\n";
+        }
+
+        // Конец определения модуля
+        module_out << "endmodule\n\n";
+    });
 }
 
-// Функция для генерации модуля Карацубы заданной разрядности n
-string generateKaratsubaModule(int n) {
-    string module_name = "karatsuba_mult_" + to_string(n);
-    stringstream ss;
+// Функция для генерации модуля старшей половины karatsuba_high_n_t: product = A / 2^t, где A - сумма
+// частичных произведений x * y веса не меньше 2^t, то есть floor(x * y / 2^t) с ошибкой не больше
+// highErrorBound(n, t) / 2^t снизу. Слагаемые уровня из highTerms сдвигаются к весу 2^t и складываются
+// сумматорами разрядности 2n - t; подмодули с порогом t <= 0 - полные умножители Карацубы
+void KaratsubaGenerator::generateHighModule(int n, int t) {
+    if (!high_modules.insert({n, t}).second) {
+        return;
+    }
 
-    // Проверка, был ли уже сгенерирован модуль для данного n
-    if (generated_modules.find(n) != generated_modules.end()) {
-        return ""; // Если модуль уже сгенерирован, возвращаем пустую строку
+    int width = 2 * n - t;
+    bool direct = isDirect(n);
+    vector<HighTerm> terms;
+    if (direct) {
+        if (options.base != BaseMultiplier::Flat) {
+            emitCellsOnce();
+            emitAdderOnce(width);
+        }
+    } else {
+        terms = highTerms(n, t);
+        for (const HighTerm &term : terms) {
+            if (term.threshold <= 0) {
+                generateKaratsubaModule(term.width);
+            } else {
+                generateHighModule(term.width, term.threshold);
+            }
+        }
+        if (terms.size() > 1) {
+            emitAdderOnce(width);
+        }
     }
-    generated_modules.insert(n); // Добавляем n в множество сгенерированных модулей
 
-    // Начало определения модуля
-    ss << "module " << module_name << "(\n";
-    ss << "    input [" << n - 1 << ":0] x,\n";
-    ss << "    input [" << n - 1 << ":0] y,\n";
-    ss << "    output [" << 2 * n - 1 << ":0] product\n";
-    ss << ");\n\n";
+    string module_name = highName(n, t);
+    emitModule(module_name, [this, n, t, width, direct, &terms, &module_name](ostream &module_out) {
+        // Начало определения модуля
+        module_out << "module " << module_name << "(\n";
+        if (options.pipeline_every > 0) {
+            module_out << "    input clk,\n";
+            module_out << "    input rst,\n";
+        }
+        module_out << "    input [" << n - 1 << ":0] x,\n";
+        module_out << "    input [" << n - 1 << ":0] y,\n";
+        module_out << "    output [" << width - 1 << ":0] product\n";
+        module_out << ");\n\n";
 
-    int module_count = 0;
-    // Генерация тела модуля
-    ss << generateKaratsubaModuleBody(n, module_count);
+        if (direct) {
+            generateTruncatedMultiplication(n, "x", "y", "product", t, 2 * n, module_out);
+        } else {
+            // Строки разрядности 2n - t: результат подмодуля со сдвигом его веса относительно 2^t
+            int level_latency = highLatency(n, t);
+            vector<string> rows;
+            for (const HighTerm &term : terms) {
+                bool full = term.threshold <= 0;
+                int term_width = full ? 2 * term.width : 2 * term.width - term.threshold;
+                int shift = (full ? 0 : term.threshold) + term.offset - t;
+                int term_latency = full ? latency(term.width) : highLatency(term.width, term.threshold);
+                module_out << "wire [" << term_width - 1 << ":0] " << term.name << ";\n";
+                generateModuleCall(full ? karatsubaName(term.width) : highName(term.width, term.threshold), term.x,
+                                   term.y, term.name, "mult_" + term.name, module_out);
+                string value = generateDelayLine(term.name, term_width, level_latency - term_latency, module_out);
 
-    // Конец определения модуля
-    ss << "endmodule\n\n";
+                int used = min(term_width, width - shift);
+                string row = used < term_width ? value + "[" + to_string(used - 1) + ":0]" : value;
+                if (shift > 0) {
+                    row += ", " + to_string(shift) + "'b0";
+                }
+                if (shift + used < width) {
+                    row = to_string(width - shift - used) + "'b0, " + row;
+                }
+                rows.push_back(shift > 0 || shift + used < width ? "{" + row + "}" : row);
+            }
 
-    // Добавляем определение модуля в глобальную переменную
-    module_definitions = ss.str() + module_definitions; // Добавляем в начало, чтобы верхний модуль был последним
+            if (rows.size() == 1) {
+                module_out << "assign product = " << rows[0] << ";\n";
+            } else {
+                for (size_t i = 1; i < rows.size(); ++i) {
+                    string sum = i + 1 < rows.size() ? "sum_" + to_string(i) : "product";
+                    if (i + 1 < rows.size()) {
+                        module_out << "wire [" << width - 1 << ":0] " << sum << ";\n";
+                    }
+                    module_out << "adder_" << width << " adder_" << i << " (\n";
+                    module_out << "    .a(" << (i == 1 ? rows[0] : "sum_" + to_string(i - 1)) << "),\n";
+                    module_out << "    .b(" << rows[i] << "),\n";
+                    module_out << "    .sum(" << sum << ")\n";
+                    module_out << (i + 1 < rows.size() ? ");\n\n" : ");\n");
+                }
+            }
+        }
 
-    return ""; // Возвращаем пустую строку, так как определение модуля уже сохранено
+        // Конец определения модуля
+        module_out << "endmodule\n\n";
+    });
 }
 
-// Функция для генерации тела модуля Карацубы
-string generateKaratsubaModuleBody(int n, int &module_count) {
-    stringstream ss;
+// Функция для генерации разрядов [lo, hi) прямого умножения выбранной реализацией базового умножителя
+void KaratsubaGenerator::generateTruncatedMultiplication(int n, const string &a, const string &b, const string &product,
+                                                         int lo, int hi, ostream &out) {
+    if (options.base == BaseMultiplier::Flat) {
+        generateTruncatedMultiplicationLogic(n, a, b, product, lo, hi, out);
+    } else {
+        generateTruncatedTreeLogic(n, a, b, product, lo, hi, options.base, out);
+    }
+}
+
+// Функция для генерации общего подмодуля разрядности n последовательного модуля
+// Выход sub_product, готовность sub_done: у последовательного подмодуля это его done,
+// у karatsuba_mult_n - sub_start, задержанный на латентность подмодуля
+void KaratsubaGenerator::generateSharedMultiplierCall(int n, const string &x, const string &y, ostream &out) {
+    bool sequential = isFolded(n);
+    out << "wire [" << 2 * n - 1 << ":0] sub_product;\n";
+    out << "wire sub_done;\n";
+    out << (sequential ? "karatsuba_seq_" : "karatsuba_mult_") << n << " sub_mult (\n";
+    if (sequential || options.pipeline_every > 0) {
+        out << "    .clk(clk),\n";
+        out << "    .rst(rst),\n";
+    }
+    if (sequential) {
+        out << "    .start(sub_start),\n";
+    }
+    out << "    .x(" << x << "),\n";
+    out << "    .y(" << y << "),\n";
+    if (sequential) {
+        out << "    .product(sub_product),\n";
+        out << "    .done(sub_done)\n";
+        out << ");\n\n";
+    } else {
+        out << "    .product(sub_product)\n";
+        out << ");\n";
+        string sub_done = generateDelayLine("sub_start", 1, latency(n), out);
+        out << "assign sub_done = " << sub_done << ";\n\n";
+    }
+}
 
+// Функция для генерации тела модуля Карацубы
+void KaratsubaGenerator::generateKaratsubaModuleBody(int n, int &module_count, const string &result, ostream &out) {
     if (n <= 2) {
         // Базовый случай для n <= 2: прямое умножение с использованием побитовых операций
-        ss << generateMultiplicationLogic(n, "x", "y", "product");
+        generateBaseMultiplication(n, "x", options.square ? "x" : "y", result, out);
     } else {
         // Разбиение на старшие и младшие части
-        int m = n / 2;
-        int n_minus_m = n - m;
-
-        ss << "wire [" << n_minus_m - 1 << ":0] x0 = x[" << n_minus_m - 1 << ":0];\n";
-        ss << "wire [" << m - 1 << ":0] x1 = x[" << n - 1 << ":" << n_minus_m << "];\n";
-        ss << "wire [" << n_minus_m - 1 << ":0] y0 = y[" << n_minus_m - 1 << ":0];\n";
-        ss << "wire [" << m - 1 << ":0] y1 = y[" << n - 1 << ":" << n_minus_m << "];\n\n";
+        KaratsubaSplit split = splitKaratsuba(n);
+        int m = split.m;
+        int n_minus_m = split.n_minus_m;
+        // Для квадратора y1, y0 и s2 совпадают с x1, x0 и s1
+        string y1 = options.square ? "x1" : "y1";
+        string y0 = options.square ? "x0" : "y0";
+        string s2 = options.square ? "s1" : "s2";
+        generateOperandSplit(split, "x", "y", out);
 
         // Рекурсивные вызовы для z2, z0
         string z2 = "z2_" + to_string(module_count);
@@ -97,112 +1482,504 @@ string generateKaratsubaModuleBody(int n, int &module_count) {
         module_count++;
 
         // z2 = x1 * y1
-        ss << "wire [" << 2 * m - 1 << ":0] " << z2 << ";\n";
-        ss << generateKaratsubaModuleCall(m, "x1", "y1", z2, module_count);
+        out << "wire [" << 2 * m - 1 << ":0] " << z2 << ";\n";
+        generateKaratsubaModuleCall(m, "x1", y1, z2, "mult_" + to_string(module_count++), out);
 
         // z0 = x0 * y0
-        ss << "wire [" << 2 * n_minus_m - 1 << ":0] " << z0 << ";\n";
-        ss << generateKaratsubaModuleCall(n_minus_m, "x0", "y0", z0, module_count);
-
-        // s1 = x1 + x0
-        int s_width = max(m, n_minus_m) + 1;
-        adder_sizes.insert(s_width); // Добавляем размер сумматора в множество
-        ss << "wire [" << s_width - 1 << ":0] s1;\n";
-        ss << "adder_" << s_width << " adder_s1 (\n";
-        ss << "    .a({{" << (s_width - m) << "{1'b0}}, x1}),\n";
-        ss << "    .b({{" << (s_width - n_minus_m) << "{1'b0}}, x0}),\n";
-        ss << "    .sum(s1)\n";
-        ss << ");\n";
-
-        // s2 = y1 + y0
-        ss << "wire [" << s_width - 1 << ":0] s2;\n";
-        ss << "adder_" << s_width << " adder_s2 (\n";
-        ss << "    .a({{" << (s_width - m) << "{1'b0}}, y1}),\n";
-        ss << "    .b({{" << (s_width - n_minus_m) << "{1'b0}}, y0}),\n";
-        ss << "    .sum(s2)\n";
-        ss << ");\n\n";
+        out << "wire [" << 2 * n_minus_m - 1 << ":0] " << z0 << ";\n";
+        generateKaratsubaModuleCall(n_minus_m, "x0", y0, z0, "mult_" + to_string(module_count++), out);
+
+        // s1 = x1 + x0, s2 = y1 + y0
+        generateOperandSums(split, out);
 
         // p = s1 * s2
+        int s_width = split.s_width;
         string p = "p_" + to_string(module_count);
-        int p_width = 2 * s_width;
-        ss << "wire [" << p_width - 1 << ":0] " << p << ";\n";
+        int p_width = split.p_width;
+        out << "wire [" << p_width - 1 << ":0] " << p << ";\n";
 
-        // Проверка на возможность рекурсивного вызова
-        if (s_width >= n) {
+        if (split.p_recursive) {
+            // Рекурсивный вызов для p
+            generateKaratsubaModuleCall(s_width, "s1", s2, p, "mult_" + to_string(module_count++), out);
+        } else {
             // Прямое умножение для p
-            ss << generateMultiplicationLogic(s_width, "s1", "s2", p);
+            generateBaseMultiplication(s_width, "s1", s2, p, out);
+        }
+
+        // Выравнивание задержек z2, z0 и p по самому медленному подмодулю
+        int z2_latency = latency(m);
+        int z0_latency = latency(n_minus_m);
+        int p_latency = split.p_recursive ? latency(s_width) : 0;
+        int level_latency = max({z2_latency, z0_latency, p_latency});
+        z2 = generateDelayLine(z2, 2 * m, level_latency - z2_latency, out);
+        z0 = generateDelayLine(z0, 2 * n_minus_m, level_latency - z0_latency, out);
+        p = generateDelayLine(p, p_width, level_latency - p_latency, out);
+
+        generateRecombination(split, z2, z0, p, z1, result, out);
+    }
+}
+
+// true, если тело модуля разрядности n строится списком соединений
+// Модули с n <= 2 используют прямое умножение в generateKaratsubaModuleBody и не оптимизируются;
+// уровни Toom-3 всегда выводятся списком соединений, а оптимизируются только при optimize_netlist
+bool KaratsubaGenerator::usesNetlist(int n) {
+    return n > 2 && !isDirect(n) && (options.optimize_netlist || isToom(n));
+}
+
+// Функция для построения списка соединений тела модуля Карацубы разрядности n
+// Повторяет generateKaratsubaModuleBody, но части операндов и сдвиги задаются шинами без отдельных цепей
+void KaratsubaGenerator::buildKaratsubaNetlist(int n, Netlist &netlist) {
+    if (isToom(n)) {
+        buildToomNetlist(n, netlist);
+        return;
+    }
+    KaratsubaSplit split = splitKaratsuba(n);
+    int m = split.m;
+    int h = split.n_minus_m;
+    int s_width = split.s_width;
+    int p_width = split.p_width;
+    int width = split.product_width;
+
+    Bus x = netlist.bus(netlist.addInput("x", n));
+    Bus x0 = sliceBus(x, 0, h), x1 = sliceBus(x, h, m);
+    // Квадраторы - ячейки умножения с одним входом
+    vector<Bus> z2_inputs = {x1}, z0_inputs = {x0};
+    Bus y0, y1;
+    if (!options.square) {
+        Bus y = netlist.bus(netlist.addInput("y", n));
+        y0 = sliceBus(y, 0, h);
+        y1 = sliceBus(y, h, m);
+        z2_inputs.push_back(y1);
+        z0_inputs.push_back(y0);
+    }
+
+    // z2 = x1 * y1, z0 = x0 * y0, p = (x1 + x0) * (y1 + y0)
+    Bus z2 = netlist.addCell(CellKind::Multiplier, "mult_1", m, z2_inputs, {"z2_0"})[0];
+    Bus z0 = netlist.addCell(CellKind::Multiplier, "mult_2", h, z0_inputs, {"z0_0"})[0];
+    Bus s1 = netlist.addCell(CellKind::Adder, "adder_s1", s_width, {resizeBus(x1, s_width), resizeBus(x0, s_width)}, {"s1"})[0];
+    vector<Bus> p_inputs = {s1};
+    if (!options.square) {
+        p_inputs.push_back(netlist.addCell(CellKind::Adder, "adder_s2", s_width, {resizeBus(y1, s_width), resizeBus(y0, s_width)}, {"s2"})[0]);
+    }
+    Bus p = netlist.addCell(CellKind::Multiplier, split.p_recursive ? "mult_3" : "base_p", s_width, p_inputs, {"p_3"},
+                            0, !split.p_recursive)[0];
+
+    // Выравнивание задержек z2, z0 и p по самому медленному подмодулю
+    int z2_latency = latency(m);
+    int z0_latency = latency(h);
+    int p_latency = split.p_recursive ? latency(s_width) : 0;
+    int level_latency = max({z2_latency, z0_latency, p_latency});
+    auto delay = [&](const Bus &bus, const string &name, int cycles) {
+        if (cycles <= 0) {
+            return bus;
+        }
+        return netlist.addCell(CellKind::Delay, name, static_cast<int>(bus.size()), {bus},
+                               {name + "_d" + to_string(cycles)}, cycles)[0];
+    };
+    z2 = delay(z2, "z2_0", level_latency - z2_latency);
+    z0 = delay(z0, "z0_0", level_latency - z0_latency);
+    p = delay(p, "p_3", level_latency - p_latency);
+
+    if (options.carry_save) {
+        // Строки те же, что в generateCarrySaveRecombination
+        Bus z2_shift = resizeBus(concatBus(constantBus(h, 0), z2), width);
+        Bus z0_shift = resizeBus(concatBus(constantBus(h, 0), z0), width);
+        vector<Bus> rows = {
+            resizeBus(concatBus(z0, z2), width),
+            resizeBus(concatBus(constantBus(h, 0), p), width),
+            netlist.addCell(CellKind::Invert, "rec_row2", width, {z2_shift}, {"rec_row2"})[0],
+            netlist.addCell(CellKind::Invert, "rec_row3", width, {z0_shift}, {"rec_row3"})[0],
+            constantBus(width, 2),
+        };
+        int csa_count = 0;
+        while (rows.size() > 2) {
+            vector<Bus> next;
+            size_t k = 0;
+            for (; k + 3 <= rows.size(); k += 3) {
+                string index = to_string(csa_count++);
+                vector<Bus> outputs = netlist.addCell(CellKind::CarrySave, "csa" + index, width,
+                                                      {rows[k], rows[k + 1], rows[k + 2]}, {"rec_s" + index, "rec_c" + index});
+                next.insert(next.end(), outputs.begin(), outputs.end());
+            }
+            next.insert(next.end(), rows.begin() + k, rows.end());
+            rows = next;
+        }
+        netlist.setOutput("product", netlist.addCell(CellKind::Adder, "adder_final", width, {rows[0], rows[1]}, {"rec_sum"})[0]);
+        return;
+    }
+
+    // z1 = p - z2 - z0
+    Bus temp_sub1 = netlist.addCell(CellKind::Subtractor, "sub1", p_width, {p, resizeBus(z2, p_width)}, {"temp_sub1"})[0];
+    Bus z1 = netlist.addCell(CellKind::Subtractor, "sub2", p_width, {temp_sub1, resizeBus(z0, p_width)}, {"z1_0"})[0];
+    // z1 = x1 * y0 + x0 * y1 < 2^(n+1), поэтому старшие биты разности равны нулю
+    // и вычитатели достаточно считать по модулю 2^(n+1)
+    z1 = resizeBus(sliceBus(z1, 0, min(n + 1, p_width)), n + 1);
+
+    // result = z2 * 2^(2h) + z1 * 2^h + z0
+    Bus z2_shift = resizeBus(concatBus(constantBus(2 * h, 0), z2), width);
+    Bus z1_shift = resizeBus(concatBus(constantBus(h, 0), z1), width);
+    Bus temp_sum1 = netlist.addCell(CellKind::Adder, "adder1", width, {z2_shift, z1_shift}, {"temp_sum1"})[0];
+    Bus temp_sum2 = netlist.addCell(CellKind::Adder, "adder2", width, {temp_sum1, resizeBus(z0, width)}, {"temp_sum2"})[0];
+    netlist.setOutput("product", temp_sum2);
+}
+
+// Функция для построения списка соединений уровня Toom-3 разрядности n
+// Операнды вычисляются в точках 0, 1, 2, 1/2 (умноженной на 4) и бесконечность, пять произведений
+// r0 = c0, r1 = c(1), r2 = c(2), rh = 16 * c(1/2), rinf = c4 дают коэффициенты c1, c2, c3:
+//   a = r1 - r0 - rinf = c1 + c2 + c3
+//   b = (r2 - r0 - 16 * rinf) / 2 = c1 + 2 * c2 + 4 * c3
+//   c = (rh - 16 * r0 - rinf) / 2 = 4 * c1 + 2 * c2 + c3
+//   c2 = 5 * a - b - c, c3 = (b - a - c2) / 3, c1 = a - c2 - c3
+// Промежуточные разности могут быть отрицательными, поэтому интерполяция считается по модулю 2^w;
+// деления точные: на 2 - сдвигом неотрицательного значения, на 3 - умножением на обратный элемент
+void KaratsubaGenerator::buildToomNetlist(int n, Netlist &netlist) {
+    ToomSplit split = splitToom3(n);
+    int k = split.k;
+    int w = split.interpolation_width;
+    int width = split.product_width;
+    bool square = options.square;
+
+    auto shifted = [](const Bus &bus, int shift, int result_width) {
+        return resizeBus(concatBus(constantBus(shift, 0), bus), result_width);
+    };
+    auto add = [&](const string &name, int cell_width, const Bus &a, const Bus &b) {
+        return netlist.addCell(CellKind::Adder, "adder_" + name, cell_width, {resizeBus(a, cell_width), resizeBus(b, cell_width)}, {name})[0];
+    };
+    auto subtract = [&](const string &name, const Bus &a, const Bus &b) {
+        return netlist.addCell(CellKind::Subtractor, "sub_" + name, w, {resizeBus(a, w), resizeBus(b, w)}, {name})[0];
+    };
+    // Значения операнда в точках 1, 2 и 1/2 (умноженное на 4)
+    auto evaluate = [&](const string &operand, vector<Bus> &points) {
+        Bus value = netlist.bus(netlist.addInput(operand, n));
+        Bus v0 = sliceBus(value, 0, k), v1 = sliceBus(value, k, k), v2 = sliceBus(value, 2 * k, split.high);
+        int sum_width = split.sum_width, point_width = split.point_width;
+        points.push_back(add(operand + "_e1", sum_width, add(operand + "_e1a", sum_width, v0, v1), v2));
+        points.push_back(add(operand + "_e2", point_width, add(operand + "_e2a", point_width, v0, shifted(v1, 1, point_width)),
+                             shifted(v2, 2, point_width)));
+        points.push_back(add(operand + "_eh", point_width, add(operand + "_eha", point_width, shifted(v0, 2, point_width),
+                                                               shifted(v1, 1, point_width)), v2));
+        points.insert(points.begin(), v0);
+        points.push_back(v2);
+    };
+    vector<Bus> x_points, y_points;
+    evaluate("x", x_points);
+    if (!square) {
+        evaluate("y", y_points);
+    }
+
+    // r0 = x(0) * y(0), r1 = x(1) * y(1), r2 = x(2) * y(2), rh = 16 * x(1/2) * y(1/2), rinf = x2 * y2
+    const vector<string> names = {"r0", "r1", "r2", "rh", "rinf"};
+    const vector<int> widths = {k, split.sum_width, split.point_width, split.point_width, split.high};
+    vector<Bus> products;
+    int level_latency = 0;
+    for (int width_i : widths) {
+        level_latency = max(level_latency, latency(width_i));
+    }
+    for (size_t i = 0; i < names.size(); ++i) {
+        vector<Bus> inputs = {x_points[i]};
+        if (!square) {
+            inputs.push_back(y_points[i]);
+        }
+        Bus product = netlist.addCell(CellKind::Multiplier, "mult_" + to_string(i), widths[i], inputs, {names[i]})[0];
+        // Выравнивание задержек произведений по самому медленному подмодулю
+        int cycles = level_latency - latency(widths[i]);
+        if (cycles > 0) {
+            product = netlist.addCell(CellKind::Delay, names[i], 2 * widths[i], {product},
+                                      {names[i] + "_d" + to_string(cycles)}, cycles)[0];
+        }
+        products.push_back(product);
+    }
+    Bus r0 = products[0], r1 = products[1], r2 = products[2], rh = products[3], rinf = products[4];
+
+    // Интерполяция по модулю 2^w
+    Bus a = subtract("a", subtract("a1", r1, r0), rinf);
+    Bus b = sliceBus(subtract("b", subtract("b1", r2, r0), shifted(rinf, 4, w)), 1, w - 1);
+    Bus c = sliceBus(subtract("h", subtract("h1", rh, shifted(r0, 4, w)), rinf), 1, w - 1);
+    Bus five_a = add("a5", w, a, shifted(a, 2, w));
+    Bus c2 = subtract("c2", subtract("c2a", five_a, b), c);
+    // d = a + c2 - b = -3 * c3; так как 3 * (1 + 4 + ... + 4^(j-1)) = 4^j - 1 = -1 по модулю 2^w при 2j >= w,
+    // c3 = d * (1 + 4)(1 + 16)(1 + 256)... - по одному сумматору со сдвигом на каждый множитель
+    Bus d = subtract("d", add("d1", w, a, c2), b);
+    int step = 0;
+    for (int shift = 2; shift < w; shift *= 2) {
+        d = add("div3_" + to_string(step++), w, d, shifted(d, shift, w));
+    }
+    Bus c3 = d;
+    Bus c1 = subtract("c1", subtract("c1a", a, c2), c3);
+
+    // result = c4 * 2^(4k) + c3 * 2^(3k) + c2 * 2^(2k) + c1 * 2^k + c0; c0 и c4 не пересекаются
+    int cw = split.coefficient_width;
+    vector<Bus> rows = {
+        resizeBus(concatBus(r0, shifted(rinf, 2 * k, 2 * k + 2 * split.high)), width),
+        shifted(sliceBus(c1, 0, cw), k, width),
+        shifted(sliceBus(c2, 0, cw), 2 * k, width),
+        shifted(sliceBus(c3, 0, cw), 3 * k, width),
+    };
+    if (options.carry_save) {
+        int csa_count = 0;
+        while (rows.size() > 2) {
+            string index = to_string(csa_count++);
+            vector<Bus> outputs = netlist.addCell(CellKind::CarrySave, "csa" + index, width, {rows[0], rows[1], rows[2]},
+                                                  {"rec_s" + index, "rec_c" + index});
+            rows.erase(rows.begin(), rows.begin() + 3);
+            rows.insert(rows.end(), outputs.begin(), outputs.end());
+        }
+        netlist.setOutput("product", add("rec_sum", width, rows[0], rows[1]));
+        return;
+    }
+    Bus low = add("rec_low", width, rows[0], rows[1]);
+    Bus high = add("rec_high", width, rows[2], rows[3]);
+    netlist.setOutput("product", add("rec_sum", width, low, high));
+}
+
+// Функция для получения списка соединений тела модуля Карацубы разрядности n (n не умножается напрямую)
+// Без оптимизации список повторяет ячейки generateKaratsubaModuleBody с теми же разрядностями
+Netlist KaratsubaGenerator::moduleNetlist(int n, bool optimize) {
+    Netlist netlist;
+    buildKaratsubaNetlist(n, netlist);
+    if (optimize && options.optimize_netlist && usesNetlist(n)) {
+        netlist.optimize();
+    }
+    return netlist;
+}
+
+// Функция для генерации прямого умножения n x n бит выбранной реализацией базового умножителя
+// В режиме квадратора b совпадает с a, и выводится прямое возведение a в квадрат
+void KaratsubaGenerator::generateBaseMultiplication(int n, const string &a, const string &b, const string &product, ostream &out) {
+    if (options.target != DspTarget::None) {
+        generateDspMultiplicationLogic(n, a, b, product, dspShape(options.target), out);
+    } else if (options.square) {
+        if (options.base == BaseMultiplier::Flat) {
+            generateSquareLogic(n, a, product, out);
         } else {
-            // Рекурсивный вызов для p
-            ss << generateKaratsubaModuleCall(s_width, "s1", "s2", p, module_count);
-        }
-
-        // z1 = p - z2 - z0
-        subtractor_sizes.insert(p_width); // Добавляем размер вычитателя в множество
-        ss << "wire [" << p_width - 1 << ":0] temp_sub1;\n";
-        ss << "subtractor_" << p_width << " sub1 (\n";
-        ss << "    .a(" << p << "),\n";
-        ss << "    .b({{" << (p_width - 2 * m) << "{1'b0}}, " << z2 << "}),\n";
-        ss << "    .diff(temp_sub1)\n";
-        ss << ");\n";
-
-        ss << "wire [" << p_width - 1 << ":0] " << z1 << ";\n";
-        ss << "subtractor_" << p_width << " sub2 (\n";
-        ss << "    .a(temp_sub1),\n";
-        ss << "    .b({{" << (p_width - 2 * n_minus_m) << "{1'b0}}, " << z0 << "}),\n";
-        ss << "    .diff(" << z1 << ")\n";
-        ss << ");\n\n";
-
-        // Сборка конечного произведения
-        int product_width = 2 * n;
-        adder_sizes.insert(product_width); // Добавляем размер сумматора в множество
-        ss << "wire [" << product_width - 1 << ":0] z2_shift = {" << z2 << ", " << (2 * n_minus_m) << "'b0};\n";
-        ss << "wire [" << product_width - 1 << ":0] z1_shift = {" << z1 << ", " << n_minus_m << "'b0};\n";
-        ss << "wire [" << product_width - 1 << ":0] z0_ext = {{" << (product_width - (2 * n_minus_m)) << "{1'b0}}, " << z0 << "};\n";
-
-        ss << "wire [" << product_width - 1 << ":0] temp_sum1;\n";
-        ss << "adder_" << product_width << " adder1 (\n";
-        ss << "    .a(z2_shift),\n";
-        ss << "    .b(z1_shift),\n";
-        ss << "    .sum(temp_sum1)\n";
-        ss << ");\n";
-
-        ss << "adder_" << product_width << " adder2 (\n";
-        ss << "    .a(temp_sum1),\n";
-        ss << "    .b(z0_ext),\n";
-        ss << "    .sum(product)\n";
-        ss << ");\n";
+            generateSquareTreeLogic(n, a, product, options.base, out);
+        }
+    } else if (options.base == BaseMultiplier::Flat) {
+        generateMultiplicationLogic(n, a, b, product, out);
+    } else {
+        generateCompressionTreeLogic(n, a, b, product, options.base, out);
     }
+}
 
-    return ss.str();
+// Функция для генерации модулей, которые использует прямой умножитель разрядности n
+void KaratsubaGenerator::generateBaseDependencies(int n) {
+    if (options.target != DspTarget::None) {
+        if (tileDsp(n, dspShape(options.target)).blocks > 0) {
+            emitDspOnce();
+        }
+    } else if (options.base != BaseMultiplier::Flat) {
+        emitCellsOnce();
+        emitAdderOnce(2 * n);
+    }
+}
+
+// Функция для разбиения операндов x и y на старшие x1, y1 и младшие x0, y0 части
+void KaratsubaGenerator::generateOperandSplit(const KaratsubaSplit &split, const string &x, const string &y, ostream &out) {
+    int n = split.n;
+    int m = split.m;
+    int n_minus_m = split.n_minus_m;
+
+    out << "wire [" << n_minus_m - 1 << ":0] x0 = " << x << "[" << n_minus_m - 1 << ":0];\n";
+    out << "wire [" << m - 1 << ":0] x1 = " << x << "[" << n - 1 << ":" << n_minus_m << "];\n";
+    if (!options.square) {
+        out << "wire [" << n_minus_m - 1 << ":0] y0 = " << y << "[" << n_minus_m - 1 << ":0];\n";
+        out << "wire [" << m - 1 << ":0] y1 = " << y << "[" << n - 1 << ":" << n_minus_m << "];\n";
+    }
+    out << "\n";
+}
+
+// Функция для генерации сумм частей операндов s1 = x1 + x0 и s2 = y1 + y0
+void KaratsubaGenerator::generateOperandSums(const KaratsubaSplit &split, ostream &out) {
+    int m = split.m;
+    int n_minus_m = split.n_minus_m;
+    int s_width = split.s_width;
+
+    // s1 = x1 + x0
+    out << "wire [" << s_width - 1 << ":0] s1;\n";
+    out << "adder_" << s_width << " adder_s1 (\n";
+    out << "    .a({{" << (s_width - m) << "{1'b0}}, x1}),\n";
+    out << "    .b({{" << (s_width - n_minus_m) << "{1'b0}}, x0}),\n";
+    out << "    .sum(s1)\n";
+    out << ");\n";
+    if (options.square) {
+        out << "\n";
+        return;
+    }
+
+    // s2 = y1 + y0
+    out << "wire [" << s_width - 1 << ":0] s2;\n";
+    out << "adder_" << s_width << " adder_s2 (\n";
+    out << "    .a({{" << (s_width - m) << "{1'b0}}, y1}),\n";
+    out << "    .b({{" << (s_width - n_minus_m) << "{1'b0}}, y0}),\n";
+    out << "    .sum(s2)\n";
+    out << ");\n\n";
+}
+
+// Функция для генерации модулей, которые использует сборка результата уровня
+void KaratsubaGenerator::generateRecombinationDependencies(const KaratsubaSplit &split) {
+    if (options.carry_save) {
+        emitCarrySaveAdderOnce(split.product_width);
+    } else {
+        emitSubtractorOnce(split.p_width);
+    }
+    emitAdderOnce(split.product_width);
+}
+
+// Функция для сборки результата уровня: z1 = p - z2 - z0, result = z2 * 2^(2h) + z1 * 2^h + z0
+void KaratsubaGenerator::generateRecombination(const KaratsubaSplit &split, const string &z2, const string &z0,
+                                               const string &p, const string &z1, const string &result, ostream &out) {
+    if (options.carry_save) {
+        generateCarrySaveRecombination(split, z2, z0, p, result, out);
+        return;
+    }
+
+    int m = split.m;
+    int n_minus_m = split.n_minus_m;
+    int p_width = split.p_width;
+
+    // z1 = p - z2 - z0
+    out << "wire [" << p_width - 1 << ":0] temp_sub1;\n";
+    out << "subtractor_" << p_width << " sub1 (\n";
+    out << "    .a(" << p << "),\n";
+    out << "    .b({{" << (p_width - 2 * m) << "{1'b0}}, " << z2 << "}),\n";
+    out << "    .diff(temp_sub1)\n";
+    out << ");\n";
+
+    out << "wire [" << p_width - 1 << ":0] " << z1 << ";\n";
+    out << "subtractor_" << p_width << " sub2 (\n";
+    out << "    .a(temp_sub1),\n";
+    out << "    .b({{" << (p_width - 2 * n_minus_m) << "{1'b0}}, " << z0 << "}),\n";
+    out << "    .diff(" << z1 << ")\n";
+    out << ");\n\n";
+
+    // Сборка конечного произведения
+    int product_width = split.product_width;
+    out << "wire [" << product_width - 1 << ":0] z2_shift = {" << z2 << ", " << (2 * n_minus_m) << "'b0};\n";
+    out << "wire [" << product_width - 1 << ":0] z1_shift = {" << z1 << ", " << n_minus_m << "'b0};\n";
+    out << "wire [" << product_width - 1 << ":0] z0_ext = {{" << (product_width - (2 * n_minus_m)) << "{1'b0}}, " << z0 << "};\n";
+
+    out << "wire [" << product_width - 1 << ":0] temp_sum1;\n";
+    out << "adder_" << product_width << " adder1 (\n";
+    out << "    .a(z2_shift),\n";
+    out << "    .b(z1_shift),\n";
+    out << "    .sum(temp_sum1)\n";
+    out << ");\n";
+
+    out << "adder_" << product_width << " adder2 (\n";
+    out << "    .a(temp_sum1),\n";
+    out << "    .b(z0_ext),\n";
+    out << "    .sum(" << result << ")\n";
+    out << ");\n";
 }
 
 
+// Функция для сборки результата уровня деревом сжатия по модулю 2^(2n):
+// result = {z2, z0} + p * 2^h + ~(z2 * 2^h) + ~(z0 * 2^h) + 2, где ~X + 1 = -X
+// Пять строк сжимаются ячейками 3:2 до двух, которые складываются единственным сумматором
+void KaratsubaGenerator::generateCarrySaveRecombination(const KaratsubaSplit &split, const string &z2, const string &z0,
+                                                        const string &p, const string &result, ostream &out) {
+    int h = split.n_minus_m;
+    int width = split.product_width;
+    string range = "[" + to_string(width - 1) + ":0]";
+
+    vector<string> rows = {"rec_row0", "rec_row1", "rec_row2", "rec_row3", "rec_row4"};
+    out << "wire " << range << " rec_row0 = {" << z2 << ", " << z0 << "};\n";
+    out << "wire " << range << " rec_row1 = {" << p << ", " << h << "'b0};\n";
+    out << "wire " << range << " rec_z2_shift = {" << z2 << ", " << h << "'b0};\n";
+    out << "wire " << range << " rec_z0_shift = {" << z0 << ", " << h << "'b0};\n";
+    out << "wire " << range << " rec_row2 = ~rec_z2_shift;\n";
+    out << "wire " << range << " rec_row3 = ~rec_z0_shift;\n";
+    out << "wire " << range << " rec_row4 = " << width << "'d2;\n";
+
+    // Каждая ячейка 3:2 заменяет три строки двумя, пока строк больше двух
+    int csa_count = 0;
+    while (rows.size() > 2) {
+        vector<string> next;
+        size_t k = 0;
+        for (; k + 3 <= rows.size(); k += 3) {
+            string sum = "rec_s" + to_string(csa_count);
+            string carry = "rec_c" + to_string(csa_count);
+            out << "wire " << range << " " << sum << ", " << carry << ";\n";
+            out << "csa_" << width << " csa" << csa_count << " (\n";
+            out << "    .a(" << rows[k] << "),\n";
+            out << "    .b(" << rows[k + 1] << "),\n";
+            out << "    .c(" << rows[k + 2] << "),\n";
+            out << "    .sum(" << sum << "),\n";
+            out << "    .carry(" << carry << ")\n";
+            out << ");\n";
+            next.push_back(sum);
+            next.push_back(carry);
+            csa_count++;
+        }
+        for (; k < rows.size(); ++k) {
+            next.push_back(rows[k]);
+        }
+        rows = next;
+    }
+
+    out << "adder_" << width << " adder_final (\n";
+    out << "    .a(" << rows[0] << "),\n";
+    out << "    .b(" << rows[1] << "),\n";
+    out << "    .sum(" << result << ")\n";
+    out << ");\n";
+}
+
 // Функция для генерации вызова подмодуля Карацубы
-string generateKaratsubaModuleCall(int n, const string &x, const string &y, const string &product, int &module_count) {
-    stringstream ss;
-    string module_name = "karatsuba_mult_" + to_string(n);
+// Определение подмодуля к этому моменту уже выведено generateKaratsubaDependencies
+void KaratsubaGenerator::generateKaratsubaModuleCall(int n, const string &x, const string &y, const string &product,
+                                                     const string &instance_name, ostream &out) {
+    generateModuleCall(karatsubaName(n), x, options.square ? "" : y, product, instance_name, out);
+}
 
-    // Генерация подмодуля, если он еще не был сгенерирован
-    if (generated_modules.find(n) == generated_modules.end()) {
-        generateKaratsubaModule(n);
+// Функция для генерации вызова модуля умножителя module_name с портами x, y и product
+// Пустой y означает квадратор без входа y
+void KaratsubaGenerator::generateModuleCall(const string &module_name, const string &x, const string &y,
+                                            const string &product, const string &instance_name, ostream &out) {
+    out << module_name << " " << instance_name << " (\n";
+    if (options.pipeline_every > 0) {
+        out << "    .clk(clk),\n";
+        out << "    .rst(rst),\n";
+    }
+    out << "    .x(" << x << "),\n";
+    if (!y.empty()) {
+        out << "    .y(" << y << "),\n";
     }
+    out << "    .product(" << product << ")\n";
+    out << ");\n\n";
+}
 
-    ss << module_name << " mult_" << module_count << " (\n";
-    ss << "    .x(" << x << "),\n";
-    ss << "    .y(" << y << "),\n";
-    ss << "    .product(" << product << ")\n";
-    ss << ");\n\n";
-    module_count++;
+// Функция для генерации линии задержки сигнала signal на cycles тактов
+// Возвращает имя задержанного сигнала; регистры синхронно сбрасываются сигналом rst
+string generateDelayLine(const string &signal, int width, int cycles, ostream &out) {
+    if (cycles <= 0) {
+        return signal;
+    }
 
-    return ss.str();
+    string stage = signal;
+    out << "reg [" << width - 1 << ":0]";
+    for (int i = 1; i <= cycles; ++i) {
+        out << (i == 1 ? " " : ", ") << signal << "_d" << i;
+    }
+    out << ";\n";
+    out << "always @(posedge clk) begin\n";
+    out << "    if (rst) begin\n";
+    for (int i = 1; i <= cycles; ++i) {
+        out << "        " << signal << "_d" << i << " <= 0;\n";
+    }
+    out << "    end else begin\n";
+    for (int i = 1; i <= cycles; ++i) {
+        out << "        " << signal << "_d" << i << " <= " << stage << ";\n";
+        stage = signal + "_d" + to_string(i);
+    }
+    out << "    end\n";
+    out << "end\n\n";
+    return stage;
 }
 
 // Функция для генерации логики умножения для малых значений n
-string generateMultiplicationLogic(int n, const string &a, const string &b, const string &product) {
-    stringstream ss;
-
-    ss << "// Прямое умножение для " << n << "-битных чисел\n";
-    ss << "assign " << product << " = ";
+void generateMultiplicationLogic(int n, const string &a, const string &b, const string &product, ostream &out) {
+    out << "// Прямое умножение для " << n << "-битных чисел\n";
+    out << "assign " << product << " = ";
 
     // Генерируем умножение с помощью побитовых операций и сложения
     bool first_term = true;
@@ -211,120 +1988,670 @@ string generateMultiplicationLogic(int n, const string &a, const string &b, cons
             if (first_term) {
                 first_term = false;
             } else {
-                ss << " + ";
+                out << " + ";
             }
-            ss << "((" << a << "[" << i << "] & " << b << "[" << j << "]) << " << (i + j) << ")";
+            out << "((" << a << "[" << i << "] & " << b << "[" << j << "]) << " << (i + j) << ")";
         }
     }
-    ss << ";\n";
+    out << ";\n";
+}
 
-    return ss.str();
+// Функция для генерации разрядов [lo, hi) произведения для малых значений n
+// Частичные произведения a[i] & b[j] с i + j < lo отбрасываются, а сумма берется по модулю 2^(hi - lo)
+void generateTruncatedMultiplicationLogic(int n, const string &a, const string &b, const string &product, int lo, int hi,
+                                          ostream &out) {
+    out << "// Разряды [" << hi - 1 << ":" << lo << "] прямого умножения для " << n << "-битных чисел\n";
+    out << "assign " << product << " = ";
+    bool first_term = true;
+    for (int i = 0; i < n; ++i) {
+        for (int j = max(0, lo - i); j < n && i + j < hi; ++j) {
+            if (first_term) {
+                first_term = false;
+            } else {
+                out << " + ";
+            }
+            out << "((" << a << "[" << i << "] & " << b << "[" << j << "]) << " << (i + j - lo) << ")";
+        }
+    }
+    out << ";\n";
+}
+
+// Функция для генерации возведения в квадрат для малых значений n
+// Слагаемые a[i] & a[j] и a[j] & a[i] при i < j объединяются в одно со сдвигом i + j + 1,
+// а a[i] & a[i] = a[i], поэтому слагаемых n(n + 1) / 2 вместо n^2
+void generateSquareLogic(int n, const string &a, const string &product, ostream &out) {
+    out << "// Прямое возведение в квадрат для " << n << "-битного числа\n";
+    out << "assign " << product << " = ";
+    for (int i = 0; i < n; ++i) {
+        out << (i > 0 ? " + " : "") << "(" << a << "[" << i << "] << " << 2 * i << ")";
+        for (int j = i + 1; j < n; ++j) {
+            out << " + ((" << a << "[" << i << "] & " << a << "[" << j << "]) << " << i + j + 1 << ")";
+        }
+    }
+    out << ";\n";
 }
 
 // Функция для генерации модуля сумматора
-string generateAdderModule(int n) {
-    stringstream ss;
-    ss << "module adder_" << n << "(\n";
-    ss << "    input [" << n - 1 << ":0] a,\n";
-    ss << "    input [" << n - 1 << ":0] b,\n";
-    ss << "    output [" << n - 1 << ":0] sum\n";
-    ss << ");\n";
+void generateAdderModule(int n, ostream &out) {
+    out << "module adder_" << n << "(\n";
+    out << "    input [" << n - 1 << ":0] a,\n";
+    out << "    input [" << n - 1 << ":0] b,\n";
+    out << "    output [" << n - 1 << ":0] sum\n";
+    out << ");\n";
 
     // Реализация сумматора через побитовые операции
-    ss << "assign sum = a + b;\n"; // Можно заменить на побитовую реализацию при необходимости
+    out << "assign sum = a + b;\n"; // Можно заменить на побитовую реализацию при необходимости
 
-    ss << "endmodule\n";
-    return ss.str();
+    out << "endmodule\n";
 }
 
 // Функция для генерации модуля вычитателя
-string generateSubtractorModule(int n) {
-    stringstream ss;
-    ss << "module subtractor_" << n << "(\n";
-    ss << "    input [" << n - 1 << ":0] a,\n";
-    ss << "    input [" << n - 1 << ":0] b,\n";
-    ss << "    output [" << n - 1 << ":0] diff\n";
-    ss << ");\n";
+void generateSubtractorModule(int n, ostream &out) {
+    out << "module subtractor_" << n << "(\n";
+    out << "    input [" << n - 1 << ":0] a,\n";
+    out << "    input [" << n - 1 << ":0] b,\n";
+    out << "    output [" << n - 1 << ":0] diff\n";
+    out << ");\n";
 
     // Реализация вычитателя через побитовые операции
-    ss << "assign diff = a - b;\n"; // Можно заменить на побитовую реализацию при необходимости
+    out << "assign diff = a - b;\n"; // Можно заменить на побитовую реализацию при необходимости
 
-    ss << "endmodule\n";
-    return ss.str();
+    out << "endmodule\n";
 }
 
 // Функция для генерации тестбенча
-string generateTestbench(int n) {
+// Для конвейерного умножителя тестбенч подает новый вектор каждый такт и сравнивает
+// результат с ожидаемым значением, поданным за латентность тактов до этого
+// Для последовательного умножителя тестбенч подает start, ждет done и проверяет число тактов
+// Если задан файл векторов, операнды и ожидаемые произведения читаются из него через $readmemh,
+// иначе операнды перебираются в цикле: полностью при n <= 8, с шагом - при больших n
+void generateTestbench(int n, ostream &out, const GeneratorOptions &options, const TestbenchVectors &vectors, int m) {
     if (n < 1) 
     {
-        return "";
+        return;
+    }
+    if (options.reduction != ModularReduction::None) {
+        generateModularTestbench(n, out, options, vectors);
+        return;
+    }
+    if (options.stream) {
+        generateStreamTestbench(n, out, options, vectors);
+        return;
     }
-    
-    // Определение шага тестирования
-    int step = (n > 8) ? (1 << (n / 2)) : 1;  // Если n > 8, увеличиваем шаг экспоненциально
-    int MAX = 1 << n; // Максимальное значение для перебора
 
-    stringstream ss;
+    bool folded = options.fold_levels > 0;
+    bool pipelined = options.pipeline_every > 0 && !folded;
+    bool clocked = pipelined || folded;
+    ostream null_stream(nullptr);
+    KaratsubaGenerator generator(null_stream, options);
+    m = m > 0 ? m : n;
+    bool rectangular = m != n;
+    // Квадратор получает только a; b повторяет a, чтобы ожидаемое значение считалось как a * b
+    bool square = options.square && !folded;
+    int latency = generator.latency(n, m);
+    bool from_file = !vectors.filename.empty();
+    // Разрядности второго операнда и произведения: для квадратного умножителя текст не меняется
+    string y_range = rectangular ? "[M-1:0]" : "[N-1:0]";
+    string product_range = rectangular ? "[N+M-1:0]" : "[2*N-1:0]";
+    // Младшая половина сравнивается с младшими N битами x * y, старшая - с floor(x * y / 2^T)
+    // с ошибкой от 0 до MAX_ERROR; expected всегда хранит полное произведение
+    bool low_half = options.half == ProductHalf::Low;
+    bool high_half = options.half == ProductHalf::High;
+    int threshold = high_half ? generator.highThreshold(n) : 0;
+    string output_range = low_half ? "[N-1:0]" : high_half ? "[2*N-T-1:0]" : product_range;
+    string mismatch = low_half    ? "product !== expected[N-1:0]"
+                      : high_half ? "^product === 1'bx || (expected >> T) < product || (expected >> T) - product > MAX_ERROR"
+                                  : "product !== expected";
+    string top = folded ? "karatsuba_seq_" + to_string(n)
+                 : low_half  ? KaratsubaGenerator::lowName(n)
+                 : high_half ? KaratsubaGenerator::highName(n, threshold)
+                 : square    ? generator.karatsubaName(n)
+                             : multiplierName(n, m);
+    if (low_half) {
+        latency = generator.lowLatency(n);
+    } else if (high_half) {
+        latency = generator.highLatency(n, threshold);
+    }
+
+    // Определение шага тестирования: при n > 8 перебирается не больше 64 значений каждого операнда
+    // Границы записываются выражениями Verilog, поэтому не переполняются при n >= 31
+    auto loop_step = [](int width) {
+        int step_bits = (width > 8) ? max(width / 2, width - 6) : 0;
+        return step_bits < 31 ? to_string(1 << step_bits) : "{1'b1, {" + to_string(step_bits) + "{1'b0}}}";
+    };
+    string step = loop_step(n);
+    string step_y = loop_step(m);
+    // Ожидаемое значение в задачах apply_vector: из файла или произведение операндов
+    string vector_args = "input [N-1:0] va, input " + y_range + " vb" + (from_file ? ", input " + product_range + " vp" : "");
+    string vector_product = from_file ? "vp" : "va * vb";
+
+    out << "`timescale 1ns / 1ps\n\n";
+    out << "module tb_karatsuba_" << (square ? "square_" : "multiplier_") << n << (rectangular ? "_" + to_string(m) : "")
+        << ";\n\n";
+
+    out << "    // Параметры\n";
+    out << "    parameter N = " << n << ";\n";
+    if (rectangular) {
+        out << "    parameter M = " << m << ";\n";
+    }
+    if (from_file) {
+        out << "    parameter VECTORS = " << vectors.count << ";\n";
+    } else {
+        out << "    parameter [N:0] MAX = {1'b1, {N{1'b0}}};\n";
+        if (rectangular) {
+            out << "    parameter [M:0] MAX_Y = {1'b1, {M{1'b0}}};\n";
+        }
+    }
+    if (high_half) {
+        out << "    parameter T = " << threshold << ";\n";
+        out << "    parameter [2*N-T-1:0] MAX_ERROR = " << 2 * n - threshold << "'h"
+            << (generator.highErrorBound(n, threshold) >> threshold).toHex() << ";\n";
+    }
+    if (pipelined) {
+        out << "    parameter LATENCY = " << latency << ";\n";
+    }
+    if (folded) {
+        out << "    parameter CYCLES = " << generator.cycles(n) << ";\n";
+    }
+    out << "\n";
+
+    out << "    // Входные сигналы\n";
+    out << "    reg [N-1:0] a;\n";
+    out << "    reg " << y_range << " b;\n";
+    if (clocked) {
+        out << "    reg clk;\n";
+        out << "    reg rst;\n";
+    }
+    if (folded) {
+        out << "    reg start;\n";
+    }
+    out << "\n";
+
+    out << "    // Выходной сигнал\n";
+    out << "    wire " << output_range << " product;\n";
+    if (folded) {
+        out << "    wire done;\n";
+    }
+    out << "\n";
+
+    out << "    // Инстанцирование модуля умножителя\n";
+    out << "    " << top << " uut (\n";
+    if (clocked) {
+        out << "        .clk(clk),\n";
+        out << "        .rst(rst),\n";
+    }
+    if (folded) {
+        out << "        .start(start),\n";
+    }
+    out << "        .x(a),\n";
+    if (!square) {
+        out << "        .y(b),\n";
+    }
+    if (folded) {
+        out << "        .product(product),\n";
+        out << "        .done(done)\n";
+    } else {
+        out << "        .product(product)\n";
+    }
+    out << "    );\n\n";
+
+    out << "    // Процедура тестирования\n";
+    if (from_file) {
+        out << "    integer i, errors;\n";
+        out << "    // Векторы: x, y и x * y подряд\n";
+        out << "    reg " << product_range << " vector_mem [0:3*VECTORS-1];\n";
+    } else {
+        out << (rectangular ? "    reg [N:0] i;\n    reg [M:0] j;\n" : square ? "    reg [N:0] i;\n" : "    reg [N:0] i, j;\n");
+        out << "    integer errors;\n";
+    }
+    out << "    reg " << product_range << " expected;\n\n";
+
+    if (clocked) {
+        out << "    // Тактовый сигнал\n";
+        out << "    always #5 clk = ~clk;\n\n";
+    }
+
+    if (pipelined) {
+        out << "    // Ожидаемые произведения последних LATENCY + 1 поданных векторов\n";
+        out << "    reg " << product_range << " expected_pipe [0:LATENCY];\n";
+        out << "    integer applied, k;\n\n";
+
+        out << "    // Подача вектора и проверка результата для вектора, поданного LATENCY тактов назад\n";
+        out << "    task apply_vector(" << vector_args << ");\n";
+        out << "        begin\n";
+        out << "            for (k = LATENCY; k > 0; k = k - 1) begin\n";
+        out << "                expected_pipe[k] = expected_pipe[k - 1];\n";
+        out << "            end\n";
+        out << "            a = va;\n";
+        out << "            b = vb;\n";
+        out << "            expected_pipe[0] = " << vector_product << ";\n";
+        out << "            applied = applied + 1;\n";
+        out << "            #1;\n";
+        out << "            expected = expected_pipe[LATENCY];\n";
+        out << "            if (applied > LATENCY && " << (high_half ? "(" + mismatch + ")" : mismatch) << ") begin\n";
+        out << "                $display(\"Mismatch! product=%d, expected=%d\", product, expected);\n";
+        out << "                errors = errors + 1;\n";
+        out << "            end\n";
+        out << "            @(posedge clk);\n";
+        out << "            #1;\n";
+        out << "        end\n";
+        out << "    endtask\n\n";
+    }
+
+    if (folded) {
+        out << "    integer cycles;\n\n";
+
+        out << "    // Запуск умножения и проверка результата и числа тактов до done\n";
+        out << "    task apply_vector(" << vector_args << ");\n";
+        out << "        begin\n";
+        out << "            a = va;\n";
+        out << "            b = vb;\n";
+        out << "            expected = " << vector_product << ";\n";
+        out << "            start = 1;\n";
+        out << "            @(posedge clk);\n";
+        out << "            #1;\n";
+        out << "            start = 0;\n";
+        out << "            cycles = 0;\n";
+        out << "            while (!done && cycles <= CYCLES) begin\n";
+        out << "                @(posedge clk);\n";
+        out << "                #1;\n";
+        out << "                cycles = cycles + 1;\n";
+        out << "            end\n";
+        out << "            if (product !== expected || cycles != CYCLES) begin\n";
+        out << "                $display(\"Mismatch! a=%d, b=%d, product=%d, expected=%d, cycles=%d\", a, b, product, expected, cycles);\n";
+        out << "                errors = errors + 1;\n";
+        out << "            end\n";
+        out << "        end\n";
+        out << "    endtask\n\n";
+    }
+
+    out << "    initial begin\n";
+    out << "        // Инициализация\n";
+    out << "        a = 0;\n";
+    out << "        b = 0;\n";
+    out << "        errors = 0;\n";
+    if (from_file) {
+        out << "        $readmemh(\"" << vectors.filename << "\", vector_mem);\n";
+    }
+    out << "\n";
+
+    if (clocked) {
+        out << "        // Сброс " << (folded ? "автомата" : "конвейера") << "\n";
+        out << "        clk = 0;\n";
+        out << "        rst = 1;\n";
+        out << (folded ? "        start = 0;\n" : "        applied = 0;\n");
+        out << "        repeat (2) @(posedge clk);\n";
+        out << "        #1;\n";
+        out << "        rst = 0;\n\n";
+    } else {
+        out << "        // Временная задержка\n";
+        out << "        #10;\n\n";
+    }
+
+    if (from_file) {
+        out << "        // Векторы из файла\n";
+        out << "        for (i = 0; i < VECTORS; i = i + 1) begin\n";
+        if (clocked) {
+            out << "            apply_vector(vector_mem[3*i], vector_mem[3*i+1], vector_mem[3*i+2]);\n";
+        } else {
+            out << "            a = vector_mem[3*i];\n";
+            out << "            b = vector_mem[3*i+1];\n";
+            out << "            expected = vector_mem[3*i+2];\n";
+            out << "            #1;\n";
+            out << "            if (" << mismatch << ") begin\n";
+            out << "                $display(\"Mismatch! a=%h, b=%h, product=%h, expected=%h\", a, b, product, expected);\n";
+            out << "                errors = errors + 1;\n";
+            out << "            end\n";
+        }
+        out << "        end\n\n";
+    } else if (square) {
+        out << "        // Тестирование с шагом " << step << "\n";
+        out << "        for (i = 0; i < MAX; i = i + " << step << ") begin\n";
+        if (clocked) {
+            out << "            apply_vector(i, i);\n";
+        } else {
+            out << "            a = i;\n";
+            out << "            b = i;\n";
+            out << "            expected = i * i;\n";
+            out << "            #1;\n";
+            out << "            if (" << mismatch << ") begin\n";
+            out << "                $display(\"Mismatch! a=%d, product=%d, expected=%d\", a, product, expected);\n";
+            out << "                errors = errors + 1;\n";
+            out << "            end\n";
+        }
+        out << "        end\n\n";
+    } else {
+        out << "        // Тестирование с шагом " << step << (rectangular ? " по x и " + step_y + " по y" : "") << "\n";
+        out << "        for (i = 0; i < MAX; i = i + " << step << ") begin\n";
+        out << "            for (j = 0; j < " << (rectangular ? "MAX_Y" : "MAX") << "; j = j + " << step_y << ") begin\n";
+        if (clocked) {
+            out << "                apply_vector(i, j);\n";
+        } else {
+            out << "                a = i;\n";
+            out << "                b = j;\n";
+            out << "                expected = i * j;\n";
+            out << "                #1;\n";
+            out << "                if (" << mismatch << ") begin\n";
+            out << "                    $display(\"Mismatch! a=%d, b=%d, product=%d, expected=%d\", a, b, product, expected);\n";
+            out << "                    errors = errors + 1;\n";
+            out << "                end\n";
+        }
+        out << "            end\n";
+        out << "        end\n\n";
+    }
+
+    if (pipelined) {
+        out << "        // Проверка результатов, оставшихся в конвейере\n";
+        out << "        repeat (LATENCY) apply_vector(" << (from_file ? "0, 0, 0" : "0, 0") << ");\n\n";
+    }
+
+    out << "        // Вывод результата\n";
+    out << "        if (errors == 0) begin\n";
+    out << "            $display(\"All tests passed.\");\n";
+    out << "        end else begin\n";
+    out << "            $display(\"Errors found: %d.\", errors);\n";
+    out << "        end\n";
+
+    out << "        $finish;\n";
+    out << "    end\n\n";
+
+    out << "endmodule\n";
+}
+
+// Функция для генерации тестбенча модульного умножителя montgomery_mult_n или barrett_mult_n
+// Векторы всегда читаются из файла: эталон x * y * 2^-n mod M или x * y mod M считается генератором
+// векторов на BigUint. Без постоянного модуля в каждом векторе свои модуль и константа редукции.
+// Каждый такт подается новый вектор, результат сравнивается с ожидаемым через LATENCY тактов
+void generateModularTestbench(int n, ostream &out, const GeneratorOptions &options, const TestbenchVectors &vectors) {
+    ostream null_stream(nullptr);
+    KaratsubaGenerator generator(null_stream, options);
+    bool pipelined = options.pipeline_every > 0;
+    bool fixed = !options.modulus.isZero();
+    string module_name = modularName(options.reduction, n);
+    string constant_port = reductionConstantPort(options.reduction);
+    int constant_width = reductionConstantWidth(options.reduction, n);
+    int words = fixed ? 3 : 5;
+
+    out << "`timescale 1ns / 1ps\n\n";
+    out << "module tb_" << module_name << ";\n\n";
+
+    out << "    // Параметры\n";
+    out << "    parameter N = " << n << ";\n";
+    out << "    parameter VECTORS = " << vectors.count << ";\n";
+    out << "    parameter LATENCY = " << (pipelined ? generator.modularLatency(n) : 0) << ";\n\n";
+
+    out << "    // Входные сигналы\n";
+    out << "    reg [N-1:0] a;\n";
+    out << "    reg [N-1:0] b;\n";
+    if (!fixed) {
+        out << "    reg [N-1:0] modulus;\n";
+        out << "    reg [" << (constant_width > n ? "N" : "N-1") << ":0] " << constant_port << ";\n";
+    }
+    out << "    reg clk;\n";
+    if (pipelined) {
+        out << "    reg rst;\n";
+    }
+    out << "\n";
+
+    out << "    // Выходной сигнал\n";
+    out << "    wire [N-1:0] product;\n\n";
+
+    out << "    // Инстанцирование модульного умножителя\n";
+    out << "    " << module_name << " uut (\n";
+    if (pipelined) {
+        out << "        .clk(clk),\n";
+        out << "        .rst(rst),\n";
+    }
+    out << "        .x(a),\n";
+    out << "        .y(b),\n";
+    if (!fixed) {
+        out << "        .modulus(modulus),\n";
+        out << "        ." << constant_port << "(" << constant_port << "),\n";
+    }
+    out << "        .product(product)\n";
+    out << "    );\n\n";
+
+    out << "    // Процедура тестирования\n";
+    out << "    integer i, k, applied, errors;\n";
+    out << "    // Векторы: x, y" << (fixed ? "" : ", модуль, " + constant_port) << " и ожидаемый результат подряд\n";
+    out << "    reg [N:0] vector_mem [0:" << words << "*VECTORS-1];\n";
+    out << "    // Ожидаемые результаты последних LATENCY + 1 поданных векторов\n";
+    out << "    reg [N-1:0] expected_pipe [0:LATENCY];\n";
+    out << "    reg [N-1:0] expected;\n\n";
+
+    out << "    // Тактовый сигнал\n";
+    out << "    always #5 clk = ~clk;\n\n";
+
+    out << "    // Подача вектора i и проверка результата для вектора, поданного LATENCY тактов назад;\n";
+    out << "    // i >= VECTORS подает нули, чтобы вытолкнуть результаты из конвейера\n";
+    out << "    task apply_vector(input integer index);\n";
+    out << "        begin\n";
+    out << "            for (k = LATENCY; k > 0; k = k - 1) begin\n";
+    out << "                expected_pipe[k] = expected_pipe[k - 1];\n";
+    out << "            end\n";
+    out << "            a = index < VECTORS ? vector_mem[" << words << "*index] : 0;\n";
+    out << "            b = index < VECTORS ? vector_mem[" << words << "*index+1] : 0;\n";
+    if (!fixed) {
+        out << "            modulus = index < VECTORS ? vector_mem[" << words << "*index+2] : 0;\n";
+        out << "            " << constant_port << " = index < VECTORS ? vector_mem[" << words << "*index+3] : 0;\n";
+    }
+    out << "            expected_pipe[0] = index < VECTORS ? vector_mem[" << words << "*index+" << words - 1 << "] : 0;\n";
+    out << "            applied = applied + 1;\n";
+    out << "            #1;\n";
+    out << "            expected = expected_pipe[LATENCY];\n";
+    out << "            if (applied > LATENCY && product !== expected) begin\n";
+    out << "                $display(\"Mismatch! product=%h, expected=%h\", product, expected);\n";
+    out << "                errors = errors + 1;\n";
+    out << "            end\n";
+    out << "            @(posedge clk);\n";
+    out << "            #1;\n";
+    out << "        end\n";
+    out << "    endtask\n\n";
+
+    out << "    initial begin\n";
+    out << "        // Инициализация\n";
+    out << "        errors = 0;\n";
+    out << "        applied = 0;\n";
+    out << "        clk = 0;\n";
+    out << "        $readmemh(\"" << vectors.filename << "\", vector_mem);\n";
+    if (pipelined) {
+        out << "\n";
+        out << "        // Сброс конвейера\n";
+        out << "        rst = 1;\n";
+        out << "        repeat (2) @(posedge clk);\n";
+        out << "        #1;\n";
+        out << "        rst = 0;\n";
+    }
+    out << "\n";
+
+    out << "        // Векторы из файла и LATENCY пустых векторов\n";
+    out << "        for (i = 0; i < VECTORS + LATENCY; i = i + 1) begin\n";
+    out << "            apply_vector(i);\n";
+    out << "        end\n\n";
+
+    out << "        // Вывод результата\n";
+    out << "        if (errors == 0) begin\n";
+    out << "            $display(\"All tests passed.\");\n";
+    out << "        end else begin\n";
+    out << "            $display(\"Errors found: %d.\", errors);\n";
+    out << "        end\n";
+
+    out << "        $finish;\n";
+    out << "    end\n\n";
+
+    out << "endmodule\n";
+}
+
+// Функция для генерации тестбенча потоковой обертки karatsuba_stream_n
+// Векторы всегда читаются из файла. Входы меняются через 1 нс после фронта, рукопожатия проверяются на спаде;
+// s_valid и данные держатся до приема. Первые FULL_CYCLES тактов (половина векторов, но не меньше
+// 2 * (LATENCY + 1)) векторы подаются без пауз при m_ready = 1: s_ready не должен сниматься, а первый результат без аккумулятора приходит через LATENCY тактов.
+// Дальше s_valid и m_ready пропадают случайно, результаты сверяются с ожидаемой очередью
+void generateStreamTestbench(int n, ostream &out, const GeneratorOptions &options, const TestbenchVectors &vectors) {
+    ostream null_stream(nullptr);
+    KaratsubaGenerator generator(null_stream, options);
+    bool accumulate = options.accumulator_bits > 0;
+
+    out << "`timescale 1ns / 1ps\n\n";
+    out << "module tb_karatsuba_stream_" << n << ";\n\n";
+
+    out << "    // Параметры\n";
+    out << "    parameter N = " << n << ";\n";
+    out << "    parameter W = " << 2 * n + options.accumulator_bits << ";\n";
+    out << "    parameter VECTORS = " << vectors.count << ";\n";
+    out << "    parameter LATENCY = " << generator.streamLatency(n) << ";\n";
+    out << "    // Предел числа тактов, чтобы пропавший результат не подвешивал тестбенч\n";
+    out << "    parameter LIMIT = 4 * (VECTORS + LATENCY) + 64;\n";
+    out << "    // Такты без пауз: первый результат выходит до пауз m_ready, а прием проверяется дольше задержки\n";
+    out << "    parameter FULL_CYCLES = VECTORS / 2 > 2 * (LATENCY + 1) ? VECTORS / 2 : 2 * (LATENCY + 1);\n\n";
+
+    out << "    // Входные сигналы\n";
+    out << "    reg clk, rst;\n";
+    out << "    reg s_valid, s_last, m_ready;\n";
+    out << "    reg [N-1:0] x, y;\n\n";
+
+    out << "    // Выходные сигналы\n";
+    out << "    wire s_ready, m_valid, m_last;\n";
+    out << "    wire [W-1:0] product;\n\n";
+
+    out << "    // Инстанцирование потоковой обертки\n";
+    out << "    karatsuba_stream_" << n << " uut (\n";
+    out << "        .clk(clk),\n";
+    out << "        .rst(rst),\n";
+    out << "        .s_valid(s_valid),\n";
+    out << "        .s_ready(s_ready),\n";
+    out << "        .s_last(s_last),\n";
+    out << "        .x(x),\n";
+    out << "        .y(y),\n";
+    out << "        .m_valid(m_valid),\n";
+    out << "        .m_ready(m_ready),\n";
+    out << "        .m_last(m_last),\n";
+    out << "        .product(product)\n";
+    out << "    );\n\n";
+
+    out << "    // Процедура тестирования\n";
+    out << "    integer sent, received, expected_count, cycle, first_output, errors, seed;\n";
+    out << "    reg accepted;\n";
+    out << "    reg [2*N-1:0] vector_mem [0:3*VECTORS-1];\n";
+    out << "    // Ожидаемые результаты в порядке выдачи и признаки m_last\n";
+    out << "    reg [W-1:0] expected_mem [0:VECTORS-1];\n";
+    out << "    reg expected_last [0:VECTORS-1];\n";
+    if (accumulate) {
+        out << "    reg [W-1:0] acc_model;\n";
+    }
+    out << "\n";
 
-    ss << "`timescale 1ns / 1ps\n\n";
-    ss << "module tb_karatsuba_multiplier_" << n << ";\n\n";
-
-    ss << "    // Параметры\n";
-    ss << "    parameter N = " << n << ";\n";
-    ss << "    parameter MAX = " << MAX << ";\n\n";
-
-    ss << "    // Входные сигналы\n";
-    ss << "    reg [N-1:0] a;\n";
-    ss << "    reg [N-1:0] b;\n\n";
-
-    ss << "    // Выходной сигнал\n";
-    ss << "    wire [2*N-1:0] product;\n\n";
-
-    ss << "    // Инстанцирование модуля умножителя\n";
-    ss << "    karatsuba_mult_" << n << " uut (\n";
-    ss << "        .x(a),\n";
-    ss << "        .y(b),\n";
-    ss << "        .product(product)\n";
-    ss << "    );\n\n";
-
-    ss << "    // Процедура тестирования\n";
-    ss << "    integer i, j, errors;\n";
-    ss << "    reg [2*N-1:0] expected;\n\n";
-
-    ss << "    initial begin\n";
-    ss << "        // Инициализация\n";
-    ss << "        a = 0;\n";
-    ss << "        b = 0;\n";
-    ss << "        errors = 0;\n\n";
-
-    ss << "        // Временная задержка\n";
-    ss << "        #10;\n\n";
-
-    ss << "        // Тестирование с шагом " << step << "\n";
-    ss << "        for (i = 0; i < MAX; i = i + " << step << ") begin\n";
-    ss << "            for (j = 0; j < MAX; j = j + " << step << ") begin\n";
-    ss << "                a = i;\n";
-    ss << "                b = j;\n";
-    ss << "                expected = i * j;\n";
-    ss << "                #1;\n";
-    ss << "                if (product !== expected) begin\n";
-    ss << "                    $display(\"Mismatch! a=%d, b=%d, product=%d, expected=%d\", a, b, product, expected);\n";
-    ss << "                    errors = errors + 1;\n";
-    ss << "                end\n";
-    ss << "            end\n";
-    ss << "        end\n\n";
-
-    ss << "        // Вывод результата\n";
-    ss << "        if (errors == 0) begin\n";
-    ss << "            $display(\"All tests passed.\");\n";
-    ss << "        end else begin\n";
-    ss << "            $display(\"Errors found: %d.\", errors);\n";
-    ss << "        end\n";
-
-    ss << "        $finish;\n";
-    ss << "    end\n\n";
-
-    ss << "endmodule\n";
+    out << "    // Тактовый сигнал\n";
+    out << "    always #5 clk = ~clk;\n\n";
 
+    out << "    initial begin\n";
+    out << "        // Инициализация\n";
+    out << "        errors = 0;\n";
+    out << "        sent = 0;\n";
+    out << "        received = 0;\n";
+    out << "        expected_count = 0;\n";
+    out << "        first_output = -1;\n";
+    out << "        seed = 1;\n";
+    if (accumulate) {
+        out << "        acc_model = 0;\n";
+    }
+    out << "        clk = 0;\n";
+    out << "        s_valid = 0;\n";
+    out << "        s_last = 0;\n";
+    out << "        m_ready = 0;\n";
+    out << "        x = 0;\n";
+    out << "        y = 0;\n";
+    out << "        $readmemh(\"" << vectors.filename << "\", vector_mem);\n\n";
+
+    out << "        // Сброс\n";
+    out << "        rst = 1;\n";
+    out << "        repeat (2) @(posedge clk);\n";
+    out << "        #1;\n";
+    out << "        rst = 0;\n\n";
+
+    out << "        for (cycle = 0; (sent < VECTORS || received < expected_count) && cycle < LIMIT; cycle = cycle + 1) begin\n";
+    out << "            // Новый вектор выставляется только после приема предыдущего\n";
+    out << "            if (!s_valid && sent < VECTORS && (cycle < FULL_CYCLES || ($random(seed) & 3) != 0)) begin\n";
+    out << "                x = vector_mem[3*sent];\n";
+    out << "                y = vector_mem[3*sent+1];\n";
+    out << "                s_last = sent == VECTORS - 1 || ($random(seed) & 3) == 0;\n";
+    out << "                s_valid = 1;\n";
+    out << "            end\n";
+    out << "            m_ready = cycle < FULL_CYCLES || ($random(seed) & 3) != 0;\n\n";
+
+    out << "            @(negedge clk);\n";
+    out << "            if (cycle < FULL_CYCLES && !s_ready) begin\n";
+    out << "                $display(\"Backpressure! s_ready=0 at cycle %0d with m_ready=1\", cycle);\n";
+    out << "                errors = errors + 1;\n";
+    out << "            end\n";
+    out << "            if (m_valid && m_ready) begin\n";
+    out << "                if (received >= expected_count) begin\n";
+    out << "                    $display(\"Unexpected result! product=%h at cycle %0d\", product, cycle);\n";
+    out << "                    errors = errors + 1;\n";
+    out << "                end else if (product !== expected_mem[received] || m_last !== expected_last[received]) begin\n";
+    out << "                    $display(\"Mismatch! product=%h, m_last=%b, expected=%h, expected m_last=%b\",\n";
+    out << "                             product, m_last, expected_mem[received], expected_last[received]);\n";
+    out << "                    errors = errors + 1;\n";
+    out << "                end\n";
+    out << "                if (received == 0) begin\n";
+    out << "                    first_output = cycle;\n";
+    out << "                end\n";
+    out << "                received = received + 1;\n";
+    out << "            end\n";
+    out << "            accepted = s_valid && s_ready;\n";
+    out << "            if (accepted) begin\n";
+    if (accumulate) {
+        out << "                acc_model = acc_model + vector_mem[3*sent+2];\n";
+        out << "                if (s_last) begin\n";
+        out << "                    expected_mem[expected_count] = acc_model;\n";
+        out << "                    expected_last[expected_count] = 1;\n";
+        out << "                    expected_count = expected_count + 1;\n";
+        out << "                    acc_model = 0;\n";
+        out << "                end\n";
+    } else {
+        out << "                expected_mem[expected_count] = vector_mem[3*sent+2];\n";
+        out << "                expected_last[expected_count] = s_last;\n";
+        out << "                expected_count = expected_count + 1;\n";
+    }
+    out << "                sent = sent + 1;\n";
+    out << "            end\n\n";
+
+    out << "            @(posedge clk);\n";
+    out << "            #1;\n";
+    out << "            if (accepted) begin\n";
+    out << "                s_valid = 0;\n";
+    out << "            end\n";
+    out << "        end\n\n";
+
+    out << "        // Проверка числа результатов и задержки первого из них\n";
+    out << "        if (sent < VECTORS || received < expected_count) begin\n";
+    out << "            $display(\"Timeout! sent=%0d of %0d, received=%0d of %0d\", sent, VECTORS, received, expected_count);\n";
+    out << "            errors = errors + 1;\n";
+    out << "        end\n";
+    if (!accumulate) {
+        out << "        if (VECTORS > 0 && first_output != LATENCY) begin\n";
+        out << "            $display(\"Latency! first result at cycle %0d, expected %0d\", first_output, LATENCY);\n";
+        out << "            errors = errors + 1;\n";
+        out << "        end\n";
+    }
+    out << "\n";
+
+    out << "        // Вывод результата\n";
+    out << "        if (errors == 0) begin\n";
+    out << "            $display(\"All tests passed.\");\n";
+    out << "        end else begin\n";
+    out << "            $display(\"Errors found: %d.\", errors);\n";
+    out << "        end\n";
+
+    out << "        $finish;\n";
+    out << "    end\n\n";
+
+    out << "endmodule\n";
+}
+
+// Функция для генерации тестбенча в виде строки
+string generateTestbench(int n, const GeneratorOptions &options, const TestbenchVectors &vectors, int m) {
+    stringstream ss;
+    generateTestbench(n, ss, options, vectors, m);
     return ss.str();
-}
\ No newline at end of file
+}
@@ -1,17 +1,276 @@
 #ifndef VERILOG_GENERATOR_H
 #define VERILOG_GENERATOR_H
 
+#include <functional>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <set>
 #include <string>
+#include <vector>
+#include "module_cache.h"
+#include "cost_model.h"
+#include "multiplier_tree.h"
+#include "adder_generator.h"
+#include "netlist.h"
+#include "modular_reduction.h"
+#include "parameterized_generator.h"
+#include "dsp_target.h"
 using namespace std;
 
+// Часть произведения, которую вычисляет верхний модуль
+enum class ProductHalf {
+    Full,  // Все 2N бит: karatsuba_mult_N
+    Low,   // Младшая половина x * y mod 2^N: karatsuba_low_N
+    High   // Приближенные старшие N бит и защитные биты под ними: karatsuba_high_N_T
+};
+
+// Параметры генератора
+struct GeneratorOptions {
+    string cache_dir;   // Папка дискового кэша модулей; пустая строка отключает кэш
+    int cutoff = 2;     // Разрядности не больше cutoff умножаются напрямую, без рекурсии
+    bool auto_cutoff = false; // Выбор между рекурсией и прямым умножением по модели стоимости
+    OptimizationGoal goal = OptimizationGoal::Area; // Критерий модели стоимости
+    BaseMultiplier base = BaseMultiplier::Flat; // Реализация прямых умножителей
+    DspTarget target = DspTarget::None; // Блок DSP для прямых умножителей; рекурсия останавливается там,
+                                        // где покрытие блоками дешевле уровня Карацубы
+    AdderSelection adders;   // Архитектуры сумматоров и вычитателей по разрядностям
+    bool carry_save = false; // Сборка результата уровня одним деревом сжатия и одним сумматором
+    bool optimize_netlist = false; // Тела модулей Карацубы строятся списком соединений и оптимизируются
+    int pipeline_every = 0;  // Регистры на выходах модулей каждые pipeline_every уровней; 0 - без конвейера
+    int pipeline_stages = 0; // Желаемое число ступеней конвейера; пересчитывается в pipeline_every
+    int fold_levels = 0;     // Число уровней последовательного режима; 0 - комбинационный умножитель
+    int fold_min_width = 0;  // Последовательно вычисляются только разрядности больше fold_min_width
+    bool square = false;     // Квадраторы karatsuba_square_n с одним входом x вместо умножителей
+    int toom_min_width = 0;  // Уровни разрядности не меньше toom_min_width делятся на три части (Toom-3)
+    bool toom_auto = false;  // Выбор между Toom-3 и Карацубой для каждого уровня по модели стоимости
+    ModularReduction reduction = ModularReduction::None; // Верхний модуль - модульный умножитель
+    ProductHalf half = ProductHalf::Full; // Часть произведения верхнего модуля
+    int guard_bits = -1;     // Защитные биты старшей половины; -1 - наименьшее число, при котором ошибка меньше 2^N
+    BigUint modulus;         // Постоянный модуль редукции; 0 - модуль и константа редукции подаются на входы
+    bool stream = false;     // Верхний модуль - потоковая обертка karatsuba_stream_N с интерфейсом valid/ready
+    int accumulator_bits = 0; // Защитные биты аккумулятора пачки потоковой обертки; 0 - без аккумулятора
+    bool parameterized = false; // Одно параметризованное определение karatsuba_mult #(.N()) на все разрядности;
+                                // karatsuba_mult_N - обертка над ним
+
+    // Ключ параметров, влияющих на текст модулей; используется для кэширования
+    string key() const;
+    // Полный ключ параметров, включая меняющие только имена модулей и верхний модуль, и параметры
+    // до пересчета по разрядности; записывается в манифест папки модулей
+    string manifestKey() const;
+    // Пересчет pipeline_stages в pipeline_every для умножителя разрядности n
+    void resolvePipelineStages(int n);
+    // Пересчет fold_levels в fold_min_width для умножителя разрядности n
+    void resolveFolding(int n);
+};
+
+// Разбиение широкого операнда прямоугольного умножителя на части разрядности узкого
+struct RectangularSplit {
+    int wide;        // Разрядность широкого операнда
+    int narrow;      // Разрядность узкого операнда
+    int parts;       // Число частей широкого операнда
+    int last_width;  // Разрядность старшей части (не больше narrow)
+};
+
+RectangularSplit splitRectangular(int n, int m);
+// Имя модуля умножителя: karatsuba_mult_n для n == m, иначе karatsuba_mult_n_m
+string multiplierName(int n, int m);
+
+// Параметры разбиения одного уровня алгоритма Карацубы
+struct KaratsubaSplit {
+    int n;              // Разрядность операндов уровня
+    int m;              // Разрядность старших частей x1, y1
+    int n_minus_m;      // Разрядность младших частей x0, y0
+    int s_width;        // Разрядность сумм s1 = x1 + x0, s2 = y1 + y0
+    int p_width;        // Разрядность произведения p = s1 * s2
+    int product_width;  // Разрядность результата уровня
+    bool p_recursive;   // true, если p вычисляется подмодулем Карацубы
+};
+
+KaratsubaSplit splitKaratsuba(int n);
+
+// Параметры разбиения одного уровня Toom-Cook-3: x = x2 * 2^(2k) + x1 * 2^k + x0
+// Произведения считаются в точках 0, 1, 2, 1/2 и бесконечность, поэтому все значения беззнаковые
+struct ToomSplit {
+    int n;                    // Разрядность операндов уровня
+    int k;                    // Разрядность младших частей x0, x1
+    int high;                 // Разрядность старшей части x2
+    int sum_width;            // Разрядность x(1) = x0 + x1 + x2
+    int point_width;          // Разрядность x(2) = x0 + 2x1 + 4x2 и 4x(1/2) = 4x0 + 2x1 + x2
+    int interpolation_width;  // Интерполяция считается по модулю 2^interpolation_width
+    int coefficient_width;    // Разрядность коэффициентов c1, c2, c3 произведения
+    int product_width;        // Разрядность результата уровня
+    bool valid;               // true, если все пять произведений уже n и старшая часть не пуста
+};
+
+ToomSplit splitToom3(int n);
+
+// Подмодуль уровня модуля старшей половины: произведение частей x и y разрядности width со сдвигом offset
+// Подмодуль собирает частичные произведения веса не меньше 2^threshold; при threshold <= 0 это полный
+// умножитель karatsuba_mult_width
+struct HighTerm {
+    int width;
+    int threshold;
+    int offset;
+    string x;
+    string y;
+    string name;
+};
+
+// Контекст генерации: хранит множества уже выведенных модулей, поэтому
+// разные экземпляры независимы и могут работать параллельно в разных потоках
+class KaratsubaGenerator {
+public:
+    explicit KaratsubaGenerator(ostream &out, const GeneratorOptions &options = GeneratorOptions());
+
+    // Генерация умножителя разрядности n вместе со всеми еще не выведенными подмодулями
+    // В последовательном режиме верхним модулем будет karatsuba_seq_n с сигналами start/done,
+    // в режиме квадратора - karatsuba_square_n с единственным входом x, при модульной редукции -
+    // montgomery_mult_n или barrett_mult_n, для половин произведения - karatsuba_low_n или karatsuba_high_n_t,
+    // в потоковом режиме - karatsuba_stream_n; в параметризованном режиме karatsuba_mult_n - обертка
+    // над karatsuba_mult #(.N(n))
+    // Повторные вызовы для одного контекста не выводят модули повторно, что позволяет
+    // собрать общую библиотеку модулей для нескольких разрядностей
+    void generate(int n);
+    // Генерация прямоугольного умножителя karatsuba_mult_n_m: x - n бит, y - m бит (n != m)
+    void generate(int n, int m);
+
+    // Высота модуля разрядности n в дереве рекурсии (0 для прямого умножения)
+    int height(int n);
+    // Латентность модуля разрядности n в тактах (0 без конвейера)
+    int latency(int n);
+    // Латентность прямоугольного модуля karatsuba_mult_n_m в тактах
+    int latency(int n, int m);
+    // Латентность модульного умножителя montgomery_mult_n или barrett_mult_n в тактах
+    int modularLatency(int n);
+    // Имя модуля младшей половины x * y mod 2^n
+    static string lowName(int n);
+    // Имя модуля приближения floor(x * y / 2^t) снизу, собранного из частичных произведений веса не меньше 2^t
+    static string highName(int n, int t);
+    // Порог t верхнего модуля старшей половины разрядности n: n минус защитные биты
+    int highThreshold(int n);
+    // Наибольшая ошибка x * y - A приближения A модуля старшей половины (n, t); A кратно 2^t
+    BigUint highErrorBound(int n, int t);
+    // Подмодули уровня модуля старшей половины (n, t), у которого n умножается не напрямую
+    vector<HighTerm> highTerms(int n, int t);
+    // Латентности модулей karatsuba_low_n и karatsuba_high_n_t в тактах
+    int lowLatency(int n);
+    int highLatency(int n, int t);
+    // Латентность потоковой обертки karatsuba_stream_n: такты от приема вектора до выдачи результата
+    // при m_ready = 1; столько же результатов помещается в ее выходную очередь
+    int streamLatency(int n);
+    // Число тактов от приема start до установки done у модуля karatsuba_seq_n
+    int cycles(int n);
+    // true, если модуль разрядности n вычисляет z0, z2 и p по очереди на одном подмодуле
+    bool isFolded(int n);
+    // true, если модуль разрядности n умножает напрямую, без рекурсии
+    bool isDirect(int n);
+    // Число блоков DSP умножителя разрядности n при выбранном target
+    int dspBlocks(int n);
+    // true, если уровень разрядности n делится на три части по Toom-3, а не на две по Карацубе
+    bool isToom(int n);
+    // true, если выход модуля разрядности n регистрируется
+    bool isRegistered(int n);
+    // Список соединений тела модуля Карацубы разрядности n в том виде, в котором модуль выводится;
+    // optimize = false отключает оптимизацию даже при optimize_netlist
+    Netlist moduleNetlist(int n, bool optimize = true);
+    // Имя модуля Карацубы разрядности n: karatsuba_square_n в режиме квадратора, иначе karatsuba_mult_n
+    string karatsubaName(int n) const;
+
+private:
+    void generateKaratsubaModule(int n);
+    void generateKaratsubaDependencies(int n);
+    void generateSequentialModule(int n);
+    void generateRectangularModule(int n, int m);
+    void generateModularModule(int n);
+    void generateStreamModule(int n);
+    void generateParameterizedModule(int n);
+    void generateLowModule(int n);
+    void generateHighModule(int n, int t);
+    void generateTruncatedMultiplication(int n, const string &a, const string &b, const string &product,
+                                         int lo, int hi, ostream &out);
+    void generateSharedMultiplierCall(int n, const string &x, const string &y, ostream &out);
+    void generateKaratsubaModuleBody(int n, int &module_count, const string &result, ostream &out);
+    void generateKaratsubaModuleCall(int n, const string &x, const string &y, const string &product,
+                                     const string &instance_name, ostream &out);
+    void generateModuleCall(const string &module_name, const string &x, const string &y, const string &product,
+                            const string &instance_name, ostream &out);
+    bool usesNetlist(int n);
+    void buildKaratsubaNetlist(int n, Netlist &netlist);
+    void buildToomNetlist(int n, Netlist &netlist);
+    vector<int> childWidths(int n);
+    void generateBaseMultiplication(int n, const string &a, const string &b, const string &product, ostream &out);
+    void generateBaseDependencies(int n);
+    void generateOperandSplit(const KaratsubaSplit &split, const string &x, const string &y, ostream &out);
+    void generateOperandSums(const KaratsubaSplit &split, ostream &out);
+    void generateRecombinationDependencies(const KaratsubaSplit &split);
+    void generateCarrySaveRecombination(const KaratsubaSplit &split, const string &z2, const string &z0,
+                                        const string &p, const string &result, ostream &out);
+    void generateRecombination(const KaratsubaSplit &split, const string &z2, const string &z0,
+                               const string &p, const string &z1, const string &result, ostream &out);
+    void emitAdderOnce(int n);
+    void emitSubtractorOnce(int n);
+    void emitCellsOnce();
+    void emitCarrySaveAdderOnce(int n);
+    void emitDspOnce();
+    void emitModule(const string &module_name, const function<void(ostream &)> &write_definition);
+
+    ostream &out;                 // Поток для записи модулей
+    GeneratorOptions options;     // Параметры генерации
+    unique_ptr<ModuleCache> cache; // Дисковый кэш модулей, если он включен
+    CostModel cost_model;         // Модель стоимости для автоматического выбора порога рекурсии
+    map<int, int> heights;        // Уже вычисленные высоты модулей
+    map<int, int> latencies;      // Уже вычисленные латентности модулей
+    set<int> generated_modules;   // Множество уже сгенерированных модулей
+    set<int> sequential_modules;  // Множество уже сгенерированных последовательных модулей
+    set<pair<int, int>> rectangular_modules; // Множество уже сгенерированных прямоугольных модулей
+    map<pair<int, int>, int> rectangular_latencies; // Уже вычисленные латентности прямоугольных модулей
+    set<int> modular_modules;     // Множество уже сгенерированных модульных умножителей
+    set<int> stream_modules;      // Множество уже сгенерированных потоковых оберток
+    set<int> parameterized_wrappers; // Множество уже сгенерированных оберток над karatsuba_mult #(.N())
+    bool parameterized_emitted = false; // true, если параметризованные модули уже выведены
+    set<int> low_modules;         // Множество уже сгенерированных модулей младшей половины
+    set<pair<int, int>> high_modules; // Множество уже сгенерированных модулей старшей половины (n, t)
+    map<pair<int, int>, BigUint> high_error_bounds; // Уже вычисленные границы ошибки модулей старшей половины
+    map<pair<int, int>, int> high_latencies; // Уже вычисленные латентности модулей старшей половины
+    set<int> adder_sizes;         // Множество размеров сумматоров
+    set<int> subtractor_sizes;    // Множество размеров вычитателей
+    set<int> csa_sizes;           // Множество размеров строк сжимающих ячеек
+    bool cells_emitted = false;   // true, если ячейки full_adder/half_adder уже выведены
+    bool dsp_emitted = false;     // true, если модуль блока DSP уже выведен
+    map<int, int> dsp_blocks;     // Уже вычисленные числа блоков DSP по разрядностям
+    map<int, Netlist> netlists;   // Оптимизированные тела модулей, зависимости которых уже выводятся
+};
+
+// Векторы тестбенча из файла: в строке три шестнадцатеричных слова x, y и x * y
+struct TestbenchVectors {
+    string filename;       // Файл для $readmemh; пустая строка - перебор операндов в цикле
+    long long count = 0;   // Число векторов в файле
+};
+
+// Потоковая генерация: модули пишутся в out в порядке зависимостей
+void generateVerilogModule(int N, ostream &out);
+// m > 0 и m != N задают тестбенч прямоугольного умножителя karatsuba_mult_N_m
+void generateTestbench(int N, ostream &out, const GeneratorOptions &options = GeneratorOptions(),
+                       const TestbenchVectors &vectors = TestbenchVectors(), int m = 0);
+
+// Тестбенч модульного умножителя; vectors.filename - файл writeModularVectorFile
+void generateModularTestbench(int N, ostream &out, const GeneratorOptions &options, const TestbenchVectors &vectors);
+
+// Тестбенч потоковой обертки karatsuba_stream_N со случайными паузами; vectors.filename - файл writeVectorFile
+void generateStreamTestbench(int N, ostream &out, const GeneratorOptions &options, const TestbenchVectors &vectors);
+
 string generateVerilogModule(int N);
-string generateTestbench(int N);
+string generateTestbench(int N, const GeneratorOptions &options = GeneratorOptions(),
+                         const TestbenchVectors &vectors = TestbenchVectors(), int m = 0);
 
-string generateKaratsubaModule(int n);
-string generateKaratsubaModuleBody(int n, int &module_count);
-string generateKaratsubaModuleCall(int n, const string &x, const string &y, const string &product, int &module_count);
-string generateMultiplicationLogic(int n, const string &a, const string &b, const string &product);
-string generateAdderModule(int n);
-string generateSubtractorModule(int n);
+string generateDelayLine(const string &signal, int width, int cycles, ostream &out);
+void generateMultiplicationLogic(int n, const string &a, const string &b, const string &product, ostream &out);
+void generateSquareLogic(int n, const string &a, const string &product, ostream &out);
+// Прямое вычисление разрядов [lo, hi) произведения: только a[i] & b[j] с lo <= i + j < hi
+void generateTruncatedMultiplicationLogic(int n, const string &a, const string &b, const string &product, int lo, int hi,
+                                          ostream &out);
+void generateAdderModule(int n, ostream &out);
+void generateSubtractorModule(int n, ostream &out);
 
-#endif
\ No newline at end of file
+#endif
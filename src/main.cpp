@@ -1,12 +1,32 @@
 #include <iostream>
 #include <fstream>
 #include <filesystem>
+#include <sstream>
 #include <string>
+#include <vector>
+#include <set>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <chrono>
 #include "generator/verilog_generator.h"
+#include "generator/report.h"
+#include "generator/module_directory.h"
+#include "simulator/verifier.h"
+#include "simulator/test_vectors.h"
 
 using namespace std;
-const string DEFAULT_MULTIPLIER_FILENAME = "output/karatsuba_multiplier_"; // Основа файла для модуля по умолчанию
-const string DEFAULT_TESTBENCH_FILENAME = "output/tb_karatsuba_multiplier_"; // Основа файла для тестбенча по умолчанию
+const string DEFAULT_OUTPUT_DIR = "output"; // Папка для сгенерированных файлов по умолчанию
+const string MULTIPLIER_FILENAME = "karatsuba_multiplier_"; // Основа имени файла для модуля
+const string TESTBENCH_FILENAME = "tb_karatsuba_multiplier_"; // Основа имени файла для тестбенча
+const string SQUARE_FILENAME = "karatsuba_square_"; // Основа имени файла для квадратора
+const string SQUARE_TESTBENCH_FILENAME = "tb_karatsuba_square_"; // Основа имени файла для тестбенча квадратора
+const string LIBRARY_FILENAME = "karatsuba_library.v"; // Имя файла общей библиотеки модулей
+const string LIBRARY_LIST_NAME = "karatsuba_library"; // Имя списка файлов общей библиотеки в папке модулей
+const string MODULES_DIR = "modules"; // Папка модулей в отдельных файлах внутри папки по умолчанию
+const int DEFAULT_VECTORS = 10000; // Число векторов проверки и тестбенча по умолчанию
+const int EXHAUSTIVE_TEST_WIDTH = 8; // Наибольшая разрядность, для которой тестбенч перебирает все операнды
 
 // Функция для печатания ошибки
 void printError(const string& message) {
@@ -52,9 +72,338 @@ bool isValidNumber(const string& str, int& number) {
     }
 }
 
+// Функция разбора списка разрядностей
+// Поддерживаются отдельные числа и диапазоны начало:конец[:шаг], перечисленные через запятую,
+// например "8:4096:8" или "16,32,100:110"
+// Повторы отбрасываются с сохранением порядка первых вхождений: иначе пакет писал бы один файл
+// из нескольких потоков, а список - один модуль дважды
+bool parseWidthList(const string& str, vector<int>& widths) {
+    stringstream items(str);
+    string item;
+    while (getline(items, item, ',')) {
+        vector<int> bounds;
+        stringstream parts(item);
+        string part;
+        while (getline(parts, part, ':')) {
+            int value;
+            if (!isValidNumber(part, value) || value <= 0) {
+                return false;
+            }
+            bounds.push_back(value);
+        }
+        if (bounds.size() == 1) {
+            widths.push_back(bounds[0]);
+        } else if (bounds.size() == 2 || bounds.size() == 3) {
+            int step = bounds.size() == 3 ? bounds[2] : 1;
+            if (bounds[0] > bounds[1]) {
+                return false;
+            }
+            for (long long width = bounds[0]; width <= bounds[1]; width += step) {
+                widths.push_back(static_cast<int>(width));
+            }
+        } else {
+            return false;
+        }
+    }
+    set<int> seen;
+    vector<int> unique_widths;
+    for (int width : widths) {
+        if (seen.insert(width).second) {
+            unique_widths.push_back(width);
+        }
+    }
+    widths = unique_widths;
+    return !widths.empty();
+}
+
+// Функция генерации модулей или тестбенча в поток output_file
+// Умножители всех разрядностей из widths генерируются одним контекстом, поэтому каждый
+// подмодуль попадает в поток один раз
+// Тестбенч читает векторы из файла .hex рядом с filename, если задано число векторов vectors,
+// разрядность слишком велика для полного перебора или тестируется потоковая обертка; vectors = 0 означает значение по умолчанию
+// m > 0 задает прямоугольный умножитель n x m для единственной разрядности n из widths
+bool generateToStream(ostream& output_file, const string& filename, const vector<int>& widths, bool create_test,
+                      GeneratorOptions options, int vectors, uint64_t seed, string& error, int m = 0) {
+    // Число ступеней конвейера и уровни последовательного режима пересчитываются по наибольшей разрядности;
+    // глубина прямоугольного умножителя определяется его узким операндом
+    int resolve_width = m > 0 ? min(widths.front(), m) : *max_element(widths.begin(), widths.end());
+    options.resolvePipelineStages(resolve_width);
+    options.resolveFolding(resolve_width);
+
+    // Если флаг true - создаем тестбенч, иначе - модуль
+    // Тестбенч модульного умножителя всегда читает векторы с эталоном, посчитанным на BigUint
+    if (create_test && options.reduction != ModularReduction::None) {
+        int n = widths.front();
+        TestbenchVectors testbench_vectors;
+        testbench_vectors.filename = filesystem::path(filename).replace_extension(".hex").string();
+        testbench_vectors.count = vectors > 0 ? vectors : DEFAULT_VECTORS;
+        ofstream vector_file(testbench_vectors.filename);
+        if (!vector_file) {
+            error = "Не удалось открыть файл для записи: " + testbench_vectors.filename;
+            return false;
+        }
+        writeModularVectorFile(options.reduction, n, options.modulus, testbench_vectors.count, seed, vector_file);
+        generateTestbench(n, output_file, options, testbench_vectors);
+    } else if (create_test) {
+        int n = widths.front();
+        TestbenchVectors testbench_vectors;
+        if (vectors > 0 || max(n, m) > EXHAUSTIVE_TEST_WIDTH || options.stream) {
+            testbench_vectors.filename = filesystem::path(filename).replace_extension(".hex").string();
+            testbench_vectors.count = vectors > 0 ? vectors : DEFAULT_VECTORS;
+            ofstream vector_file(testbench_vectors.filename);
+            if (!vector_file) {
+                error = "Не удалось открыть файл для записи: " + testbench_vectors.filename;
+                return false;
+            }
+            writeVectorFile(n, testbench_vectors.count, seed, vector_file, m, options.square);
+        }
+        generateTestbench(n, output_file, options, testbench_vectors, m);
+    } else {
+        KaratsubaGenerator generator(output_file, options);
+        for (int n : widths) {
+            generator.generate(n, m > 0 ? m : n);
+        }
+    }
+    return true;
+}
+
+// Функция генерации модулей или тестбенча в файл
+// Генератор пишет напрямую в файл, не собирая результат в памяти
+bool generateToFile(const string& filename, const vector<int>& widths, bool create_test,
+                    const GeneratorOptions& options, int vectors, uint64_t seed, string& error, int m = 0) {
+    ofstream output_file(filename);
+    if (!output_file) {
+        error = "Не удалось открыть файл для записи: " + filename;
+        return false;
+    }
+    if (!generateToStream(output_file, filename, widths, create_test, options, vectors, seed, error, m)) {
+        return false;
+    }
+    output_file.close();
+    if (!output_file) {
+        error = "Ошибка записи в файл: " + filename;
+        return false;
+    }
+    return true;
+}
+
+// Функция генерации в папку модулей: каждый модуль - отдельный файл, list_name.f - список файлов
+// в порядке зависимостей. С тестбенчем в список попадают и модули, и тестбенч, поэтому списка
+// достаточно для симуляции. Если verilog не nullptr, в него записывается весь сгенерированный текст
+bool generateToDirectory(ModuleDirectory& directory, const string& list_name, const vector<int>& widths,
+                         bool create_test, const GeneratorOptions& options, int vectors, uint64_t seed,
+                         string& error, int m = 0, string* verilog = nullptr) {
+    stringstream text;
+    if (!generateToStream(text, directory.path(list_name + ".v"), widths, false, options, vectors, seed, error, m) ||
+        (create_test &&
+         !generateToStream(text, directory.path(list_name + ".v"), widths, true, options, vectors, seed, error, m))) {
+        return false;
+    }
+    if (verilog) {
+        *verilog = text.str();
+    }
+    return directory.write(list_name, splitModules(text.str()), error);
+}
+
+// Функция описания латентности конвейера и числа тактов последовательного режима для вывода пользователю
+// Возвращает пустую строку, если не используется ни конвейер, ни последовательный режим
+string timingSummary(const vector<int>& widths, GeneratorOptions options, int m = 0) {
+    int resolve_width = m > 0 ? min(widths.front(), m) : *max_element(widths.begin(), widths.end());
+    options.resolvePipelineStages(resolve_width);
+    options.resolveFolding(resolve_width);
+
+    ostream null_stream(nullptr);
+    KaratsubaGenerator generator(null_stream, options);
+    string summary;
+    if (options.pipeline_every > 0) {
+        summary += "Регистры каждые " + to_string(options.pipeline_every) + " уровней рекурсии, латентность:";
+        for (int n : widths) {
+            int latency = options.reduction != ModularReduction::None ? generator.modularLatency(n)
+                          : options.stream                            ? generator.streamLatency(n)
+                          : options.half == ProductHalf::Low  ? generator.lowLatency(n)
+                          : options.half == ProductHalf::High ? generator.highLatency(n, generator.highThreshold(n))
+                                                              : generator.latency(n, m > 0 ? m : n);
+            summary += " N=" + to_string(n) + (m > 0 && m != n ? "x" + to_string(m) : "") + ": " +
+                       to_string(latency) + " тактов;";
+        }
+    }
+    if (options.fold_levels > 0) {
+        summary += summary.empty() ? "" : "\n";
+        summary += "Последовательный режим, тактов от start до done:";
+        for (int n : widths) {
+            summary += " N=" + to_string(n) + ": " + to_string(generator.cycles(n)) + ";";
+        }
+    }
+    return summary;
+}
+
+// Функция проверки сгенерированного текста встроенным симулятором
+bool verifyVerilog(const string& verilog, int n, GeneratorOptions options, long long vectors, uint64_t seed, int m = 0) {
+    options.resolvePipelineStages(m > 0 ? min(n, m) : n);
+    options.resolveFolding(n);
+
+    auto start = chrono::steady_clock::now();
+    VerificationResult result = verifyMultiplier(verilog, n, options, vectors, seed, m);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    if (result.passed) {
+        cout << "Проверка пройдена: " << result.vectors << " векторов за " << seconds << " с" << endl;
+        return true;
+    }
+    if (result.vectors == 0) {
+        printError("Не удалось загрузить модуль в симулятор: " + result.message);
+    } else {
+        printError("Несовпадений: " + to_string(result.mismatches) + " из " + to_string(result.vectors) +
+                   ". Первое: " + result.message);
+    }
+    return false;
+}
+
+// Функция проверки сгенерированного файла встроенным симулятором
+bool verifyFile(const string& filename, int n, const GeneratorOptions& options, long long vectors, uint64_t seed,
+                int m = 0) {
+    ifstream input_file(filename);
+    stringstream verilog;
+    verilog << input_file.rdbuf();
+    return verifyVerilog(verilog.str(), n, options, vectors, seed, m);
+}
+
+// Функция вывода отчета о схемах умножителей разрядностей widths в формате text или json
+// Отчет пишется в файл filename или, если имя пустое, в стандартный вывод
+// m > 0 задает прямоугольный умножитель n x m для единственной разрядности n из widths
+bool writeReport(const vector<int>& widths, const string& format, const string& filename,
+                 const GeneratorOptions& options, string& error, int m = 0) {
+    vector<DesignReport> reports;
+    for (int n : widths) {
+        GeneratorOptions width_options = options;
+        width_options.resolvePipelineStages(m > 0 ? min(n, m) : n);
+        width_options.resolveFolding(n);
+        reports.push_back(buildReport(n, width_options, m));
+    }
+
+    ofstream output_file;
+    if (!filename.empty()) {
+        output_file.open(filename);
+        if (!output_file) {
+            error = "Не удалось открыть файл для записи: " + filename;
+            return false;
+        }
+    }
+    ostream& out = filename.empty() ? cout : output_file;
+    if (format == "json") {
+        printReportJson(reports, out);
+    } else {
+        for (size_t i = 0; i < reports.size(); ++i) {
+            out << (i > 0 ? "\n" : "");
+            printReportText(reports[i], out);
+        }
+    }
+    return true;
+}
+
+// Основа имени файла модуля или тестбенча
+string baseFilename(bool create_test, const GeneratorOptions& options) {
+    if (options.reduction != ModularReduction::None) {
+        return (create_test ? "tb_" : "") + modularReductionName(options.reduction) + "_mult_";
+    }
+    if (options.stream) {
+        return create_test ? "tb_karatsuba_stream_" : "karatsuba_stream_";
+    }
+    if (options.half != ProductHalf::Full) {
+        return string(create_test ? "tb_" : "") + (options.half == ProductHalf::Low ? "karatsuba_low_" : "karatsuba_high_");
+    }
+    if (options.square) {
+        return create_test ? SQUARE_TESTBENCH_FILENAME : SQUARE_FILENAME;
+    }
+    return create_test ? TESTBENCH_FILENAME : MULTIPLIER_FILENAME;
+}
+
+// Функция вывода итога записи в папку модулей
+void printDirectorySummary(const ModuleDirectory& directory) {
+    cout << "Файлов модулей записано: " << directory.writtenCount()
+         << ", оставлено без изменений: " << directory.unchangedCount()
+         << ", удалено устаревших: " << directory.removedCount() << endl;
+}
+
+// Функция пакетной генерации: разрядности распределяются между jobs потоками,
+// каждый поток использует собственный контекст генератора
+// Если directory не nullptr, модули всех разрядностей пишутся в нее, а для каждой разрядности
+// создается свой список файлов
+int runBatch(const vector<int>& widths, const string& output_dir, bool create_test,
+             const GeneratorOptions& options, int vectors, uint64_t seed, int jobs,
+             ModuleDirectory* directory = nullptr) {
+    filesystem::create_directories(output_dir);
+
+    atomic<size_t> next_index{0};
+    atomic<int> failures{0};
+    mutex log_mutex;
+
+    auto worker = [&]() {
+        for (size_t i = next_index++; i < widths.size(); i = next_index++) {
+            int n = widths[i];
+            string filename = (filesystem::path(output_dir) /
+                               (baseFilename(create_test, options) + to_string(n) + ".v")).string();
+            string error;
+            bool ok;
+            if (directory) {
+                string list_name = baseFilename(create_test, options) + to_string(n);
+                filename = directory->path(list_name + ".f");
+                ok = generateToDirectory(*directory, list_name, {n}, create_test, options, vectors, seed, error);
+            } else {
+                ok = generateToFile(filename, {n}, create_test, options, vectors, seed, error);
+            }
+
+            lock_guard<mutex> lock(log_mutex);
+            if (ok) {
+                cout << (directory ? "Список файлов успешно сгенерирован: " : "Программа успешно сгенерирована в файле: ")
+                     << filename << endl;
+                string summary = timingSummary({n}, options);
+                if (!summary.empty()) {
+                    cout << summary << endl;
+                }
+            } else {
+                printError(error);
+                failures++;
+            }
+        }
+    };
+
+    vector<thread> threads;
+    int thread_count = min(jobs, static_cast<int>(widths.size()));
+    for (int t = 0; t < thread_count; ++t) {
+        threads.emplace_back(worker);
+    }
+    for (thread& t : threads) {
+        t.join();
+    }
+
+    string error;
+    if (directory && !directory->writeManifest(error)) {
+        printError(error);
+        failures++;
+    }
+    if (failures > 0) {
+        printError("Не удалось сгенерировать файлов: " + to_string(failures.load()));
+        return 1;
+    }
+    if (directory) {
+        printDirectorySummary(*directory);
+    }
+    return 0;
+}
+
 int main(int argc, char* argv[]) {
-    string output_filename, number_str, generated_text;
+    string output_filename, number_str;
+    string second_str;         // Разрядность второго операнда прямоугольного умножителя
     bool create_test = false;  // Флаг создания тестбенча
+    bool create_library = false; // Флаг создания общей библиотеки модулей
+    bool verify = false;       // Флаг проверки результата встроенным симулятором
+    bool split = false;        // Флаг записи каждого модуля в отдельный файл папки модулей
+    string report_format;      // Формат отчета о схеме; пустая строка - генерация Verilog
+    int vectors = 0;           // Число векторов проверки или тестбенча; 0 - значение по умолчанию
+    int seed = 1;              // Зерно генератора случайных векторов
+    GeneratorOptions options;  // Параметры генератора
+    int jobs = max(1u, thread::hardware_concurrency()); // Количество потоков пакетной генерации
     int n;
 
     // Обрабатываем аргументы командной строки
@@ -70,8 +419,163 @@ int main(int argc, char* argv[]) {
             }
         }  else if (arg == "-test") {
             create_test = true; 
-        } else {
+        } else if (arg == "-library") {
+            create_library = true;
+        } else if (arg == "-cache") {
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                options.cache_dir = string(argv[++i]);
+            } else {
+                printError("Необходимо передать папку после аргумента -cache.");
+                return 1;
+            }
+        } else if (arg == "-cutoff") {
+            if (i + 1 < argc && string(argv[i + 1]) == "auto") {
+                options.auto_cutoff = true;
+                ++i;
+            } else if (i + 1 < argc && isValidNumber(argv[i + 1], options.cutoff) && options.cutoff > 0) {
+                ++i;
+            } else {
+                printError("Необходимо передать положительное число или auto после аргумента -cutoff.");
+                return 1;
+            }
+        } else if (arg == "-optimize") {
+            if (!(i + 1 < argc && parseOptimizationGoal(argv[i + 1], options.goal))) {
+                printError("Необходимо передать area, depth или balanced после аргумента -optimize.");
+                return 1;
+            }
+            options.auto_cutoff = true;
+            ++i;
+        } else if (arg == "-base") {
+            if (!(i + 1 < argc && parseBaseMultiplier(argv[i + 1], options.base))) {
+                printError("Необходимо передать flat, wallace или dadda после аргумента -base.");
+                return 1;
+            }
+            ++i;
+        } else if (arg == "-target") {
+            if (!(i + 1 < argc && parseDspTarget(argv[i + 1], options.target))) {
+                printError("Необходимо передать dsp48e1, dsp48e2 или dsp27x27 после аргумента -target.");
+                return 1;
+            }
+            ++i;
+        } else if (arg == "-adder") {
+            if (!(i + 1 < argc && parseAdderSelection(argv[i + 1], options.adders))) {
+                printError("Необходимо передать список архитектур сумматоров после аргумента -adder, например ks:>=64,ripple:<64.");
+                return 1;
+            }
+            ++i;
+        } else if (arg == "-csa") {
+            options.carry_save = true;
+        } else if (arg == "-optimize-netlist") {
+            options.optimize_netlist = true;
+        } else if (arg == "-pipeline") {
+            if (i + 1 < argc && isValidNumber(argv[i + 1], options.pipeline_stages) && options.pipeline_stages > 0) {
+                ++i;
+            } else {
+                printError("Необходимо передать положительное число ступеней после аргумента -pipeline.");
+                return 1;
+            }
+        } else if (arg == "-pipeline-every") {
+            if (i + 1 < argc && isValidNumber(argv[i + 1], options.pipeline_every) && options.pipeline_every > 0) {
+                ++i;
+            } else {
+                printError("Необходимо передать положительное число уровней после аргумента -pipeline-every.");
+                return 1;
+            }
+        } else if (arg == "-folded") {
+            if (i + 1 < argc && isValidNumber(argv[i + 1], options.fold_levels) && options.fold_levels > 0) {
+                ++i;
+            } else {
+                printError("Необходимо передать положительное число уровней после аргумента -folded.");
+                return 1;
+            }
+        } else if (arg == "-square") {
+            options.square = true;
+        } else if (arg == "-toom3") {
+            if (i + 1 < argc && string(argv[i + 1]) == "auto") {
+                options.toom_auto = true;
+                ++i;
+            } else if (i + 1 < argc && isValidNumber(argv[i + 1], options.toom_min_width) && options.toom_min_width > 0) {
+                ++i;
+            } else {
+                printError("Необходимо передать положительное число или auto после аргумента -toom3.");
+                return 1;
+            }
+        } else if (arg == "-modular") {
+            if (!(i + 1 < argc && parseModularReduction(argv[i + 1], options.reduction))) {
+                printError("Необходимо передать montgomery или barrett после аргумента -modular.");
+                return 1;
+            }
+            ++i;
+        } else if (arg == "-modulus") {
+            string digits = i + 1 < argc ? argv[i + 1] : "";
+            bool hex = digits.compare(0, 2, "0x") == 0;
+            if (!BigUint::parse(hex ? digits.substr(2) : digits, hex ? 16 : 10, options.modulus) ||
+                options.modulus.isZero()) {
+                printError("Необходимо передать положительное число (десятичное или 0x...) после аргумента -modulus.");
+                return 1;
+            }
+            ++i;
+        } else if (arg == "-low-half") {
+            options.half = ProductHalf::Low;
+        } else if (arg == "-high-half") {
+            options.half = ProductHalf::High;
+        } else if (arg.compare(0, 11, "-high-half=") == 0) {
+            if (!isValidNumber(arg.substr(11), options.guard_bits)) {
+                printError("Необходимо передать неотрицательное число защитных битов в аргументе -high-half=G.");
+                return 1;
+            }
+            options.half = ProductHalf::High;
+        } else if (arg == "-stream") {
+            options.stream = true;
+        } else if (arg == "-accumulate") {
+            if (i + 1 < argc && isValidNumber(argv[i + 1], options.accumulator_bits) && options.accumulator_bits > 0) {
+                ++i;
+            } else {
+                printError("Необходимо передать положительное число защитных битов после аргумента -accumulate.");
+                return 1;
+            }
+            options.stream = true;
+        } else if (arg == "-parameterized") {
+            options.parameterized = true;
+        } else if (arg == "-split") {
+            split = true;
+        } else if (arg == "-verify") {
+            verify = true;
+        } else if (arg == "-report") {
+            if (i + 1 < argc && (string(argv[i + 1]) == "text" || string(argv[i + 1]) == "json")) {
+                report_format = argv[++i];
+            } else {
+                printError("Необходимо передать text или json после аргумента -report.");
+                return 1;
+            }
+        } else if (arg == "-vectors") {
+            if (i + 1 < argc && isValidNumber(argv[i + 1], vectors) && vectors > 0) {
+                ++i;
+            } else {
+                printError("Необходимо передать положительное число векторов после аргумента -vectors.");
+                return 1;
+            }
+        } else if (arg == "-seed") {
+            if (i + 1 < argc && isValidNumber(argv[i + 1], seed)) {
+                ++i;
+            } else {
+                printError("Необходимо передать число после аргумента -seed.");
+                return 1;
+            }
+        } else if (arg == "-j") {
+            if (i + 1 < argc && isValidNumber(argv[i + 1], jobs) && jobs > 0) {
+                ++i;
+            } else {
+                printError("Необходимо передать положительное число потоков после аргумента -j.");
+                return 1;
+            }
+        } else if (number_str.empty()) {
             number_str = arg; // Считаем, что это число
+        } else if (second_str.empty()) {
+            second_str = arg; // Второе число - разрядность операнда y
+        } else {
+            printError("Лишний аргумент: " + arg);
+            return 1;
         }
     }
 
@@ -81,6 +585,185 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
+    // Прямоугольный умножитель N x M: x имеет N бит, y - M бит
+    int m = 0;
+    if (!second_str.empty()) {
+        if (!isValidNumber(second_str, m) || m <= 0) {
+            printError("M должно быть положительным числом. Некорректное значение: " + second_str);
+            return 1;
+        }
+        if (create_library || options.fold_levels > 0 || number_str.find_first_of(":,") != string::npos) {
+            printError("Прямоугольный умножитель N M несовместим с -library, -folded и списком разрядностей.");
+            return 1;
+        }
+    }
+
+    if (options.square && (options.fold_levels > 0 || !second_str.empty())) {
+        printError("Аргумент -square несовместим с -folded и прямоугольным умножителем N M.");
+        return 1;
+    }
+
+    if (!options.modulus.isZero() && options.reduction == ModularReduction::None) {
+        printError("Аргумент -modulus используется только вместе с -modular.");
+        return 1;
+    }
+    if (options.reduction != ModularReduction::None) {
+        if (options.square || options.fold_levels > 0 || !second_str.empty() || create_library ||
+            number_str.find_first_of(":,") != string::npos) {
+            printError("Аргумент -modular несовместим с -square, -folded, -library, прямоугольным умножителем и списком разрядностей.");
+            return 1;
+        }
+        string error;
+        if (isValidNumber(number_str, n) && !options.modulus.isZero() &&
+            !checkModulus(options.reduction, n, options.modulus, error)) {
+            printError(error);
+            return 1;
+        }
+        if (isValidNumber(number_str, n) && n < 2) {
+            printError("Модульное умножение требует разрядности не меньше 2.");
+            return 1;
+        }
+    }
+
+    if (options.half != ProductHalf::Full) {
+        if (options.square || options.fold_levels > 0 || !second_str.empty() || create_library ||
+            options.reduction != ModularReduction::None || number_str.find_first_of(":,") != string::npos) {
+            printError("Аргументы -low-half и -high-half несовместимы с -square, -folded, -library, -modular, "
+                       "прямоугольным умножителем и списком разрядностей.");
+            return 1;
+        }
+        if (isValidNumber(number_str, n) && options.half == ProductHalf::High && n < 2) {
+            printError("Старшая половина произведения требует разрядности не меньше 2.");
+            return 1;
+        }
+        if (isValidNumber(number_str, n) && options.guard_bits >= n) {
+            printError("Число защитных битов -high-half=G должно быть меньше N.");
+            return 1;
+        }
+    }
+
+    if (options.stream && (options.square || options.fold_levels > 0 || !second_str.empty() ||
+                           options.reduction != ModularReduction::None || options.half != ProductHalf::Full)) {
+        printError("Аргументы -stream и -accumulate несовместимы с -square, -folded, -modular, -low-half, -high-half "
+                   "и прямоугольным умножителем.");
+        return 1;
+    }
+
+    if (options.target != DspTarget::None &&
+        (options.auto_cutoff || options.base != BaseMultiplier::Flat || options.toom_auto ||
+         options.toom_min_width > 0 || options.reduction != ModularReduction::None ||
+         options.half != ProductHalf::Full)) {
+        printError("Аргумент -target несовместим с -cutoff auto, -optimize, -base, -toom3, -modular, -low-half и -high-half: "
+                   "порог рекурсии выбирается по числу блоков DSP, а прямые умножители строятся из блоков.");
+        return 1;
+    }
+
+    if (options.parameterized &&
+        (options.auto_cutoff || options.base != BaseMultiplier::Flat || options.target != DspTarget::None || !options.adders.key().empty() ||
+         options.carry_save || options.optimize_netlist || options.pipeline_stages > 0 || options.pipeline_every > 0 ||
+         options.fold_levels > 0 || options.square || options.toom_auto || options.toom_min_width > 0 ||
+         options.reduction != ModularReduction::None || options.half != ProductHalf::Full || options.stream ||
+         !second_str.empty())) {
+        printError("Аргумент -parameterized совместим только с -cutoff N: параметризованный модуль повторяет "
+                   "комбинационный умножитель с прямыми умножителями flat и поведенческими сумматорами.");
+        return 1;
+    }
+
+    if (verify && (create_test || create_library || number_str.find_first_of(":,") != string::npos)) {
+        printError("Аргумент -verify используется только для генерации одного умножителя.");
+        return 1;
+    }
+
+    // Разрядности списка пишут общие модули в одну папку, поэтому их текст не должен зависеть от разрядности
+    if (split && number_str.find_first_of(":,") != string::npos && !create_library &&
+        (options.pipeline_stages > 0 || options.fold_levels > 0)) {
+        printError("Для списка разрядностей с -split конвейер задается через -pipeline-every, а последовательный "
+                   "режим несовместим: иначе общие подмодули разных разрядностей отличаются.");
+        return 1;
+    }
+    // Папка модулей: -output или output/modules
+    string split_dir = output_filename.empty() ? DEFAULT_OUTPUT_DIR + "/" + MODULES_DIR : output_filename;
+
+    // Отчет строится по тем же параметрам, что и генерация, но Verilog не выводится
+    if (!report_format.empty()) {
+        vector<int> widths;
+        if (create_test || verify) {
+            printError("Аргумент -report несовместим с -test и -verify.");
+            return 1;
+        }
+        if (!parseWidthList(number_str, widths)) {
+            printError("Некорректный список разрядностей: " + number_str);
+            return 1;
+        }
+        string error;
+        if (!writeReport(widths, report_format, output_filename, options, error, m)) {
+            printError(error);
+            return 1;
+        }
+        if (!output_filename.empty()) {
+            cout << "Отчет успешно сохранен в файле: " << output_filename << endl;
+        }
+        return 0;
+    }
+
+    // Библиотека: все разрядности из списка в одном файле, каждый подмодуль выводится один раз
+    if (create_library) {
+        vector<int> widths;
+        if (create_test) {
+            printError("Аргументы -library и -test несовместимы.");
+            return 1;
+        }
+        if (!parseWidthList(number_str, widths)) {
+            printError("Некорректный список разрядностей: " + number_str);
+            return 1;
+        }
+        string error;
+        if (split) {
+            ModuleDirectory directory(split_dir, options.manifestKey());
+            if (!generateToDirectory(directory, LIBRARY_LIST_NAME, widths, false, options, vectors,
+                                     static_cast<uint64_t>(seed), error) ||
+                !directory.writeManifest(error)) {
+                printError(error);
+                return 1;
+            }
+            cout << "Список файлов библиотеки успешно сгенерирован: " << directory.path(LIBRARY_LIST_NAME + ".f")
+                 << endl;
+            printDirectorySummary(directory);
+        } else {
+            if (output_filename == "") {
+                output_filename = DEFAULT_OUTPUT_DIR + "/" + LIBRARY_FILENAME;
+            }
+            filesystem::create_directories(DEFAULT_OUTPUT_DIR);
+
+            if (!generateToFile(output_filename, widths, false, options, vectors, static_cast<uint64_t>(seed), error)) {
+                printError(error);
+                return 1;
+            }
+            cout << "Библиотека успешно сгенерирована в файле: " << output_filename << endl;
+        }
+        string summary = timingSummary(widths, options);
+        if (!summary.empty()) {
+            cout << summary << endl;
+        }
+        return 0;
+    }
+
+    // Список или диапазон разрядностей обрабатывается пакетно, -output задает папку
+    if (number_str.find_first_of(":,") != string::npos) {
+        vector<int> widths;
+        if (!parseWidthList(number_str, widths)) {
+            printError("Некорректный список разрядностей: " + number_str);
+            return 1;
+        }
+        if (split) {
+            ModuleDirectory directory(split_dir, options.manifestKey());
+            return runBatch(widths, split_dir, create_test, options, vectors, static_cast<uint64_t>(seed), jobs,
+                            &directory);
+        }
+        return runBatch(widths, output_filename.empty() ? DEFAULT_OUTPUT_DIR : output_filename, create_test, options,
+                        vectors, static_cast<uint64_t>(seed), jobs);
+    }
+
     if (!isValidNumber(number_str, n)) {
         printError("N должен являться типом int. Некорректное значение: " + number_str);
         return 1;
@@ -91,31 +774,52 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
-    // Если флаг true - создаем тестбенч, иначе - модуль
-    if (create_test) {
-        if (output_filename == "") {
-            output_filename = DEFAULT_TESTBENCH_FILENAME+number_str+".v";
+    // Каждый модуль - отдельный файл папки модулей
+    if (split) {
+        string list_name = baseFilename(create_test, options) + number_str + (m > 0 && m != n ? "_" + second_str : "");
+        ModuleDirectory directory(split_dir, options.manifestKey());
+        string error, verilog;
+        if (!generateToDirectory(directory, list_name, {n}, create_test, options, vectors, static_cast<uint64_t>(seed),
+                                 error, m, &verilog) ||
+            !directory.writeManifest(error)) {
+            printError(error);
+            return 1;
         }
-        generated_text = generateTestbench(n);
-    } else {
-        if (output_filename == "") {
-            output_filename = DEFAULT_MULTIPLIER_FILENAME+number_str+".v";
+        cout << "Список файлов успешно сгенерирован: " << directory.path(list_name + ".f") << endl;
+        printDirectorySummary(directory);
+        string summary = timingSummary({n}, options, m);
+        if (!summary.empty()) {
+            cout << summary << endl;
         }
-        generated_text = generateVerilogModule(n);
+        if (verify && !verifyVerilog(verilog, n, options, vectors > 0 ? vectors : DEFAULT_VECTORS,
+                                     static_cast<uint64_t>(seed), m)) {
+            return 1;
+        }
+        return 0;
+    }
+
+    // Определяем имя выходного файла
+    if (output_filename == "") {
+        output_filename = DEFAULT_OUTPUT_DIR + "/" + baseFilename(create_test, options) + number_str +
+                          (m > 0 && m != n ? "_" + second_str : "") + ".v";
     }
     // Проверяем и создаем папку "output"
-    filesystem::create_directories("output");
+    filesystem::create_directories(DEFAULT_OUTPUT_DIR);
 
-    // Открытие файла для записи
-    ofstream output_file(output_filename);
-    if (!output_file) {
-        printError("Не удалось открыть файл для записи: " + output_filename);
+    string error;
+    if (!generateToFile(output_filename, {n}, create_test, options, vectors, static_cast<uint64_t>(seed), error, m)) {
+        printError(error);
         return 1;
     }
-
-    output_file << generated_text;
-    output_file.close();
     
     cout << "Программа успешно сгенерирована в файле: " << output_filename << endl;
+    string summary = timingSummary({n}, options, m);
+    if (!summary.empty()) {
+        cout << summary << endl;
+    }
+    if (verify && !verifyFile(output_filename, n, options, vectors > 0 ? vectors : DEFAULT_VECTORS,
+                              static_cast<uint64_t>(seed), m)) {
+        return 1;
+    }
     return 0;
 }
@@ -0,0 +1,294 @@
+#include "big_uint.h"
+#include <algorithm>
+
+using namespace std;
+
+BigUint::BigUint(uint64_t value) {
+    if (value != 0) {
+        words.push_back(value);
+    }
+}
+
+BigUint BigUint::random(int bits, mt19937_64 &rng) {
+    BigUint result;
+    result.words.resize((bits + 63) / 64);
+    for (uint64_t &word : result.words) {
+        word = rng();
+    }
+    if (bits % 64 != 0) {
+        result.words.back() &= (1ull << (bits % 64)) - 1;
+    }
+    result.normalize();
+    return result;
+}
+
+BigUint BigUint::allOnes(int bits) {
+    BigUint result;
+    result.words.assign((bits + 63) / 64, ~0ull);
+    if (bits % 64 != 0) {
+        result.words.back() = (1ull << (bits % 64)) - 1;
+    }
+    result.normalize();
+    return result;
+}
+
+// Разбор записи числа: каждая цифра добавляется умножением на основание
+bool BigUint::parse(const string &digits, int base, BigUint &result) {
+    result = BigUint();
+    bool any = false;
+    for (char c : digits) {
+        if (c == '_') {
+            continue;
+        }
+        int digit;
+        if (c >= '0' && c <= '9') {
+            digit = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            digit = c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            digit = c - 'A' + 10;
+        } else {
+            return false;
+        }
+        if (digit >= base) {
+            return false;
+        }
+        result = result * BigUint(base) + BigUint(digit);
+        any = true;
+    }
+    return any;
+}
+
+bool BigUint::bit(int index) const {
+    size_t word = index / 64;
+    return word < words.size() && ((words[word] >> (index % 64)) & 1);
+}
+
+void BigUint::setBit(int index, bool value) {
+    size_t word = index / 64;
+    if (word >= words.size()) {
+        if (!value) {
+            return;
+        }
+        words.resize(word + 1, 0);
+    }
+    if (value) {
+        words[word] |= 1ull << (index % 64);
+    } else {
+        words[word] &= ~(1ull << (index % 64));
+        normalize();
+    }
+}
+
+int BigUint::bitLength() const {
+    if (words.empty()) {
+        return 0;
+    }
+    int top = 63;
+    while (!((words.back() >> top) & 1)) {
+        --top;
+    }
+    return static_cast<int>(words.size() - 1) * 64 + top + 1;
+}
+
+bool BigUint::isZero() const {
+    return words.empty();
+}
+
+BigUint BigUint::lowBits(int bits) const {
+    BigUint result;
+    result.words.assign(words.begin(), words.begin() + min(words.size(), static_cast<size_t>((bits + 63) / 64)));
+    if (bits % 64 != 0 && result.words.size() == static_cast<size_t>((bits + 63) / 64)) {
+        result.words.back() &= (1ull << (bits % 64)) - 1;
+    }
+    result.normalize();
+    return result;
+}
+
+BigUint BigUint::operator+(const BigUint &other) const {
+    BigUint result;
+    size_t size = max(words.size(), other.words.size());
+    result.words.resize(size + 1, 0);
+    unsigned __int128 carry = 0;
+    for (size_t i = 0; i < size; ++i) {
+        unsigned __int128 sum = carry;
+        sum += i < words.size() ? words[i] : 0;
+        sum += i < other.words.size() ? other.words[i] : 0;
+        result.words[i] = static_cast<uint64_t>(sum);
+        carry = sum >> 64;
+    }
+    result.words[size] = static_cast<uint64_t>(carry);
+    result.normalize();
+    return result;
+}
+
+BigUint BigUint::operator-(const BigUint &other) const {
+    BigUint result = *this;
+    uint64_t borrow = 0;
+    for (size_t i = 0; i < result.words.size(); ++i) {
+        uint64_t subtrahend = i < other.words.size() ? other.words[i] : 0;
+        uint64_t difference = result.words[i] - subtrahend - borrow;
+        borrow = (result.words[i] < subtrahend || (result.words[i] == subtrahend && borrow)) ? 1 : 0;
+        result.words[i] = difference;
+    }
+    result.normalize();
+    return result;
+}
+
+// Умножение столбиком; для разрядностей проверяемых умножителей этого достаточно
+BigUint BigUint::operator*(const BigUint &other) const {
+    BigUint result;
+    if (isZero() || other.isZero()) {
+        return result;
+    }
+    result.words.assign(words.size() + other.words.size(), 0);
+    for (size_t i = 0; i < words.size(); ++i) {
+        unsigned __int128 carry = 0;
+        for (size_t j = 0; j < other.words.size(); ++j) {
+            unsigned __int128 current = static_cast<unsigned __int128>(words[i]) * other.words[j];
+            current += result.words[i + j];
+            current += carry;
+            result.words[i + j] = static_cast<uint64_t>(current);
+            carry = current >> 64;
+        }
+        result.words[i + other.words.size()] = static_cast<uint64_t>(carry);
+    }
+    result.normalize();
+    return result;
+}
+
+// Остаток сдвигается на бит влево, получает очередной бит делимого и уменьшается на делитель,
+// если не меньше него; остаток хранится в словах и не выделяет память на каждом шаге
+void BigUint::divide(const BigUint &divisor, BigUint &quotient, BigUint &remainder) const {
+    quotient = BigUint();
+    remainder = BigUint();
+    if (*this < divisor) {
+        remainder = *this;
+        return;
+    }
+    const vector<uint64_t> &d = divisor.words;
+    vector<uint64_t> r(d.size() + 1, 0);
+    quotient.words.assign(words.size(), 0);
+    for (int i = bitLength() - 1; i >= 0; --i) {
+        for (size_t k = r.size() - 1; k > 0; --k) {
+            r[k] = (r[k] << 1) | (r[k - 1] >> 63);
+        }
+        r[0] = (r[0] << 1) | (bit(i) ? 1 : 0);
+
+        bool greater_or_equal = true;
+        for (size_t k = r.size(); k-- > 0;) {
+            uint64_t value = k < d.size() ? d[k] : 0;
+            if (r[k] != value) {
+                greater_or_equal = r[k] > value;
+                break;
+            }
+        }
+        if (greater_or_equal) {
+            uint64_t borrow = 0;
+            for (size_t k = 0; k < r.size(); ++k) {
+                uint64_t value = k < d.size() ? d[k] : 0;
+                uint64_t difference = r[k] - value - borrow;
+                borrow = (r[k] < value || (r[k] == value && borrow)) ? 1 : 0;
+                r[k] = difference;
+            }
+            quotient.words[i / 64] |= 1ull << (i % 64);
+        }
+    }
+    quotient.normalize();
+    remainder.words = r;
+    remainder.normalize();
+}
+
+BigUint BigUint::operator/(const BigUint &other) const {
+    BigUint quotient, remainder;
+    divide(other, quotient, remainder);
+    return quotient;
+}
+
+BigUint BigUint::operator%(const BigUint &other) const {
+    BigUint quotient, remainder;
+    divide(other, quotient, remainder);
+    return remainder;
+}
+
+BigUint BigUint::operator<<(int bits) const {
+    if (isZero()) {
+        return *this;
+    }
+    BigUint result;
+    size_t word_shift = bits / 64;
+    int bit_shift = bits % 64;
+    result.words.assign(words.size() + word_shift + 1, 0);
+    for (size_t i = 0; i < words.size(); ++i) {
+        result.words[i + word_shift] |= words[i] << bit_shift;
+        if (bit_shift != 0) {
+            result.words[i + word_shift + 1] |= words[i] >> (64 - bit_shift);
+        }
+    }
+    result.normalize();
+    return result;
+}
+
+BigUint BigUint::operator>>(int bits) const {
+    BigUint result;
+    size_t word_shift = bits / 64;
+    int bit_shift = bits % 64;
+    if (word_shift >= words.size()) {
+        return result;
+    }
+    result.words.assign(words.size() - word_shift, 0);
+    for (size_t i = 0; i < result.words.size(); ++i) {
+        result.words[i] = words[i + word_shift] >> bit_shift;
+        if (bit_shift != 0 && i + word_shift + 1 < words.size()) {
+            result.words[i] |= words[i + word_shift + 1] << (64 - bit_shift);
+        }
+    }
+    result.normalize();
+    return result;
+}
+
+bool BigUint::operator==(const BigUint &other) const {
+    return words == other.words;
+}
+
+bool BigUint::operator!=(const BigUint &other) const {
+    return words != other.words;
+}
+
+bool BigUint::operator<(const BigUint &other) const {
+    if (words.size() != other.words.size()) {
+        return words.size() < other.words.size();
+    }
+    for (size_t i = words.size(); i-- > 0;) {
+        if (words[i] != other.words[i]) {
+            return words[i] < other.words[i];
+        }
+    }
+    return false;
+}
+
+bool BigUint::operator<=(const BigUint &other) const {
+    return !(other < *this);
+}
+
+string BigUint::toHex() const {
+    if (words.empty()) {
+        return "0";
+    }
+    const char *digits = "0123456789abcdef";
+    string result;
+    for (int i = bitLength() - 1 - (bitLength() - 1) % 4; i >= 0; i -= 4) {
+        int digit = 0;
+        for (int k = 3; k >= 0; --k) {
+            digit = digit * 2 + (bit(i + k) ? 1 : 0);
+        }
+        result += digits[digit];
+    }
+    return result;
+}
+
+void BigUint::normalize() {
+    while (!words.empty() && words.back() == 0) {
+        words.pop_back();
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef BIG_UINT_H
+#define BIG_UINT_H
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+using namespace std;
+
+// Беззнаковое целое произвольной длины для эталонных значений при проверке умножителей
+// и констант модульной редукции. Хранится в виде 64-битных слов от младшего к старшему без ведущих нулевых слов
+class BigUint {
+public:
+    BigUint() = default;
+    explicit BigUint(uint64_t value);
+
+    // Случайное число из bits бит и число из bits единиц
+    static BigUint random(int bits, mt19937_64 &rng);
+    static BigUint allOnes(int bits);
+    // Разбор десятичной, двоичной или шестнадцатеричной записи (base = 10, 2 или 16)
+    static bool parse(const string &digits, int base, BigUint &result);
+
+    bool bit(int index) const;
+    void setBit(int index, bool value);
+    int bitLength() const;
+    bool isZero() const;
+
+    // Младшие bits бит числа, то есть остаток от деления на 2^bits
+    BigUint lowBits(int bits) const;
+
+    BigUint operator+(const BigUint &other) const;
+    // Разность; вычитаемое не должно превышать уменьшаемое
+    BigUint operator-(const BigUint &other) const;
+    BigUint operator*(const BigUint &other) const;
+    // Деление столбиком по битам; делитель не должен быть нулем
+    BigUint operator/(const BigUint &other) const;
+    BigUint operator%(const BigUint &other) const;
+    BigUint operator<<(int bits) const;
+    BigUint operator>>(int bits) const;
+    bool operator==(const BigUint &other) const;
+    bool operator!=(const BigUint &other) const;
+    bool operator<(const BigUint &other) const;
+    bool operator<=(const BigUint &other) const;
+
+    // Шестнадцатеричная запись без префикса
+    string toHex() const;
+
+private:
+    void normalize();
+    // Частное и остаток от деления на divisor
+    void divide(const BigUint &divisor, BigUint &quotient, BigUint &remainder) const;
+
+    vector<uint64_t> words;  // Слова числа от младшего к старшему
+};
+
+#endif
@@ -0,0 +1,85 @@
+#include "test_vectors.h"
+
+using namespace std;
+
+TestVectorSource::TestVectorSource(int n, int m, uint64_t seed, bool square) : n(n), m(m), square(square), rng(seed) {
+    BigUint max_x = BigUint::allOnes(n), max_y = BigUint::allOnes(m);
+    BigUint high_x, high_y;
+    high_x.setBit(n - 1, true);
+    high_y.setBit(m - 1, true);
+    corners = {
+        {BigUint(0), BigUint(0)},     {max_x, max_y},         {max_x, BigUint(1)},
+        {BigUint(1), max_y},          {max_x, BigUint(0)},    {BigUint(1), BigUint(1)},
+        {high_x, high_y},             {high_x, max_y},
+    };
+    if (square) {
+        corners = {{BigUint(0), BigUint(0)}, {max_x, max_x}, {BigUint(1), BigUint(1)}, {high_x, high_x}};
+    }
+}
+
+void TestVectorSource::next(BigUint &x, BigUint &y) {
+    if (index < static_cast<long long>(corners.size())) {
+        x = corners[index].first;
+        y = corners[index].second;
+    } else {
+        x = BigUint::random(n, rng);
+        y = square ? x : BigUint::random(m, rng);
+    }
+    index++;
+}
+
+void writeVectorFile(int n, long long count, uint64_t seed, ostream &out, int m, bool square) {
+    TestVectorSource source(n, m > 0 ? m : n, seed, square);
+    BigUint x, y;
+    for (long long i = 0; i < count; ++i) {
+        source.next(x, y);
+        out << x.toHex() << " " << y.toHex() << " " << (x * y).toHex() << "\n";
+    }
+}
+
+ModularVectorSource::ModularVectorSource(ModularReduction reduction, int n, const BigUint &modulus, uint64_t seed)
+    : reduction(reduction), n(n), modulus(modulus), rng(seed) {
+    if (!modulus.isZero()) {
+        constant = reductionConstant(reduction, n, modulus);
+    }
+}
+
+// Случайный модуль: n бит со старшей единицей; для Монтгомери нечетный, для Барретта больше 2^(n-1)
+BigUint ModularVectorSource::randomModulus() {
+    BigUint result = BigUint::random(n, rng);
+    result.setBit(n - 1, true);
+    result.setBit(0, true);
+    return result;
+}
+
+void ModularVectorSource::next(ModularVector &vector) {
+    bool fixed = !modulus.isZero();
+    vector.modulus = fixed ? modulus : randomModulus();
+    vector.constant = fixed ? constant : reductionConstant(reduction, n, vector.modulus);
+    BigUint largest = vector.modulus - BigUint(1);
+    if (fixed && index < 4) {
+        const BigUint corners[][2] = {{BigUint(0), largest}, {BigUint(1), BigUint(1)}, {largest, largest},
+                                      {BigUint(1), largest}};
+        vector.x = corners[index][0];
+        vector.y = corners[index][1];
+    } else {
+        vector.x = BigUint::random(n, rng) % vector.modulus;
+        vector.y = BigUint::random(n, rng) % vector.modulus;
+    }
+    vector.expected = modularProduct(reduction, n, vector.x, vector.y, vector.modulus);
+    index++;
+}
+
+void writeModularVectorFile(ModularReduction reduction, int n, const BigUint &modulus, long long count,
+                            uint64_t seed, ostream &out) {
+    ModularVectorSource source(reduction, n, modulus, seed);
+    ModularVector vector;
+    for (long long i = 0; i < count; ++i) {
+        source.next(vector);
+        out << vector.x.toHex() << " " << vector.y.toHex() << " ";
+        if (modulus.isZero()) {
+            out << vector.modulus.toHex() << " " << vector.constant.toHex() << " ";
+        }
+        out << vector.expected.toHex() << "\n";
+    }
+}
@@ -0,0 +1,65 @@
+#ifndef TEST_VECTORS_H
+#define TEST_VECTORS_H
+
+#include <cstdint>
+#include <ostream>
+#include <random>
+#include <utility>
+#include <vector>
+#include "big_uint.h"
+#include "../generator/modular_reduction.h"
+using namespace std;
+
+// Источник пар операндов для проверки умножителя n x m бит:
+// сначала граничные значения (0, 1, 2^n - 1, старший бит), затем случайные числа с зерном seed
+// Для квадратора (square) в каждой паре y == x
+class TestVectorSource {
+public:
+    TestVectorSource(int n, int m, uint64_t seed, bool square = false);
+
+    // Очередная пара операндов
+    void next(BigUint &x, BigUint &y);
+
+private:
+    int n, m;
+    bool square;
+    long long index = 0;                      // Номер очередной пары
+    mt19937_64 rng;
+    vector<pair<BigUint, BigUint>> corners;   // Граничные пары
+};
+
+// Функция записи count векторов для $readmemh: в строке вектора три слова x, y и x * y
+// в шестнадцатеричной записи; тестбенч читает их в память со словами по n + m бит
+// m = 0 означает квадратный умножитель n x n, square - векторы квадратора с y == x
+void writeVectorFile(int n, long long count, uint64_t seed, ostream &out, int m = 0, bool square = false);
+
+// Вектор модульного умножителя: операнды меньше модуля, модуль, его константа редукции и результат
+struct ModularVector {
+    BigUint x, y, modulus, constant, expected;
+};
+
+// Источник векторов модульного умножителя разрядности n: для постоянного модуля (modulus != 0)
+// сначала операнды 0, 1 и M - 1, иначе в каждом векторе свой случайный допустимый модуль;
+// эталон считается modularProduct
+class ModularVectorSource {
+public:
+    ModularVectorSource(ModularReduction reduction, int n, const BigUint &modulus, uint64_t seed);
+
+    void next(ModularVector &vector);
+
+private:
+    BigUint randomModulus();
+
+    ModularReduction reduction;
+    int n;
+    BigUint modulus, constant;                // Постоянный модуль и его константа
+    long long index = 0;
+    mt19937_64 rng;
+};
+
+// Функция записи count векторов модульного умножителя для $readmemh: в строке x, y, для входного
+// модуля - модуль и константа редукции, затем ожидаемый результат
+void writeModularVectorFile(ModularReduction reduction, int n, const BigUint &modulus, long long count,
+                            uint64_t seed, ostream &out);
+
+#endif
@@ -0,0 +1,367 @@
+#include "verifier.h"
+#include <deque>
+#include <random>
+#include <sstream>
+#include "test_vectors.h"
+#include "verilog_simulator.h"
+
+using namespace std;
+
+// Пары операндов одного прохода симулятора
+struct VectorBatch {
+    vector<BigUint> x, y;
+};
+
+// Функция для формирования очередного набора из count пар операндов
+static VectorBatch nextBatch(long long count, TestVectorSource &source) {
+    VectorBatch batch;
+    batch.x.resize(count);
+    batch.y.resize(count);
+    for (long long i = 0; i < count; ++i) {
+        source.next(batch.x[i], batch.y[i]);
+    }
+    return batch;
+}
+
+// Допустимые значения выхода product: младшие low_bits бит x * y, если low_bits > 0,
+// иначе floor(x * y / 2^shift) минус ошибка от 0 до max_error
+struct ProductCheck {
+    int low_bits = 0;
+    int shift = 0;
+    BigUint max_error;
+};
+
+// Функция для сравнения выхода product с эталонными произведениями набора
+static void checkBatch(const VerilogSimulator &simulator, const VectorBatch &batch, const ProductCheck &check,
+                       VerificationResult &result) {
+    vector<BigUint> products = simulator.get("product");
+    for (size_t lane = 0; lane < batch.x.size(); ++lane) {
+        BigUint full = batch.x[lane] * batch.y[lane];
+        BigUint expected = check.low_bits > 0 ? full.lowBits(check.low_bits) : full >> check.shift;
+        if (!(products[lane] <= expected && expected - products[lane] <= check.max_error)) {
+            if (result.mismatches == 0) {
+                result.message = "x=0x" + batch.x[lane].toHex() + ", y=0x" + batch.y[lane].toHex() +
+                                 ": получено 0x" + products[lane].toHex() + ", ожидалось 0x" + expected.toHex() +
+                                 (check.max_error.isZero() ? "" : " с ошибкой не больше 0x" + check.max_error.toHex());
+            }
+            result.mismatches++;
+        }
+    }
+}
+
+// Функция проверки модульного умножителя: каждый такт подается новый набор векторов,
+// результат набора сравнивается с эталоном через modularLatency(n) тактов
+static VerificationResult verifyModular(const string &verilog, int n, const GeneratorOptions &options,
+                                        long long vectors, uint64_t seed) {
+    VerificationResult result;
+    ostringstream unused;
+    KaratsubaGenerator generator(unused, options);
+    bool pipelined = options.pipeline_every > 0;
+    bool fixed = !options.modulus.isZero();
+    string constant_port = reductionConstantPort(options.reduction);
+
+    VerilogSimulator simulator;
+    if (!simulator.load(verilog, modularName(options.reduction, n), result.message)) {
+        return result;
+    }
+    if (pipelined) {
+        simulator.set("rst", 1);
+        simulator.clock();
+        simulator.set("rst", 0);
+    }
+
+    ModularVectorSource source(options.reduction, n, options.modulus, seed);
+    int latency = pipelined ? generator.modularLatency(n) : 0;
+    long long batches = (vectors + SIMULATION_LANES - 1) / SIMULATION_LANES;
+    deque<vector<ModularVector>> in_flight;
+    for (long long step = 0; step < batches + latency; ++step) {
+        vector<ModularVector> batch;
+        if (step < batches) {
+            batch.resize(min<long long>(SIMULATION_LANES, vectors - step * SIMULATION_LANES));
+            for (ModularVector &vector : batch) {
+                source.next(vector);
+            }
+        }
+        auto lanes = [&batch](BigUint ModularVector::*field) {
+            vector<BigUint> values;
+            for (const ModularVector &vector : batch) {
+                values.push_back(vector.*field);
+            }
+            return values;
+        };
+        simulator.set("x", lanes(&ModularVector::x));
+        simulator.set("y", lanes(&ModularVector::y));
+        if (!fixed) {
+            simulator.set("modulus", lanes(&ModularVector::modulus));
+            simulator.set(constant_port, lanes(&ModularVector::constant));
+        }
+        in_flight.push_back(batch);
+        simulator.evaluate();
+
+        if (static_cast<int>(in_flight.size()) > latency) {
+            vector<BigUint> products = simulator.get("product");
+            const vector<ModularVector> &checked = in_flight.front();
+            for (size_t lane = 0; lane < checked.size(); ++lane) {
+                if (products[lane] != checked[lane].expected) {
+                    if (result.mismatches == 0) {
+                        result.message = "x=0x" + checked[lane].x.toHex() + ", y=0x" + checked[lane].y.toHex() +
+                                         ", M=0x" + checked[lane].modulus.toHex() + ": получено 0x" +
+                                         products[lane].toHex() + ", ожидалось 0x" + checked[lane].expected.toHex();
+                    }
+                    result.mismatches++;
+                }
+            }
+            result.vectors += static_cast<long long>(checked.size());
+            in_flight.pop_front();
+        }
+        if (pipelined) {
+            simulator.clock();
+        }
+    }
+
+    result.passed = result.mismatches == 0;
+    return result;
+}
+
+// Функция проверки потоковой обертки karatsuba_stream_n: данные у каждой дорожки свои, а s_valid, s_last
+// и m_ready общие. Первые тактов без пауз - половина наборов, но не меньше 2 * (streamLatency(n) + 1),
+// чтобы первый результат успел выйти до пауз m_ready, а прием проверялся дольше задержки: наборы подаются
+// каждый такт при m_ready = 1, обертка должна принимать их без пауз и выдать первый результат через
+// streamLatency(n) тактов. Затем s_valid и m_ready пропадают случайно, и результаты сверяются с эталонной
+// очередью при каждом m_valid && m_ready
+static VerificationResult verifyStream(const string &verilog, int n, const GeneratorOptions &options,
+                                       long long vectors, uint64_t seed) {
+    VerificationResult result;
+    ostringstream unused;
+    KaratsubaGenerator generator(unused, options);
+    int width = 2 * n + options.accumulator_bits;
+    bool accumulate = options.accumulator_bits > 0;
+
+    VerilogSimulator simulator;
+    if (!simulator.load(verilog, "karatsuba_stream_" + to_string(n), result.message)) {
+        return result;
+    }
+    simulator.set("rst", 1);
+    simulator.set("s_valid", 0);
+    simulator.set("s_last", 0);
+    simulator.set("m_ready", 0);
+    simulator.set("x", 0);
+    simulator.set("y", 0);
+    simulator.clock();
+    simulator.set("rst", 0);
+    simulator.evaluate();
+
+    // Ожидаемые результаты по дорожкам и признак m_last
+    struct StreamResult {
+        vector<BigUint> products;
+        bool last;
+    };
+    deque<StreamResult> expected;
+    vector<BigUint> acc(SIMULATION_LANES);
+
+    TestVectorSource source(n, n, seed);
+    mt19937_64 control(seed);
+    int latency = generator.streamLatency(n);
+    long long batches = (vectors + SIMULATION_LANES - 1) / SIMULATION_LANES;
+    long long full_cycles = max<long long>(batches / 2, 2 * (latency + 1));
+    long long sent = 0, received = 0, outputs = 0;
+    bool holding = false;   // Набор выставлен на вход и еще не принят
+    VectorBatch batch;
+    bool last = false;
+    // Нарушение протокола прерывает проверку; выставленный набор считается проверенным
+    auto fail = [&](const string &message) {
+        result.message = message;
+        result.mismatches++;
+        result.vectors = received + static_cast<long long>(batch.x.size());
+        return result;
+    };
+    // Пропавшие результаты не должны подвешивать проверку
+    long long limit = 4 * (batches + latency) + 64;
+    for (long long cycle = 0; cycle < limit && (sent < batches || !expected.empty()); ++cycle) {
+        bool full = cycle < full_cycles;
+        if (!holding && sent < batches && (full || control() % 4 != 0)) {
+            batch = nextBatch(min<long long>(SIMULATION_LANES, vectors - sent * SIMULATION_LANES), source);
+            last = sent + 1 == batches || control() % 4 == 0;
+            holding = true;
+        }
+        bool ready = full || control() % 4 != 0;
+        simulator.set("s_valid", holding ? 1 : 0);
+        simulator.set("s_last", last ? 1 : 0);
+        simulator.set("x", holding ? batch.x : vector<BigUint>());
+        simulator.set("y", holding ? batch.y : vector<BigUint>());
+        simulator.set("m_ready", ready ? 1 : 0);
+        simulator.evaluate();
+
+        if (full && simulator.get("s_ready", 0).isZero()) {
+            return fail("s_ready снят на такте " + to_string(cycle) + " при m_ready = 1");
+        }
+        if (!simulator.get("m_valid", 0).isZero() && ready) {
+            if (expected.empty()) {
+                return fail("лишний результат на такте " + to_string(cycle));
+            }
+            if (outputs == 0 && !accumulate && cycle != latency) {
+                return fail("первый результат через " + to_string(cycle) + " тактов, ожидалось " +
+                            to_string(latency));
+            }
+            vector<BigUint> products = simulator.get("product");
+            bool m_last = !simulator.get("m_last", 0).isZero();
+            const StreamResult &front = expected.front();
+            for (int lane = 0; lane < SIMULATION_LANES; ++lane) {
+                if (products[lane] != front.products[lane] || m_last != front.last) {
+                    if (result.mismatches == 0) {
+                        result.message = "результат " + to_string(outputs) + ", дорожка " + to_string(lane) +
+                                         ": получено 0x" + products[lane].toHex() + (m_last ? " с m_last" : "") +
+                                         ", ожидалось 0x" + front.products[lane].toHex() +
+                                         (front.last ? " с m_last" : "");
+                    }
+                    result.mismatches++;
+                }
+            }
+            expected.pop_front();
+            outputs++;
+        }
+
+        if (holding && !simulator.get("s_ready", 0).isZero()) {
+            vector<BigUint> products(SIMULATION_LANES);
+            for (size_t lane = 0; lane < batch.x.size(); ++lane) {
+                products[lane] = batch.x[lane] * batch.y[lane];
+            }
+            if (accumulate) {
+                for (int lane = 0; lane < SIMULATION_LANES; ++lane) {
+                    acc[lane] = (acc[lane] + products[lane]).lowBits(width);
+                }
+                if (last) {
+                    expected.push_back({acc, true});
+                    acc.assign(SIMULATION_LANES, BigUint());
+                }
+            } else {
+                expected.push_back({products, last});
+            }
+            received += static_cast<long long>(batch.x.size());
+            holding = false;
+            sent++;
+        }
+        simulator.clock();
+    }
+
+    result.vectors = received;
+    if (!expected.empty() && result.mismatches == 0) {
+        result.message = "не получено результатов: " + to_string(expected.size());
+        result.mismatches += static_cast<long long>(expected.size());
+    }
+    result.passed = result.mismatches == 0;
+    return result;
+}
+
+VerificationResult verifyMultiplier(const string &verilog, int n, const GeneratorOptions &options,
+                                    long long vectors, uint64_t seed, int m) {
+    if (options.reduction != ModularReduction::None) {
+        return verifyModular(verilog, n, options, vectors, seed);
+    }
+    if (options.stream) {
+        return verifyStream(verilog, n, options, vectors, seed);
+    }
+    VerificationResult result;
+    ostringstream unused;
+    KaratsubaGenerator generator(unused, options);
+    bool folded = options.fold_levels > 0;
+    bool pipelined = options.pipeline_every > 0;
+    m = m > 0 ? m : n;
+    bool square = options.square;
+    string top = folded ? "karatsuba_seq_" + to_string(n) : (square ? generator.karatsubaName(n) : multiplierName(n, m));
+    int latency = pipelined ? generator.latency(n, m) : 0;
+    ProductCheck check;
+    if (options.half == ProductHalf::Low) {
+        top = KaratsubaGenerator::lowName(n);
+        latency = pipelined ? generator.lowLatency(n) : 0;
+        check.low_bits = n;
+    } else if (options.half == ProductHalf::High) {
+        int threshold = generator.highThreshold(n);
+        top = KaratsubaGenerator::highName(n, threshold);
+        latency = pipelined ? generator.highLatency(n, threshold) : 0;
+        check.shift = threshold;
+        check.max_error = generator.highErrorBound(n, threshold) >> threshold;
+    }
+
+    VerilogSimulator simulator;
+    if (!simulator.load(verilog, top, result.message)) {
+        return result;
+    }
+
+    TestVectorSource source(n, m, seed, square);
+    if (pipelined || folded) {
+        // Синхронный сброс всех регистров
+        simulator.set("rst", 1);
+        simulator.set("x", 0);
+        if (!square) {
+            simulator.set("y", 0);
+        }
+        if (folded) {
+            simulator.set("start", 0);
+        }
+        simulator.clock();
+        simulator.set("rst", 0);
+        simulator.evaluate();
+    }
+
+    if (folded) {
+        // Последовательный модуль: запуск и ожидание done, число тактов должно совпасть с cycles(n)
+        int expected_cycles = generator.cycles(n);
+        for (long long first = 0; first < vectors; first += SIMULATION_LANES) {
+            VectorBatch batch = nextBatch(min<long long>(SIMULATION_LANES, vectors - first), source);
+            simulator.set("x", batch.x);
+            simulator.set("y", batch.y);
+            simulator.set("start", 1);
+            simulator.clock();
+            simulator.set("start", 0);
+            simulator.evaluate();
+            int cycles = 0;
+            while (simulator.get("done", 0).isZero() && cycles <= expected_cycles) {
+                simulator.clock();
+                cycles++;
+            }
+            if (cycles != expected_cycles) {
+                result.message = "done установлен через " + to_string(cycles) + " тактов, ожидалось " +
+                                 to_string(expected_cycles);
+                result.mismatches += static_cast<long long>(batch.x.size());
+                result.vectors += static_cast<long long>(batch.x.size());
+                return result;
+            }
+            checkBatch(simulator, batch, check, result);
+            result.vectors += static_cast<long long>(batch.x.size());
+        }
+    } else {
+        // Комбинационный или конвейерный модуль: каждый такт подается новый набор операндов,
+        // на выходе при этом находится произведение набора, поданного latency(n) тактов назад
+        long long batches = (vectors + SIMULATION_LANES - 1) / SIMULATION_LANES;
+        deque<VectorBatch> in_flight;
+        for (long long step = 0; step < batches + latency; ++step) {
+            if (step < batches) {
+                long long first = step * SIMULATION_LANES;
+                in_flight.push_back(nextBatch(min<long long>(SIMULATION_LANES, vectors - first), source));
+                simulator.set("x", in_flight.back().x);
+                if (!square) {
+                    simulator.set("y", in_flight.back().y);
+                }
+            } else {
+                in_flight.push_back(VectorBatch());
+                simulator.set("x", 0);
+                if (!square) {
+                    simulator.set("y", 0);
+                }
+            }
+            simulator.evaluate();
+            if (static_cast<int>(in_flight.size()) > latency) {
+                checkBatch(simulator, in_flight.front(), check, result);
+                result.vectors += static_cast<long long>(in_flight.front().x.size());
+                in_flight.pop_front();
+            }
+            if (pipelined) {
+                simulator.clock();
+            }
+        }
+    }
+
+    result.passed = result.mismatches == 0;
+    return result;
+}
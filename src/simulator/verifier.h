@@ -0,0 +1,27 @@
+#ifndef VERIFIER_H
+#define VERIFIER_H
+
+#include <cstdint>
+#include <string>
+#include "../generator/verilog_generator.h"
+using namespace std;
+
+// Итог проверки умножителя встроенным симулятором
+struct VerificationResult {
+    bool passed = false;
+    long long vectors = 0;     // Число проверенных пар операндов
+    long long mismatches = 0;  // Число пар с неверным произведением или числом тактов
+    string message;            // Ошибка загрузки или первое несовпадение
+};
+
+// Проверка умножителя разрядности n из текста verilog на vectors парах операндов:
+// сначала граничные значения (0, 1, 2^n - 1, старший бит), затем случайные числа с зерном seed
+// Режим (комбинационный, конвейерный, последовательный, квадратор, половина произведения, потоковая обертка
+// со случайными паузами на входе и выходе или модульный умножитель, проверяемый на векторах ModularVectorSource)
+// определяется по options,
+// в которых уже пересчитаны pipeline_every и fold_min_width
+// m > 0 и m != n задают прямоугольный умножитель karatsuba_mult_n_m
+VerificationResult verifyMultiplier(const string &verilog, int n, const GeneratorOptions &options,
+                                    long long vectors, uint64_t seed, int m = 0);
+
+#endif
@@ -0,0 +1,1403 @@
+#include "verilog_simulator.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <functional>
+#include <queue>
+#include <stdexcept>
+
+using namespace std;
+
+// Ошибка разбора или построения иерархии; перехватывается в VerilogSimulator::load
+class SimulationError : public runtime_error {
+public:
+    using runtime_error::runtime_error;
+};
+
+// ---------------------------------------------------------------------------------------------
+// Лексический анализ
+
+struct Token {
+    enum Type { Identifier, Number, Symbol, End };
+    Type type;
+    string text;
+    int line;
+};
+
+static vector<Token> tokenize(const string &source) {
+    vector<Token> tokens;
+    int line = 1;
+    size_t i = 0;
+    while (i < source.size()) {
+        char c = source[i];
+        if (c == '\n') {
+            line++;
+            i++;
+        } else if (isspace(static_cast<unsigned char>(c))) {
+            i++;
+        } else if (source.compare(i, 2, "//") == 0) {
+            while (i < source.size() && source[i] != '\n') {
+                i++;
+            }
+        } else if (source.compare(i, 2, "/*") == 0 || source.compare(i, 2, "(*") == 0) {
+            // Блочные комментарии и атрибуты синтеза пропускаются
+            string close = source[i] == '/' ? "*/" : "*)";
+            size_t end = source.find(close, i + 2);
+            end = end == string::npos ? source.size() : end + 2;
+            line += count(source.begin() + i, source.begin() + end, '\n');
+            i = end;
+        } else if (c == '`') {
+            // Директивы компилятора (`timescale) пропускаются до конца строки
+            while (i < source.size() && source[i] != '\n') {
+                i++;
+            }
+        } else if (isalpha(static_cast<unsigned char>(c)) || c == '_' || c == '$') {
+            size_t start = i;
+            while (i < source.size() && (isalnum(static_cast<unsigned char>(source[i])) || source[i] == '_' || source[i] == '$')) {
+                i++;
+            }
+            tokens.push_back({Token::Identifier, source.substr(start, i - start), line});
+        } else if (isdigit(static_cast<unsigned char>(c)) || c == '\'') {
+            // Числа: 42, 16'd2, 4'b0, 'hff
+            size_t start = i;
+            while (i < source.size() && (isdigit(static_cast<unsigned char>(source[i])) || source[i] == '_')) {
+                i++;
+            }
+            if (i < source.size() && source[i] == '\'') {
+                i += 2;
+                while (i < source.size() && (isalnum(static_cast<unsigned char>(source[i])) || source[i] == '_')) {
+                    i++;
+                }
+            }
+            tokens.push_back({Token::Number, source.substr(start, i - start), line});
+        } else {
+            static const char *operators[] = {"<=", ">=", "==", "!=", "<<", ">>", "&&", "||"};
+            string symbol(1, c);
+            for (const char *op : operators) {
+                if (source.compare(i, 2, op) == 0) {
+                    symbol = op;
+                }
+            }
+            tokens.push_back({Token::Symbol, symbol, line});
+            i += symbol.size();
+        }
+    }
+    tokens.push_back({Token::End, "", line});
+    return tokens;
+}
+
+// ---------------------------------------------------------------------------------------------
+// Разобранные модули
+
+struct Net {
+    string name;
+    int width = 1;
+    int lsb = 0;          // Младший индекс диапазона [msb:lsb]
+    int offset = 0;       // Смещение первого бита в кадре модуля
+    bool is_reg = false;
+    int reg_offset = 0;   // Смещение первого бита в регистрах экземпляра
+    string direction;     // "input", "output" или пусто для внутренних цепей
+};
+
+enum class ExprKind { Constant, NetRef, Select, Concat, Repeat, Not, LogicalNot, Binary, Ternary };
+
+struct Expr {
+    ExprKind kind;
+    char op = 0;          // Binary: первый символ операции; '<' и '>' - сдвиги, '=' и '!' - сравнения,
+                          // 'A' и 'O' - логические && и ||
+    int width = 1;        // Собственная разрядность выражения
+    int net = -1;         // NetRef, Select
+    int hi = 0, lo = 0;   // Select: биты относительно младшего бита цепи
+    int count = 0;        // Repeat: число повторений; сдвиги: величина сдвига
+    BigUint value;        // Constant
+    vector<unique_ptr<Expr>> args;
+};
+
+struct LValue {
+    int net = -1;
+    int lo = 0, hi = 0;
+};
+
+struct Stmt {
+    enum Kind { Block, If, Case, NonBlocking };
+    Kind kind;
+    vector<unique_ptr<Stmt>> body;
+    unique_ptr<Expr> expr;                    // Условие if, выражение case, правая часть присваивания
+    unique_ptr<Stmt> then_stmt, else_stmt;    // Ветви if; else_stmt также ветвь default в case
+    vector<pair<vector<unique_ptr<Expr>>, unique_ptr<Stmt>>> items;
+    LValue target;
+};
+
+struct Process {
+    enum Kind { Assign, Instance };
+    Kind kind;
+    LValue target;                                   // Assign
+    unique_ptr<Expr> expr;                           // Assign
+    string module_name, instance_name;               // Instance
+    map<string, BigUint> parameters;                 // Instance: переопределенные параметры подмодуля
+    vector<pair<string, unique_ptr<Expr>>> connections;
+    const CompiledModule *module = nullptr;
+    vector<pair<int, unique_ptr<Expr>>> inputs;      // Порт подмодуля и подключенное выражение
+    vector<pair<int, LValue>> outputs;               // Порт подмодуля и приемник
+    int child_slot = -1;
+    int line = 0;
+};
+
+struct CompiledModule {
+    string name;
+    vector<Net> nets;
+    map<string, int> net_index;
+    map<string, BigUint> parameters;
+    vector<Process> processes;
+    vector<int> order;                       // Порядок вычисления процессов
+    vector<unique_ptr<Stmt>> always_blocks;
+    vector<int> reg_nets;
+    int frame_words = 0;
+    int reg_words = 0;
+    int child_slots = 0;
+    bool stateful = false;
+    bool linked = false;
+};
+
+struct InstanceState {
+    vector<uint64_t> regs;
+    vector<uint64_t> pending;
+    vector<unique_ptr<InstanceState>> children;
+};
+
+// Имя модуля name с переопределенными параметрами, например karatsuba_mult#(N=8)
+static string specializationName(const string &name, const map<string, BigUint> &parameters) {
+    if (parameters.empty()) {
+        return name;
+    }
+    string result = name + "#(";
+    for (const auto &[parameter, value] : parameters) {
+        result += (result.back() == '(' ? "" : ",") + parameter + "=" + value.toHex();
+    }
+    return result + ")";
+}
+
+// ---------------------------------------------------------------------------------------------
+// Синтаксический анализ
+
+class Parser {
+public:
+    // Разбор начинается с позиции start; overrides переопределяет параметры модуля
+    explicit Parser(const vector<Token> &tokens, size_t start = 0, const map<string, BigUint> &overrides = {})
+        : tokens(tokens), position(start), overrides(overrides) {
+    }
+
+    // Модуль с параметрами в заголовке #(parameter ...) получает имя specializationName
+    unique_ptr<CompiledModule> parseModule() {
+        expect("module");
+        module = make_unique<CompiledModule>();
+        module->name = identifier();
+        if (accept("#")) {
+            expect("(");
+            do {
+                accept("parameter");
+                string name = identifier();
+                expect("=");
+                unique_ptr<Expr> value = parseExpr();
+                if (value->kind != ExprKind::Constant) {
+                    fail("значение параметра должно быть константой");
+                }
+                auto it = overrides.find(name);
+                module->parameters[name] = it != overrides.end() ? it->second : value->value;
+            } while (accept(","));
+            expect(")");
+        }
+        for (const auto &[name, value] : overrides) {
+            if (!module->parameters.count(name)) {
+                fail("у модуля нет параметра " + name);
+            }
+        }
+        module->name = specializationName(module->name, overrides);
+        expect("(");
+        if (!accept(")")) {
+            string direction, kind;
+            int msb = 0, lsb = 0;
+            bool ranged = false;
+            do {
+                if (peek() == "input" || peek() == "output") {
+                    direction = next();
+                    kind = (peek() == "reg" || peek() == "wire") ? next() : "wire";
+                    ranged = parseRange(msb, lsb);
+                } else if (direction.empty()) {
+                    fail("поддерживаются только порты в стиле ANSI");
+                }
+                declare(identifier(), ranged ? msb : 0, ranged ? lsb : 0, kind == "reg", direction);
+            } while (accept(","));
+            expect(")");
+        }
+        expect(";");
+
+        while (!accept("endmodule")) {
+            parseItem();
+        }
+        return move(module);
+    }
+
+    bool atEnd() const {
+        return tokens[position].type == Token::End;
+    }
+
+    size_t current() const {
+        return position;
+    }
+
+private:
+    const string &peek(int offset = 0) const {
+        return tokens[min(position + offset, tokens.size() - 1)].text;
+    }
+
+    string next() {
+        if (atEnd()) {
+            fail("неожиданный конец файла");
+        }
+        return tokens[position++].text;
+    }
+
+    bool accept(const string &text) {
+        if (tokens[position].type != Token::End && peek() == text) {
+            position++;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(const string &text) {
+        if (!accept(text)) {
+            fail("ожидалось '" + text + "', получено '" + peek() + "'");
+        }
+    }
+
+    string identifier() {
+        if (tokens[position].type != Token::Identifier) {
+            fail("ожидался идентификатор, получено '" + peek() + "'");
+        }
+        return next();
+    }
+
+    [[noreturn]] void fail(const string &message) const {
+        string where = module ? " в модуле " + module->name : "";
+        throw SimulationError("строка " + to_string(tokens[position].line) + where + ": " + message);
+    }
+
+    bool parseRange(int &msb, int &lsb) {
+        if (!accept("[")) {
+            return false;
+        }
+        msb = constantInt(*parseExpr());
+        expect(":");
+        lsb = constantInt(*parseExpr());
+        expect("]");
+        if (msb < lsb) {
+            fail("поддерживаются только диапазоны [старший:младший]");
+        }
+        return true;
+    }
+
+    int declare(const string &name, int msb, int lsb, bool is_reg, const string &direction) {
+        if (module->net_index.count(name)) {
+            fail("повторное объявление " + name);
+        }
+        Net net;
+        net.name = name;
+        net.width = msb - lsb + 1;
+        net.lsb = lsb;
+        net.is_reg = is_reg;
+        net.direction = direction;
+        net.offset = module->frame_words;
+        module->frame_words += net.width;
+        if (is_reg) {
+            net.reg_offset = module->reg_words;
+            module->reg_words += net.width;
+            module->reg_nets.push_back(static_cast<int>(module->nets.size()));
+        }
+        module->net_index[name] = static_cast<int>(module->nets.size());
+        module->nets.push_back(net);
+        return module->net_index[name];
+    }
+
+    void parseItem() {
+        int line = tokens[position].line;
+        if (accept("generate")) {
+            while (!accept("endgenerate")) {
+                parseItem();
+            }
+        } else if (accept("if")) {
+            parseGenerateIf();
+        } else if (peek() == "wire" || peek() == "reg") {
+            bool is_reg = next() == "reg";
+            int msb = 0, lsb = 0;
+            parseRange(msb, lsb);
+            do {
+                int net = declare(identifier(), msb, lsb, is_reg, "");
+                if (accept("=")) {
+                    if (is_reg) {
+                        fail("начальные значения регистров не поддерживаются");
+                    }
+                    Process process;
+                    process.kind = Process::Assign;
+                    process.target = {net, 0, module->nets[net].width - 1};
+                    process.expr = parseExpr();
+                    process.line = line;
+                    module->processes.push_back(move(process));
+                }
+            } while (accept(","));
+            expect(";");
+        } else if (accept("localparam")) {
+            do {
+                string name = identifier();
+                expect("=");
+                unique_ptr<Expr> value = parseExpr();
+                if (value->kind != ExprKind::Constant) {
+                    fail("значение localparam должно быть константой");
+                }
+                module->parameters[name] = value->value;
+            } while (accept(","));
+            expect(";");
+        } else if (accept("assign")) {
+            do {
+                Process process;
+                process.kind = Process::Assign;
+                process.target = parseLValue();
+                expect("=");
+                process.expr = parseExpr();
+                process.line = line;
+                module->processes.push_back(move(process));
+            } while (accept(","));
+            expect(";");
+        } else if (accept("always")) {
+            expect("@");
+            expect("(");
+            if (!accept("posedge")) {
+                fail("поддерживаются только блоки always @(posedge ...)");
+            }
+            identifier();
+            expect(")");
+            module->always_blocks.push_back(parseStatement());
+        } else if (tokens[position].type == Token::Identifier) {
+            Process process;
+            process.kind = Process::Instance;
+            process.line = line;
+            process.module_name = identifier();
+            if (accept("#")) {
+                expect("(");
+                do {
+                    expect(".");
+                    string name = identifier();
+                    expect("(");
+                    unique_ptr<Expr> value = parseExpr();
+                    if (value->kind != ExprKind::Constant) {
+                        fail("значение параметра должно быть константой");
+                    }
+                    process.parameters[name] = value->value;
+                    expect(")");
+                } while (accept(","));
+                expect(")");
+            }
+            process.instance_name = identifier();
+            expect("(");
+            if (!accept(")")) {
+                do {
+                    expect(".");
+                    string port = identifier();
+                    expect("(");
+                    if (!accept(")")) {
+                        process.connections.push_back({port, parseExpr()});
+                        expect(")");
+                    }
+                } while (accept(","));
+                expect(")");
+            }
+            expect(";");
+            process.child_slot = module->child_slots++;
+            module->processes.push_back(move(process));
+        } else {
+            fail("неподдерживаемая конструкция '" + peek() + "'");
+        }
+    }
+
+    // Условная генерация: условие вычисляется при разборе, невыбранная ветвь пропускается
+    // Имена блоков не создают областей видимости, поэтому имена цепей ветвей не должны совпадать
+    void parseGenerateIf() {
+        expect("(");
+        bool condition = constantInt(*parseExpr()) != 0;
+        expect(")");
+        if (condition) {
+            parseGenerateBlock();
+        } else {
+            skipGenerateBlock();
+        }
+        if (accept("else")) {
+            if (condition) {
+                skipGenerateBlock();
+            } else {
+                parseGenerateBlock();
+            }
+        }
+    }
+
+    void parseGenerateBlock() {
+        if (!accept("begin")) {
+            parseItem();
+            return;
+        }
+        if (accept(":")) {
+            identifier();
+        }
+        while (!accept("end")) {
+            parseItem();
+        }
+    }
+
+    void skipGenerateBlock() {
+        if (accept("if")) {
+            expect("(");
+            for (int depth = 1; depth > 0;) {
+                string token = next();
+                depth += token == "(" ? 1 : token == ")" ? -1 : 0;
+            }
+            skipGenerateBlock();
+            if (accept("else")) {
+                skipGenerateBlock();
+            }
+        } else if (accept("begin")) {
+            for (int depth = 1; depth > 0;) {
+                string token = next();
+                depth += token == "begin" ? 1 : token == "end" ? -1 : 0;
+            }
+        } else {
+            while (next() != ";") {
+            }
+        }
+    }
+
+    unique_ptr<Stmt> parseStatement() {
+        auto stmt = make_unique<Stmt>();
+        if (accept("begin")) {
+            stmt->kind = Stmt::Block;
+            while (!accept("end")) {
+                stmt->body.push_back(parseStatement());
+            }
+        } else if (accept("if")) {
+            stmt->kind = Stmt::If;
+            expect("(");
+            stmt->expr = parseExpr();
+            expect(")");
+            stmt->then_stmt = parseStatement();
+            if (accept("else")) {
+                stmt->else_stmt = parseStatement();
+            }
+        } else if (accept("case")) {
+            stmt->kind = Stmt::Case;
+            expect("(");
+            stmt->expr = parseExpr();
+            expect(")");
+            while (!accept("endcase")) {
+                if (accept("default")) {
+                    accept(":");
+                    stmt->else_stmt = parseStatement();
+                    continue;
+                }
+                vector<unique_ptr<Expr>> labels;
+                do {
+                    labels.push_back(parseExpr());
+                } while (accept(","));
+                expect(":");
+                stmt->items.push_back({move(labels), parseStatement()});
+            }
+        } else if (accept(";")) {
+            stmt->kind = Stmt::Block;
+        } else {
+            stmt->kind = Stmt::NonBlocking;
+            stmt->target = parseLValue();
+            if (!module->nets[stmt->target.net].is_reg) {
+                fail("присваивание в always-блоке цепи, не объявленной как reg: " + module->nets[stmt->target.net].name);
+            }
+            expect("<=");
+            stmt->expr = parseExpr();
+            expect(";");
+        }
+        return stmt;
+    }
+
+    LValue parseLValue() {
+        unique_ptr<Expr> expr = parsePrimary();
+        if (expr->kind == ExprKind::NetRef) {
+            return {expr->net, 0, expr->width - 1};
+        }
+        if (expr->kind == ExprKind::Select) {
+            return {expr->net, expr->lo, expr->hi};
+        }
+        fail("левой частью присваивания может быть только цепь или ее часть");
+    }
+
+    // Разбор выражений по приоритетам операций
+    unique_ptr<Expr> parseExpr() {
+        unique_ptr<Expr> condition = parseBinary(0);
+        if (!accept("?")) {
+            return condition;
+        }
+        auto expr = make_unique<Expr>();
+        expr->kind = ExprKind::Ternary;
+        expr->args.push_back(move(condition));
+        expr->args.push_back(parseExpr());
+        expect(":");
+        expr->args.push_back(parseExpr());
+        expr->width = max(expr->args[1]->width, expr->args[2]->width);
+        if (all_of(expr->args.begin(), expr->args.end(), [](const unique_ptr<Expr> &arg) {
+                return arg->kind == ExprKind::Constant;
+            })) {
+            return move(expr->args[expr->args[0]->value.isZero() ? 2 : 1]);
+        }
+        return expr;
+    }
+
+    unique_ptr<Expr> parseBinary(int level) {
+        static const vector<vector<string>> levels = {
+            {"||"}, {"&&"}, {"|"}, {"^"}, {"&"}, {"==", "!="}, {"<", "<=", ">", ">="}, {"<<", ">>"}, {"+", "-"},
+            {"*", "/", "%"}};
+        if (level == static_cast<int>(levels.size())) {
+            return parseUnary();
+        }
+        unique_ptr<Expr> left = parseBinary(level + 1);
+        while (find(levels[level].begin(), levels[level].end(), peek()) != levels[level].end() &&
+               tokens[position].type == Token::Symbol) {
+            auto expr = make_unique<Expr>();
+            expr->kind = ExprKind::Binary;
+            string op = next();
+            expr->op = op == "&&" ? 'A' : op == "||" ? 'O' : op == "<" ? 'L' : op == "<=" ? 'l' : op == ">" ? 'G'
+                       : op == ">=" ? 'g' : op[0];
+            expr->args.push_back(move(left));
+            expr->args.push_back(parseBinary(level + 1));
+            const Expr &a = *expr->args[0], &b = *expr->args[1];
+            if (op == "||" || op == "&&" || op == "==" || op == "!=" || op == "<" || op == "<=" || op == ">" ||
+                op == ">=") {
+                expr->width = 1;
+            } else if (op == "<<" || op == ">>") {
+                expr->width = a.width;
+                expr->count = constantInt(b);
+            } else {
+                expr->width = max(a.width, b.width);
+            }
+            left = foldConstant(move(expr));
+            if (left->kind == ExprKind::Binary && string("/%LlGg").find(left->op) != string::npos) {
+                fail("деление и сравнения на больше-меньше поддерживаются только для констант");
+            }
+        }
+        return left;
+    }
+
+    unique_ptr<Expr> parseUnary() {
+        if (accept("~")) {
+            auto expr = make_unique<Expr>();
+            expr->kind = ExprKind::Not;
+            expr->args.push_back(parseUnary());
+            expr->width = expr->args[0]->width;
+            return expr;
+        }
+        if (accept("!")) {
+            auto expr = make_unique<Expr>();
+            expr->kind = ExprKind::LogicalNot;
+            expr->args.push_back(parseUnary());
+            return expr;
+        }
+        return parsePrimary();
+    }
+
+    unique_ptr<Expr> parsePrimary() {
+        if (accept("(")) {
+            unique_ptr<Expr> expr = parseExpr();
+            expect(")");
+            return expr;
+        }
+        if (accept("{")) {
+            unique_ptr<Expr> first = parseExpr();
+            if (accept("{")) {
+                // Повторение {k{...}}
+                auto expr = make_unique<Expr>();
+                expr->kind = ExprKind::Repeat;
+                expr->count = constantInt(*first);
+                auto inner = make_unique<Expr>();
+                inner->kind = ExprKind::Concat;
+                inner->width = 0;
+                do {
+                    inner->args.push_back(parseExpr());
+                    inner->width += inner->args.back()->width;
+                } while (accept(","));
+                expect("}");
+                expect("}");
+                if (expr->count <= 0) {
+                    fail("число повторений должно быть положительным");
+                }
+                expr->width = expr->count * inner->width;
+                expr->args.push_back(move(inner));
+                return expr;
+            }
+            auto expr = make_unique<Expr>();
+            expr->kind = ExprKind::Concat;
+            expr->width = first->width;
+            expr->args.push_back(move(first));
+            while (accept(",")) {
+                expr->args.push_back(parseExpr());
+                expr->width += expr->args.back()->width;
+            }
+            expect("}");
+            return expr;
+        }
+        if (tokens[position].type == Token::Number) {
+            return parseNumber(next());
+        }
+
+        string name = identifier();
+        auto parameter = module->parameters.find(name);
+        if (parameter != module->parameters.end()) {
+            auto expr = make_unique<Expr>();
+            expr->kind = ExprKind::Constant;
+            expr->value = parameter->second;
+            expr->width = max(32, parameter->second.bitLength());
+            return expr;
+        }
+        auto it = module->net_index.find(name);
+        if (it == module->net_index.end()) {
+            fail("необъявленная цепь " + name);
+        }
+        const Net &net = module->nets[it->second];
+        auto expr = make_unique<Expr>();
+        expr->net = it->second;
+        if (!accept("[")) {
+            expr->kind = ExprKind::NetRef;
+            expr->width = net.width;
+            return expr;
+        }
+        expr->kind = ExprKind::Select;
+        expr->hi = constantInt(*parseExpr()) - net.lsb;
+        expr->lo = accept(":") ? constantInt(*parseExpr()) - net.lsb : expr->hi;
+        expect("]");
+        if (expr->lo < 0 || expr->hi < expr->lo || expr->hi >= net.width) {
+            fail("выход за границы цепи " + name);
+        }
+        expr->width = expr->hi - expr->lo + 1;
+        return expr;
+    }
+
+    unique_ptr<Expr> parseNumber(const string &text) {
+        auto expr = make_unique<Expr>();
+        expr->kind = ExprKind::Constant;
+        size_t quote = text.find('\'');
+        bool ok;
+        if (quote == string::npos) {
+            ok = BigUint::parse(text, 10, expr->value);
+            expr->width = max(32, expr->value.bitLength());
+        } else {
+            char base = static_cast<char>(tolower(text[quote + 1]));
+            int radix = base == 'b' ? 2 : base == 'h' ? 16 : base == 'd' ? 10 : base == 'o' ? 8 : 0;
+            ok = radix != 0 && BigUint::parse(text.substr(quote + 2), radix, expr->value);
+            expr->width = quote == 0 ? 32 : stoi(text.substr(0, quote));
+            // Значение усекается до заданной разрядности
+            while (expr->width > 0 && expr->value.bitLength() > expr->width) {
+                expr->value.setBit(expr->value.bitLength() - 1, false);
+            }
+        }
+        if (!ok || expr->width <= 0) {
+            fail("некорректное число " + text);
+        }
+        return expr;
+    }
+
+    // Свертка арифметики над константами, используемой в диапазонах, параметрах и условиях генерации
+    unique_ptr<Expr> foldConstant(unique_ptr<Expr> expr) {
+        const Expr &a = *expr->args[0], &b = *expr->args[1];
+        if (a.kind != ExprKind::Constant || b.kind != ExprKind::Constant) {
+            return expr;
+        }
+        long long x = constantInt(a), y = constantInt(b), result;
+        switch (expr->op) {
+            case '+': result = x + y; break;
+            case '-': result = x - y; break;
+            case '*': result = x * y; break;
+            case '/':
+            case '%':
+                if (y == 0) {
+                    fail("деление на ноль");
+                }
+                result = expr->op == '/' ? x / y : x % y;
+                break;
+            case 'L': result = x < y; break;
+            case 'l': result = x <= y; break;
+            case 'G': result = x > y; break;
+            case 'g': result = x >= y; break;
+            case '=': result = x == y; break;
+            case '!': result = x != y; break;
+            case 'A': result = x && y; break;
+            case 'O': result = x || y; break;
+            default: return expr;
+        }
+        if (result < 0) {
+            return expr;
+        }
+        auto folded = make_unique<Expr>();
+        folded->kind = ExprKind::Constant;
+        folded->value = BigUint(static_cast<uint64_t>(result));
+        folded->width = max(32, folded->value.bitLength());
+        return folded;
+    }
+
+    int constantInt(const Expr &expr) const {
+        if (expr.kind != ExprKind::Constant || expr.value.bitLength() > 31) {
+            fail("ожидалась целая константа");
+        }
+        int value = 0;
+        for (int i = expr.value.bitLength() - 1; i >= 0; --i) {
+            value = value * 2 + (expr.value.bit(i) ? 1 : 0);
+        }
+        return value;
+    }
+
+    const vector<Token> &tokens;
+    size_t position = 0;
+    map<string, BigUint> overrides;
+    unique_ptr<CompiledModule> module;
+};
+
+// ---------------------------------------------------------------------------------------------
+// Построение иерархии и порядка вычисления
+
+// Список битов цепей, которые читает выражение
+static void collectReads(const Expr &expr, vector<LValue> &reads) {
+    if (expr.kind == ExprKind::NetRef) {
+        reads.push_back({expr.net, 0, expr.width - 1});
+    } else if (expr.kind == ExprKind::Select) {
+        reads.push_back({expr.net, expr.lo, expr.hi});
+    }
+    for (const unique_ptr<Expr> &arg : expr.args) {
+        collectReads(*arg, reads);
+    }
+}
+
+// resolve возвращает модуль экземпляра с учетом параметров или nullptr, если модуль не найден
+static void link(CompiledModule &module, const function<CompiledModule *(const Process &)> &resolve,
+                 vector<string> &stack) {
+    if (module.linked) {
+        return;
+    }
+    if (find(stack.begin(), stack.end(), module.name) != stack.end()) {
+        throw SimulationError("рекурсивное инстанцирование модуля " + module.name);
+    }
+    stack.push_back(module.name);
+    module.stateful = module.reg_words > 0;
+
+    for (Process &process : module.processes) {
+        if (process.kind != Process::Instance) {
+            continue;
+        }
+        CompiledModule *found = resolve(process);
+        if (!found) {
+            throw SimulationError("модуль " + process.module_name + " не найден (экземпляр " + process.instance_name +
+                                  " в модуле " + module.name + ")");
+        }
+        CompiledModule &child = *found;
+        link(child, resolve, stack);
+        process.module = &child;
+        module.stateful = module.stateful || child.stateful;
+
+        for (auto &connection : process.connections) {
+            auto port = child.net_index.find(connection.first);
+            if (port == child.net_index.end() || child.nets[port->second].direction.empty()) {
+                throw SimulationError("у модуля " + child.name + " нет порта " + connection.first);
+            }
+            if (child.nets[port->second].direction == "input") {
+                process.inputs.push_back({port->second, move(connection.second)});
+                continue;
+            }
+            const Expr &expr = *connection.second;
+            if (expr.kind == ExprKind::NetRef) {
+                process.outputs.push_back({port->second, {expr.net, 0, expr.width - 1}});
+            } else if (expr.kind == ExprKind::Select) {
+                process.outputs.push_back({port->second, {expr.net, expr.lo, expr.hi}});
+            } else {
+                throw SimulationError("выход " + connection.first + " экземпляра " + process.instance_name +
+                                      " подключен не к цепи");
+            }
+        }
+        process.connections.clear();
+    }
+
+    // Порядок вычисления: каждый бит имеет не больше одного источника, процесс вычисляется
+    // после источников всех читаемых им битов
+    vector<vector<int>> drivers(module.nets.size());
+    for (size_t i = 0; i < module.nets.size(); ++i) {
+        drivers[i].assign(module.nets[i].width, -1);
+    }
+    auto drive = [&](const LValue &target, int process) {
+        const Net &net = module.nets[target.net];
+        if (net.is_reg) {
+            throw SimulationError("регистр " + net.name + " в модуле " + module.name + " управляется вне always-блока");
+        }
+        for (int bit = target.lo; bit <= target.hi; ++bit) {
+            if (drivers[target.net][bit] >= 0) {
+                throw SimulationError("у бита " + to_string(bit) + " цепи " + net.name + " в модуле " + module.name +
+                                      " несколько источников");
+            }
+            drivers[target.net][bit] = process;
+        }
+    };
+    for (size_t p = 0; p < module.processes.size(); ++p) {
+        const Process &process = module.processes[p];
+        if (process.kind == Process::Assign) {
+            drive(process.target, static_cast<int>(p));
+        } else {
+            for (const auto &output : process.outputs) {
+                drive(output.second, static_cast<int>(p));
+            }
+        }
+    }
+
+    size_t count = module.processes.size();
+    vector<vector<int>> dependents(count);
+    vector<int> pending(count, 0);
+    for (size_t p = 0; p < count; ++p) {
+        const Process &process = module.processes[p];
+        vector<LValue> reads;
+        if (process.kind == Process::Assign) {
+            collectReads(*process.expr, reads);
+        } else {
+            for (const auto &input : process.inputs) {
+                collectReads(*input.second, reads);
+            }
+        }
+        vector<int> sources;
+        for (const LValue &read : reads) {
+            for (int bit = read.lo; bit <= read.hi; ++bit) {
+                int source = drivers[read.net][bit];
+                if (source == static_cast<int>(p)) {
+                    throw SimulationError("комбинационная петля через цепь " + module.nets[read.net].name +
+                                          " в модуле " + module.name);
+                }
+                if (source >= 0 && (sources.empty() || sources.back() != source)) {
+                    sources.push_back(source);
+                }
+            }
+        }
+        sort(sources.begin(), sources.end());
+        sources.erase(unique(sources.begin(), sources.end()), sources.end());
+        for (int source : sources) {
+            dependents[source].push_back(static_cast<int>(p));
+        }
+        pending[p] = static_cast<int>(sources.size());
+    }
+
+    priority_queue<int, vector<int>, greater<int>> ready;
+    for (size_t p = 0; p < count; ++p) {
+        if (pending[p] == 0) {
+            ready.push(static_cast<int>(p));
+        }
+    }
+    while (!ready.empty()) {
+        int p = ready.top();
+        ready.pop();
+        module.order.push_back(p);
+        for (int dependent : dependents[p]) {
+            if (--pending[dependent] == 0) {
+                ready.push(dependent);
+            }
+        }
+    }
+    if (module.order.size() != count) {
+        throw SimulationError("комбинационная петля в модуле " + module.name);
+    }
+
+    module.linked = true;
+    stack.pop_back();
+}
+
+static unique_ptr<InstanceState> buildState(const CompiledModule &module) {
+    auto state = make_unique<InstanceState>();
+    state->regs.assign(module.reg_words, 0);
+    state->pending.assign(module.reg_words, 0);
+    state->children.resize(module.child_slots);
+    for (const Process &process : module.processes) {
+        if (process.kind == Process::Instance && process.module->stateful) {
+            state->children[process.child_slot] = buildState(*process.module);
+        }
+    }
+    return state;
+}
+
+// ---------------------------------------------------------------------------------------------
+// Вычисление
+
+// Стек слов для кадров подмодулей и временных значений; память освобождается в обратном порядке
+class WordStack {
+public:
+    struct Mark {
+        size_t chunk, used;
+    };
+
+    uint64_t *allocate(size_t words) {
+        if (chunks.empty() || used + words > sizes[chunk]) {
+            if (!chunks.empty()) {
+                chunk++;
+            }
+            if (chunk == chunks.size() || sizes[chunk] < words) {
+                size_t size = max<size_t>(1 << 20, words);
+                chunks.resize(chunk + 1);
+                sizes.resize(chunk + 1);
+                chunks[chunk] = make_unique<uint64_t[]>(size);
+                sizes[chunk] = size;
+            }
+            used = 0;
+        }
+        uint64_t *result = chunks[chunk].get() + used;
+        used += words;
+        return result;
+    }
+
+    Mark mark() const {
+        return {chunk, used};
+    }
+
+    void release(const Mark &mark) {
+        chunk = mark.chunk;
+        used = mark.used;
+    }
+
+private:
+    vector<unique_ptr<uint64_t[]>> chunks;
+    vector<size_t> sizes;
+    size_t chunk = 0;
+    size_t used = 0;
+};
+
+// Контекст вычисления одного экземпляра модуля
+struct Frame {
+    const CompiledModule &module;
+    uint64_t *words;
+    InstanceState *state;
+    WordStack &stack;
+};
+
+static uint64_t reduceOr(const uint64_t *words, int width) {
+    uint64_t result = 0;
+    for (int i = 0; i < width; ++i) {
+        result |= words[i];
+    }
+    return result;
+}
+
+static void evaluateExpr(const Expr &expr, int width, uint64_t *dst, Frame &frame);
+
+// Вычисление выражения в его собственной разрядности во временную память
+static uint64_t *evaluateSelf(const Expr &expr, Frame &frame) {
+    uint64_t *words = frame.stack.allocate(expr.width);
+    evaluateExpr(expr, expr.width, words, frame);
+    return words;
+}
+
+// Вычисление выражения в разрядности width (не меньше собственной) по правилам Verilog
+// для беззнаковых выражений: операнды арифметических и побитовых операций расширяются до width
+static void evaluateExpr(const Expr &expr, int width, uint64_t *dst, Frame &frame) {
+    WordStack::Mark mark = frame.stack.mark();
+    switch (expr.kind) {
+        case ExprKind::Constant:
+            for (int i = 0; i < width; ++i) {
+                dst[i] = i < expr.width && expr.value.bit(i) ? ~0ull : 0;
+            }
+            break;
+        case ExprKind::NetRef:
+        case ExprKind::Select: {
+            const Net &net = frame.module.nets[expr.net];
+            int lo = expr.kind == ExprKind::NetRef ? 0 : expr.lo;
+            memcpy(dst, frame.words + net.offset + lo, sizeof(uint64_t) * expr.width);
+            fill(dst + expr.width, dst + width, 0);
+            break;
+        }
+        case ExprKind::Concat: {
+            int position = 0;
+            for (auto it = expr.args.rbegin(); it != expr.args.rend(); ++it) {
+                evaluateExpr(**it, (*it)->width, dst + position, frame);
+                position += (*it)->width;
+            }
+            fill(dst + position, dst + width, 0);
+            break;
+        }
+        case ExprKind::Repeat: {
+            int part = expr.args[0]->width;
+            evaluateExpr(*expr.args[0], part, dst, frame);
+            for (int k = 1; k < expr.count; ++k) {
+                memcpy(dst + k * part, dst, sizeof(uint64_t) * part);
+            }
+            fill(dst + expr.width, dst + width, 0);
+            break;
+        }
+        case ExprKind::Not:
+            evaluateExpr(*expr.args[0], width, dst, frame);
+            for (int i = 0; i < width; ++i) {
+                dst[i] = ~dst[i];
+            }
+            break;
+        case ExprKind::LogicalNot:
+            dst[0] = ~reduceOr(evaluateSelf(*expr.args[0], frame), expr.args[0]->width);
+            fill(dst + 1, dst + width, 0);
+            break;
+        case ExprKind::Ternary: {
+            uint64_t condition = reduceOr(evaluateSelf(*expr.args[0], frame), expr.args[0]->width);
+            if (condition == ~0ull || condition == 0) {
+                // Все векторы выбирают одну ветвь, вторую можно не вычислять
+                evaluateExpr(*expr.args[condition ? 1 : 2], width, dst, frame);
+                break;
+            }
+            evaluateExpr(*expr.args[1], width, dst, frame);
+            uint64_t *other = frame.stack.allocate(width);
+            evaluateExpr(*expr.args[2], width, other, frame);
+            for (int i = 0; i < width; ++i) {
+                dst[i] = (condition & dst[i]) | (~condition & other[i]);
+            }
+            break;
+        }
+        case ExprKind::Binary: {
+            const Expr &a = *expr.args[0], &b = *expr.args[1];
+            switch (expr.op) {
+                case '<':
+                case '>': {
+                    evaluateExpr(a, width, dst, frame);
+                    int shift = min(expr.count, width);
+                    if (expr.op == '<') {
+                        memmove(dst + shift, dst, sizeof(uint64_t) * (width - shift));
+                        fill(dst, dst + shift, 0);
+                    } else {
+                        memmove(dst, dst + shift, sizeof(uint64_t) * (width - shift));
+                        fill(dst + width - shift, dst + width, 0);
+                    }
+                    break;
+                }
+                case 'A':
+                case 'O': {
+                    uint64_t x = reduceOr(evaluateSelf(a, frame), a.width);
+                    uint64_t y = reduceOr(evaluateSelf(b, frame), b.width);
+                    dst[0] = expr.op == 'A' ? (x & y) : (x | y);
+                    fill(dst + 1, dst + width, 0);
+                    break;
+                }
+                case '=':
+                case '!': {
+                    int operand_width = max(a.width, b.width);
+                    uint64_t *x = frame.stack.allocate(operand_width);
+                    uint64_t *y = frame.stack.allocate(operand_width);
+                    evaluateExpr(a, operand_width, x, frame);
+                    evaluateExpr(b, operand_width, y, frame);
+                    uint64_t differ = 0;
+                    for (int i = 0; i < operand_width; ++i) {
+                        differ |= x[i] ^ y[i];
+                    }
+                    dst[0] = expr.op == '=' ? ~differ : differ;
+                    fill(dst + 1, dst + width, 0);
+                    break;
+                }
+                case '*': {
+                    // Умножение сдвигами и сложениями: для каждого бита b к результату прибавляется
+                    // a << j в тех векторах, где этот бит равен 1
+                    uint64_t *x = frame.stack.allocate(width);
+                    uint64_t *y = frame.stack.allocate(width);
+                    evaluateExpr(a, width, x, frame);
+                    evaluateExpr(b, width, y, frame);
+                    fill(dst, dst + width, 0);
+                    for (int j = 0; j < width; ++j) {
+                        if (y[j] == 0) {
+                            continue;
+                        }
+                        uint64_t carry = 0;
+                        for (int i = 0; i + j < width; ++i) {
+                            uint64_t term = x[i] & y[j], sum = dst[i + j];
+                            dst[i + j] = sum ^ term ^ carry;
+                            carry = (sum & term) | (carry & (sum ^ term));
+                        }
+                    }
+                    break;
+                }
+                default: {
+                    evaluateExpr(a, width, dst, frame);
+                    uint64_t *other = frame.stack.allocate(width);
+                    evaluateExpr(b, width, other, frame);
+                    if (expr.op == '&') {
+                        for (int i = 0; i < width; ++i) {
+                            dst[i] &= other[i];
+                        }
+                    } else if (expr.op == '|') {
+                        for (int i = 0; i < width; ++i) {
+                            dst[i] |= other[i];
+                        }
+                    } else if (expr.op == '^') {
+                        for (int i = 0; i < width; ++i) {
+                            dst[i] ^= other[i];
+                        }
+                    } else {
+                        // Сложение с последовательным переносом одновременно для всех векторов;
+                        // вычитание как a + ~b + 1
+                        uint64_t invert = expr.op == '-' ? ~0ull : 0;
+                        uint64_t carry = invert;
+                        for (int i = 0; i < width; ++i) {
+                            uint64_t x = dst[i], y = other[i] ^ invert;
+                            dst[i] = x ^ y ^ carry;
+                            carry = (x & y) | (carry & (x ^ y));
+                        }
+                    }
+                    break;
+                }
+            }
+            break;
+        }
+    }
+    frame.stack.release(mark);
+}
+
+// Запись значения value в биты приемника target
+static void store(const LValue &target, const uint64_t *value, Frame &frame) {
+    const Net &net = frame.module.nets[target.net];
+    memcpy(frame.words + net.offset + target.lo, value, sizeof(uint64_t) * (target.hi - target.lo + 1));
+}
+
+static void executeStmt(const Stmt &stmt, uint64_t mask, Frame &frame) {
+    if (mask == 0) {
+        return;
+    }
+    WordStack::Mark mark = frame.stack.mark();
+    switch (stmt.kind) {
+        case Stmt::Block:
+            for (const unique_ptr<Stmt> &child : stmt.body) {
+                executeStmt(*child, mask, frame);
+            }
+            break;
+        case Stmt::If: {
+            uint64_t condition = reduceOr(evaluateSelf(*stmt.expr, frame), stmt.expr->width);
+            executeStmt(*stmt.then_stmt, mask & condition, frame);
+            if (stmt.else_stmt) {
+                executeStmt(*stmt.else_stmt, mask & ~condition, frame);
+            }
+            break;
+        }
+        case Stmt::Case: {
+            uint64_t remaining = mask;
+            for (const auto &item : stmt.items) {
+                uint64_t match = 0;
+                for (const unique_ptr<Expr> &label : item.first) {
+                    int width = max(stmt.expr->width, label->width);
+                    uint64_t *x = frame.stack.allocate(width);
+                    uint64_t *y = frame.stack.allocate(width);
+                    evaluateExpr(*stmt.expr, width, x, frame);
+                    evaluateExpr(*label, width, y, frame);
+                    uint64_t differ = 0;
+                    for (int i = 0; i < width; ++i) {
+                        differ |= x[i] ^ y[i];
+                    }
+                    match |= ~differ;
+                }
+                match &= remaining;
+                executeStmt(*item.second, match, frame);
+                remaining &= ~match;
+            }
+            if (stmt.else_stmt) {
+                executeStmt(*stmt.else_stmt, remaining, frame);
+            }
+            break;
+        }
+        case Stmt::NonBlocking: {
+            // Новое значение попадает в pending и становится видимым только после фронта
+            int target_width = stmt.target.hi - stmt.target.lo + 1;
+            int width = max(target_width, stmt.expr->width);
+            uint64_t *value = frame.stack.allocate(width);
+            evaluateExpr(*stmt.expr, width, value, frame);
+            const Net &net = frame.module.nets[stmt.target.net];
+            uint64_t *pending = frame.state->pending.data() + net.reg_offset + stmt.target.lo;
+            for (int i = 0; i < target_width; ++i) {
+                pending[i] = (mask & value[i]) | (~mask & pending[i]);
+            }
+            break;
+        }
+    }
+    frame.stack.release(mark);
+}
+
+// Вычисление экземпляра модуля: входы уже записаны в кадр words
+// При capture после установления логики вычисляются новые значения регистров
+static void evaluateModule(const CompiledModule &module, uint64_t *words, InstanceState *state, bool capture,
+                           WordStack &stack) {
+    Frame frame{module, words, state, stack};
+    for (int index : module.reg_nets) {
+        const Net &net = module.nets[index];
+        memcpy(words + net.offset, state->regs.data() + net.reg_offset, sizeof(uint64_t) * net.width);
+    }
+
+    for (int index : module.order) {
+        const Process &process = module.processes[index];
+        WordStack::Mark mark = stack.mark();
+        if (process.kind == Process::Assign) {
+            int target_width = process.target.hi - process.target.lo + 1;
+            int width = max(target_width, process.expr->width);
+            uint64_t *value = stack.allocate(width);
+            evaluateExpr(*process.expr, width, value, frame);
+            store(process.target, value, frame);
+        } else {
+            const CompiledModule &child = *process.module;
+            uint64_t *child_words = stack.allocate(child.frame_words);
+            fill(child_words, child_words + child.frame_words, 0);
+            for (const auto &input : process.inputs) {
+                const Net &port = child.nets[input.first];
+                int width = max(port.width, input.second->width);
+                uint64_t *value = stack.allocate(width);
+                evaluateExpr(*input.second, width, value, frame);
+                memcpy(child_words + port.offset, value, sizeof(uint64_t) * port.width);
+            }
+            InstanceState *child_state = state ? state->children[process.child_slot].get() : nullptr;
+            evaluateModule(child, child_words, child_state, capture, stack);
+            for (const auto &output : process.outputs) {
+                const Net &port = child.nets[output.first];
+                int target_width = output.second.hi - output.second.lo + 1;
+                uint64_t *value = stack.allocate(target_width);
+                int copied = min(port.width, target_width);
+                memcpy(value, child_words + port.offset, sizeof(uint64_t) * copied);
+                fill(value + copied, value + target_width, 0);
+                store(output.second, value, frame);
+            }
+        }
+        stack.release(mark);
+    }
+
+    if (capture && state && !module.always_blocks.empty()) {
+        state->pending = state->regs;
+        for (const unique_ptr<Stmt> &block : module.always_blocks) {
+            executeStmt(*block, ~0ull, frame);
+        }
+    }
+}
+
+// Перенос новых значений регистров всей иерархии
+static void commit(InstanceState &state) {
+    state.regs.swap(state.pending);
+    state.pending = state.regs;
+    for (const unique_ptr<InstanceState> &child : state.children) {
+        if (child) {
+            commit(*child);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------------------------
+
+VerilogSimulator::VerilogSimulator() : stack(make_unique<WordStack>()) {
+}
+
+VerilogSimulator::~VerilogSimulator() = default;
+
+bool VerilogSimulator::load(const string &source, const string &top, string &error) {
+    try {
+        modules.clear();
+        vector<Token> tokens = tokenize(source);
+        Parser parser(tokens);
+        // Начала определений: модуль с параметрами разбирается заново для каждого набора их значений
+        map<string, size_t> definitions;
+        while (!parser.atEnd()) {
+            size_t start = parser.current();
+            unique_ptr<CompiledModule> module = parser.parseModule();
+            string name = module->name;
+            if (modules.count(name)) {
+                throw SimulationError("модуль " + name + " определен повторно");
+            }
+            modules[name] = move(module);
+            definitions[name] = start;
+        }
+
+        auto it = modules.find(top);
+        if (it == modules.end()) {
+            throw SimulationError("верхний модуль " + top + " не найден");
+        }
+        auto resolve = [&](const Process &process) -> CompiledModule * {
+            string name = specializationName(process.module_name, process.parameters);
+            auto found = modules.find(name);
+            if (found == modules.end()) {
+                auto definition = definitions.find(process.module_name);
+                if (definition == definitions.end()) {
+                    return nullptr;
+                }
+                Parser specialization(tokens, definition->second, process.parameters);
+                found = modules.emplace(name, specialization.parseModule()).first;
+            }
+            return found->second.get();
+        };
+        vector<string> link_stack;
+        link(*it->second, resolve, link_stack);
+        top_module = it->second.get();
+        top_state = buildState(*top_module);
+        top_frame.assign(top_module->frame_words, 0);
+    } catch (const SimulationError &e) {
+        error = e.what();
+        top_module = nullptr;
+        return false;
+    }
+    return true;
+}
+
+int VerilogSimulator::netIndex(const string &name) const {
+    auto it = top_module->net_index.find(name);
+    if (it == top_module->net_index.end()) {
+        throw SimulationError("цепь " + name + " не найдена в модуле " + top_module->name);
+    }
+    return it->second;
+}
+
+// Значения записываются в срезы: бит i цепи - слово, разряд k которого равен биту i значения k-го вектора
+void VerilogSimulator::set(const string &name, const vector<BigUint> &values) {
+    const Net &net = top_module->nets[netIndex(name)];
+    for (int i = 0; i < net.width; ++i) {
+        uint64_t word = 0;
+        for (size_t lane = 0; lane < values.size() && lane < SIMULATION_LANES; ++lane) {
+            word |= static_cast<uint64_t>(values[lane].bit(i)) << lane;
+        }
+        top_frame[net.offset + i] = word;
+    }
+}
+
+void VerilogSimulator::set(const string &name, uint64_t value) {
+    const Net &net = top_module->nets[netIndex(name)];
+    for (int i = 0; i < net.width; ++i) {
+        top_frame[net.offset + i] = i < 64 && ((value >> i) & 1) ? ~0ull : 0;
+    }
+}
+
+vector<BigUint> VerilogSimulator::get(const string &name) const {
+    vector<BigUint> values(SIMULATION_LANES);
+    const Net &net = top_module->nets[netIndex(name)];
+    for (int i = 0; i < net.width; ++i) {
+        uint64_t word = top_frame[net.offset + i];
+        for (int lane = 0; word != 0; ++lane, word >>= 1) {
+            if (word & 1) {
+                values[lane].setBit(i, true);
+            }
+        }
+    }
+    return values;
+}
+
+BigUint VerilogSimulator::get(const string &name, int lane) const {
+    BigUint value;
+    const Net &net = top_module->nets[netIndex(name)];
+    for (int i = 0; i < net.width; ++i) {
+        if ((top_frame[net.offset + i] >> lane) & 1) {
+            value.setBit(i, true);
+        }
+    }
+    return value;
+}
+
+void VerilogSimulator::evaluate() {
+    evaluateModule(*top_module, top_frame.data(), top_state.get(), false, *stack);
+}
+
+void VerilogSimulator::clock() {
+    evaluateModule(*top_module, top_frame.data(), top_state.get(), true, *stack);
+    commit(*top_state);
+    evaluate();
+}
@@ -0,0 +1,60 @@
+#ifndef VERILOG_SIMULATOR_H
+#define VERILOG_SIMULATOR_H
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "big_uint.h"
+using namespace std;
+
+// Число векторов, вычисляемых за один проход: бит i каждой цепи хранится в 64-битном слове,
+// разряд k которого относится к k-му вектору
+const int SIMULATION_LANES = 64;
+
+struct CompiledModule;
+struct InstanceState;
+class WordStack;
+
+// Побитово-параллельный симулятор подмножества Verilog, которое выводит генератор:
+// модули с портами в стиле ANSI, wire/reg, assign, экземпляры подмодулей с именованными портами,
+// localparam и always @(posedge clk) с if/case и неблокирующими присваиваниями
+// Модули с параметрами #(parameter ...) разбираются заново для каждого набора значений параметров экземпляра;
+// условия generate if вычисляются при разборе, поэтому допустима рекурсия по параметрам
+// Умножение сигналов a * b вычисляется сдвигами и сложениями, атрибуты (* ... *) пропускаются
+// Все always-блоки считаются тактируемыми одним общим тактовым сигналом
+class VerilogSimulator {
+public:
+    VerilogSimulator();
+    ~VerilogSimulator();
+
+    // Разбор исходного текста и построение иерархии с верхним модулем top
+    // false и описание ошибки в error, если текст не разобран или модуль не найден
+    bool load(const string &source, const string &top, string &error);
+
+    // Значения входа name для всех SIMULATION_LANES векторов
+    void set(const string &name, const vector<BigUint> &values);
+    // Одинаковое значение входа name для всех векторов
+    void set(const string &name, uint64_t value);
+    // Значения цепи name верхнего модуля для всех векторов
+    vector<BigUint> get(const string &name) const;
+    // Значение цепи name для вектора lane
+    BigUint get(const string &name, int lane) const;
+
+    // Пересчет комбинационной логики
+    void evaluate();
+    // Фронт тактового сигнала: регистры получают новые значения, затем логика пересчитывается
+    void clock();
+
+private:
+    int netIndex(const string &name) const;
+
+    map<string, unique_ptr<CompiledModule>> modules;  // Разобранные модули по именам
+    const CompiledModule *top_module = nullptr;       // Верхний модуль
+    unique_ptr<InstanceState> top_state;              // Регистры иерархии
+    vector<uint64_t> top_frame;                       // Значения цепей верхнего модуля
+    unique_ptr<WordStack> stack;                      // Память для цепей подмодулей и временных значений
+};
+
+#endif
@@ -0,0 +1,292 @@
+#include "../src/generator/verilog_generator.h"
+#include "../src/generator/report.h"
+#include "../src/simulator/test_vectors.h"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/resource.h>
+#include <unistd.h>
+
+using namespace std;
+
+// Счетчики выделений памяти во всей программе
+static atomic<long long> allocation_count{0};
+static atomic<long long> allocated_bytes{0};
+
+void *operator new(size_t size) {
+    allocation_count.fetch_add(1, memory_order_relaxed);
+    allocated_bytes.fetch_add(static_cast<long long>(size), memory_order_relaxed);
+    if (void *pointer = malloc(size == 0 ? 1 : size)) {
+        return pointer;
+    }
+    throw bad_alloc();
+}
+
+void *operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void *pointer) noexcept {
+    free(pointer);
+}
+
+void operator delete[](void *pointer) noexcept {
+    free(pointer);
+}
+
+void operator delete(void *pointer, size_t) noexcept {
+    free(pointer);
+}
+
+void operator delete[](void *pointer, size_t) noexcept {
+    free(pointer);
+}
+
+// Буфер, который только считает выведенные байты
+class CountingBuffer : public streambuf {
+public:
+    long long bytes = 0;
+
+protected:
+    int overflow(int c) override {
+        bytes++;
+        return c;
+    }
+    streamsize xsputn(const char *, streamsize count) override {
+        bytes += count;
+        return count;
+    }
+};
+
+// Функция сброса пика резидентной памяти процесса (Linux 4.0+)
+// false, если сброс не поддерживается; тогда пик считается от начала работы
+bool resetPeakRss() {
+    ofstream clear_refs("/proc/self/clear_refs");
+    clear_refs << "5";
+    clear_refs.close();
+    return static_cast<bool>(clear_refs);
+}
+
+// Пик резидентной памяти в КБ
+long long peakRssKb() {
+    ifstream status("/proc/self/status");
+    string line;
+    while (getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) {
+            return stoll(line.substr(6));
+        }
+    }
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+// Измерение одной фазы: время, выведенные байты, выделения памяти и пик RSS
+// Фаза выполняется repeat раз, время - лучшее из запусков, выделения памяти - за первый запуск
+// Результат выводится одной строкой JSON
+class Benchmark {
+public:
+    Benchmark(ostream &out, int repeat) : out(out), repeat(repeat) {
+    }
+
+    // phase_body возвращает число выведенных байтов
+    void run(const string &scenario, const string &phase, int n, const function<long long()> &phase_body) {
+        resetPeakRss();
+        long long allocations = 0, bytes_allocated = 0, bytes = 0;
+        double seconds = 0;
+        for (int r = 0; r < repeat; ++r) {
+            long long allocations_before = allocation_count.load();
+            long long bytes_before = allocated_bytes.load();
+            auto start = chrono::steady_clock::now();
+            bytes = phase_body();
+            double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            if (r == 0) {
+                allocations = allocation_count.load() - allocations_before;
+                bytes_allocated = allocated_bytes.load() - bytes_before;
+                seconds = elapsed;
+            }
+            seconds = min(seconds, elapsed);
+        }
+        out << "{\"scenario\": \"" << scenario << "\", \"phase\": \"" << phase << "\", \"n\": " << n
+            << ", \"seconds\": " << seconds << ", \"bytes\": " << bytes << ", \"allocations\": " << allocations
+            << ", \"allocated_bytes\": " << bytes_allocated << ", \"peak_rss_kb\": " << peakRssKb() << "}" << endl;
+    }
+
+private:
+    ostream &out;
+    int repeat;
+};
+
+// Разрядности сумматоров и вычитателей, которые использует умножитель разрядности n
+void usedAdderWidths(int n, vector<int> &adders, vector<int> &subtractors) {
+    for (const ModuleReport &module : buildReport(n, GeneratorOptions()).modules) {
+        if (module.name.compare(0, 6, "adder_") == 0) {
+            adders.push_back(stoi(module.name.substr(6)));
+        } else if (module.name.compare(0, 11, "subtractor_") == 0) {
+            subtractors.push_back(stoi(module.name.substr(11)));
+        }
+    }
+}
+
+// Фазы генерации одной разрядности: обход дерева рекурсии без вывода текста, вывод сумматоров
+// и вычитателей, потоковая генерация модуля, запись в файл, генерация в строку и тестбенчи
+void sweep(Benchmark &benchmark, int n, const filesystem::path &work_dir) {
+    benchmark.run("sweep", "tree", n, [n]() {
+        buildReport(n, GeneratorOptions());
+        return 0LL;
+    });
+
+    vector<int> adders, subtractors;
+    usedAdderWidths(n, adders, subtractors);
+    benchmark.run("sweep", "adders", n, [&adders, &subtractors]() {
+        CountingBuffer buffer;
+        ostream sink(&buffer);
+        for (int width : adders) {
+            generateAdderModule(width, sink);
+        }
+        for (int width : subtractors) {
+            generateSubtractorModule(width, sink);
+        }
+        return buffer.bytes;
+    });
+
+    benchmark.run("sweep", "module", n, [n]() {
+        CountingBuffer buffer;
+        ostream sink(&buffer);
+        KaratsubaGenerator(sink).generate(n);
+        return buffer.bytes;
+    });
+
+    benchmark.run("sweep", "file", n, [n, &work_dir]() {
+        filesystem::path filename = work_dir / ("karatsuba_multiplier_" + to_string(n) + ".v");
+        {
+            ofstream file(filename);
+            KaratsubaGenerator(file).generate(n);
+        }
+        return static_cast<long long>(filesystem::file_size(filename));
+    });
+
+    benchmark.run("sweep", "string", n, [n]() {
+        return static_cast<long long>(generateVerilogModule(n).size());
+    });
+
+    benchmark.run("sweep", "testbench", n, [n]() {
+        return static_cast<long long>(generateTestbench(n).size());
+    });
+
+    benchmark.run("sweep", "vectors", n, [n]() {
+        CountingBuffer buffer;
+        ostream sink(&buffer);
+        writeVectorFile(n, 100, 1, sink);
+        return buffer.bytes;
+    });
+}
+
+// Пакетная генерация: каждая разрядность своим контекстом в нескольких потоках
+long long generateBatch(const vector<int> &widths, const GeneratorOptions &options, int jobs) {
+    atomic<size_t> next_index{0};
+    atomic<long long> bytes{0};
+    vector<thread> threads;
+    for (int t = 0; t < jobs; ++t) {
+        threads.emplace_back([&]() {
+            for (size_t i = next_index++; i < widths.size(); i = next_index++) {
+                CountingBuffer buffer;
+                ostream sink(&buffer);
+                KaratsubaGenerator(sink, options).generate(widths[i]);
+                bytes += buffer.bytes;
+            }
+        });
+    }
+    for (thread &t : threads) {
+        t.join();
+    }
+    return bytes.load();
+}
+
+// Функция разбора целого числа не меньше min_value; false, если str - не такое число
+bool parseAtLeast(const string &str, int min_value, int &value) {
+    if (str.empty() || str.size() > 9 || str.find_first_not_of("0123456789") != string::npos) {
+        return false;
+    }
+    value = stoi(str);
+    return value >= min_value;
+}
+
+int main(int argc, char *argv[]) {
+    int max_n = 16384;
+    int repeat = 3;
+    string output_filename;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        // Наименьшая разрядность фаз и пакета - 8, поэтому меньший -max оставил бы пакет пустым
+        if (arg == "-max" && i + 1 < argc && parseAtLeast(argv[i + 1], 8, max_n)) {
+            ++i;
+        } else if (arg == "-repeat" && i + 1 < argc && parseAtLeast(argv[i + 1], 1, repeat)) {
+            ++i;
+        } else if (arg == "-output" && i + 1 < argc) {
+            output_filename = argv[++i];
+        } else {
+            cerr << "Использование: karatsuba-bench [-max N] [-repeat R] [-output файл]\n"
+                    "N - число не меньше 8, R - не меньше 1" << endl;
+            return 1;
+        }
+    }
+
+    ofstream output_file;
+    if (!output_filename.empty()) {
+        output_file.open(output_filename);
+        if (!output_file) {
+            cerr << "Ошибка: Не удалось открыть файл для записи: " << output_filename << endl;
+            return 1;
+        }
+    }
+    Benchmark benchmark(output_filename.empty() ? cout : output_file, repeat);
+
+    filesystem::path work_dir = filesystem::temp_directory_path() / ("karatsuba-bench-" + to_string(getpid()));
+    filesystem::create_directories(work_dir);
+
+    for (int n = 8; n <= max_n; n *= 2) {
+        sweep(benchmark, n, work_dir);
+    }
+
+    // Пакет и библиотека: разрядности 8, 16, ..., min(max_n, 1024); n в результате - наибольшая из них
+    vector<int> widths;
+    for (int n = 8; n <= min(max_n, 1024); n += 8) {
+        widths.push_back(n);
+    }
+    int jobs = max(1u, thread::hardware_concurrency());
+    benchmark.run("batch", "module", widths.back(), [&widths, jobs]() {
+        return generateBatch(widths, GeneratorOptions(), jobs);
+    });
+    benchmark.run("library", "module", widths.back(), [&widths]() {
+        CountingBuffer buffer;
+        ostream sink(&buffer);
+        KaratsubaGenerator generator(sink);
+        for (int n : widths) {
+            generator.generate(n);
+        }
+        return buffer.bytes;
+    });
+
+    // Кэш: холодный запуск начинает с пустой папки кэша, теплый читает модули из заполненной
+    GeneratorOptions cached;
+    cached.cache_dir = (work_dir / "cache").string();
+    benchmark.run("cache_cold", "module", widths.back(), [&widths, &cached, jobs]() {
+        filesystem::remove_all(cached.cache_dir);
+        return generateBatch(widths, cached, jobs);
+    });
+    benchmark.run("cache_warm", "module", widths.back(), [&widths, &cached, jobs]() {
+        return generateBatch(widths, cached, jobs);
+    });
+
+    filesystem::remove_all(work_dir);
+    return 0;
+}
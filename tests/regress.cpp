@@ -0,0 +1,310 @@
+#include "../src/generator/module_cache.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+using namespace std;
+
+// Параметры генератора по умолчанию: комбинационный умножитель, конвейер, дерево Дадды и оптимизация списка соединений
+const vector<string> DEFAULT_CONFIGS = {"", "-pipeline-every 2", "-base dadda -cutoff 8", "-optimize-netlist"};
+const string DEFAULT_WIDTHS = "8,10,16,33,64,100,128";
+const string DEFAULT_CACHE_DIR = ".regress_cache";
+
+// Результат одного задания: разрядность с набором параметров генератора
+struct Job {
+    int n;
+    string config;
+    string status;              // "пройден", "из кэша" или описание ошибки
+    bool passed = false;
+    double generate_seconds = 0;
+    double simulate_seconds = 0;
+};
+
+// Функция разбора списка разрядностей в том же формате, что у karatsuba-gen: "8:64:8,100"
+bool parseWidths(const string &str, vector<int> &widths) {
+    stringstream items(str);
+    string item;
+    while (getline(items, item, ',')) {
+        vector<int> bounds;
+        stringstream parts(item);
+        string part;
+        while (getline(parts, part, ':')) {
+            if (part.empty() || part.find_first_not_of("0123456789") != string::npos || part.size() > 9 ||
+                stoi(part) <= 0) {
+                return false;
+            }
+            bounds.push_back(stoi(part));
+        }
+        if (bounds.size() == 1) {
+            widths.push_back(bounds[0]);
+        } else if ((bounds.size() == 2 || bounds.size() == 3) && bounds[0] <= bounds[1]) {
+            for (int width = bounds[0]; width <= bounds[1]; width += bounds.size() == 3 ? bounds[2] : 1) {
+                widths.push_back(width);
+            }
+        } else {
+            return false;
+        }
+    }
+    return !widths.empty();
+}
+
+string readFile(const filesystem::path &filename) {
+    ifstream file(filename, ios::binary);
+    stringstream ss;
+    ss << file.rdbuf();
+    return ss.str();
+}
+
+// Запуск команды оболочки с выводом в log; true при нулевом коде возврата
+bool run(const string &command, const filesystem::path &log) {
+    string full = command + " > '" + log.string() + "' 2>&1";
+    return system(full.c_str()) == 0;
+}
+
+double secondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// Регрессионный прогон: задания распределяются между потоками, каждое работает в своей временной папке
+// Симуляция пропускается, если в кэше есть успешный результат с тем же хэшем сгенерированного текста
+class Regression {
+public:
+    Regression(const string &generator, const string &simulator, const filesystem::path &cache_dir, int vectors)
+        : generator(generator), simulator(simulator), cache_dir(cache_dir), vectors(vectors) {
+        work_dir = filesystem::temp_directory_path() / ("karatsuba-regress-" + to_string(getpid()));
+    }
+
+    void runAll(vector<Job> &jobs, int threads) {
+        filesystem::create_directories(cache_dir);
+        filesystem::create_directories(work_dir);
+        atomic<size_t> next_index{0};
+        vector<thread> workers;
+        for (int t = 0; t < min(threads, static_cast<int>(jobs.size())); ++t) {
+            workers.emplace_back([&]() {
+                for (size_t i = next_index++; i < jobs.size(); i = next_index++) {
+                    runJob(jobs[i], work_dir / ("job_" + to_string(i)));
+                    lock_guard<mutex> lock(log_mutex);
+                    cout << "N=" << jobs[i].n << " [" << jobs[i].config << "]: " << jobs[i].status << endl;
+                }
+            });
+        }
+        for (thread &worker : workers) {
+            worker.join();
+        }
+        filesystem::remove_all(work_dir);
+    }
+
+private:
+    // Команда karatsuba-gen для разрядности n с параметрами config и выходным файлом output
+    string generatorCommand(const Job &job, const string &flags, const filesystem::path &output) const {
+        return generator + " " + to_string(job.n) + " " + job.config + flags +
+               (vectors > 0 ? " -vectors " + to_string(vectors) : "") + " -output '" + output.string() + "'";
+    }
+
+    // Задание: генерация, поиск в кэше по хэшу, симуляция и запись успешного результата в кэш
+    // Встроенный симулятор проверяет модуль через karatsuba-gen -verify, iverilog - через тестбенч и vvp
+    void runJob(Job &job, const filesystem::path &dir) {
+        filesystem::create_directories(dir);
+        filesystem::path module = dir / "mult.v", testbench = dir / "tb.v", log = dir / "log.txt";
+        bool iverilog = simulator == "iverilog";
+
+        auto start = chrono::steady_clock::now();
+        if (!run(generatorCommand(job, "", module), log) ||
+            (iverilog && !run(generatorCommand(job, " -test", testbench), log))) {
+            job.status = "ошибка генерации: " + firstLine(log);
+            filesystem::remove_all(dir);
+            return;
+        }
+        job.generate_seconds = secondsSince(start);
+
+        // Векторы тестбенча входят в хэш, потому что от них зависит результат симуляции
+        // Тестбенч читает векторы по абсолютному пути временной папки задания, который меняется
+        // между прогонами, поэтому путь перед хэшированием заменяется постоянной меткой
+        string key = simulator + "\n" + to_string(vectors) + "\n" + readFile(module);
+        if (iverilog) {
+            key += withoutPath(readFile(testbench), dir.string()) + readFile(dir / "tb.hex");
+        }
+        filesystem::path cache_entry = cache_dir / hashString(key);
+        if (filesystem::exists(cache_entry)) {
+            job.passed = true;
+            job.status = "из кэша";
+            filesystem::remove_all(dir);
+            return;
+        }
+
+        start = chrono::steady_clock::now();
+        if (iverilog) {
+            filesystem::path compiled = dir / "sim.vpp";
+            job.passed = run("iverilog -o '" + compiled.string() + "' '" + module.string() + "' '" +
+                             testbench.string() + "'", log) &&
+                         run("vvp '" + compiled.string() + "'", log) &&
+                         readFile(log).find("All tests passed.") != string::npos;
+        } else {
+            job.passed = run(generatorCommand(job, " -verify", dir / "verify.v"), log);
+        }
+        job.simulate_seconds = secondsSince(start);
+        job.status = job.passed ? "пройден" : "ошибка симуляции: " + firstLine(log);
+        if (job.passed) {
+            ofstream(cache_entry) << job.n << " " << job.config << "\n";
+        }
+        filesystem::remove_all(dir);
+    }
+
+    // Текст text, в котором каждое вхождение path заменено меткой <job>
+    static string withoutPath(string text, const string &path) {
+        for (size_t pos = text.find(path); pos != string::npos; pos = text.find(path, pos)) {
+            text.replace(pos, path.size(), "<job>");
+        }
+        return text;
+    }
+
+    // Первая строка с сообщением об ошибке или последняя строка журнала
+    static string firstLine(const filesystem::path &log) {
+        stringstream lines(readFile(log));
+        string line, last;
+        while (getline(lines, line)) {
+            if (line.find("Ошибка") != string::npos || line.find("error") != string::npos ||
+                line.find("Errors found") != string::npos) {
+                return line;
+            }
+            if (!line.empty()) {
+                last = line;
+            }
+        }
+        return last;
+    }
+
+    string generator;
+    string simulator;
+    filesystem::path cache_dir;
+    filesystem::path work_dir;
+    int vectors;
+    mutex log_mutex;
+};
+
+// Дополнение строки пробелами до width символов; символы UTF-8 считаются по одному
+string pad(const string &text, size_t width, bool align_left) {
+    size_t length = count_if(text.begin(), text.end(), [](char c) { return (c & 0xC0) != 0x80; });
+    string padding(width > length ? width - length : 0, ' ');
+    return align_left ? text + padding : padding + text;
+}
+
+string formatSeconds(double seconds) {
+    stringstream ss;
+    ss << fixed << setprecision(3) << seconds;
+    return ss.str();
+}
+
+// Функция вывода итоговой таблицы: задания по параметрам и разрядностям
+void printSummary(vector<Job> jobs, double seconds, ostream &out) {
+    stable_sort(jobs.begin(), jobs.end(), [](const Job &a, const Job &b) {
+        return a.config != b.config ? a.config < b.config : a.n < b.n;
+    });
+    out << "\n" << pad("N", 8, true) << pad("Параметры", 28, true) << pad("Генерация, с", 14, false)
+        << pad("Симуляция, с", 14, false) << "   Результат\n";
+    int passed = 0, cached = 0;
+    for (const Job &job : jobs) {
+        out << pad(to_string(job.n), 8, true) << pad(job.config.empty() ? "-" : job.config, 28, true)
+            << pad(formatSeconds(job.generate_seconds), 14, false) << pad(formatSeconds(job.simulate_seconds), 14, false)
+            << "   " << job.status << "\n";
+        passed += job.passed;
+        cached += job.status == "из кэша";
+    }
+    out << "\nПройдено: " << passed << " из " << jobs.size() << " (из кэша: " << cached << "), время "
+        << fixed << setprecision(1) << seconds << " с" << endl;
+}
+
+// Функция разбора целого числа не меньше min_value; false, если str - не такое число
+bool parseAtLeast(const string &str, int min_value, int &value) {
+    if (str.empty() || str.size() > 9 || str.find_first_not_of("0123456789") != string::npos) {
+        return false;
+    }
+    value = stoi(str);
+    return value >= min_value;
+}
+
+int main(int argc, char *argv[]) {
+    string widths_str = DEFAULT_WIDTHS;
+    vector<string> configs;
+    string generator = "bin/karatsuba-gen";
+    string simulator = "auto";
+    string cache_dir = DEFAULT_CACHE_DIR;
+    int vectors = 0;
+    int jobs = max(1u, thread::hardware_concurrency());
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "-widths" && i + 1 < argc) {
+            widths_str = argv[++i];
+        } else if (arg == "-config" && i + 1 < argc) {
+            configs.push_back(argv[++i]);
+        } else if (arg == "-gen" && i + 1 < argc) {
+            generator = argv[++i];
+        } else if (arg == "-sim" && i + 1 < argc) {
+            simulator = argv[++i];
+        } else if (arg == "-cache" && i + 1 < argc) {
+            cache_dir = argv[++i];
+        } else if (arg == "-no-cache") {
+            cache_dir.clear();
+        } else if (arg == "-vectors" && i + 1 < argc && parseAtLeast(argv[i + 1], 0, vectors)) {
+            ++i;
+        } else if (arg == "-j" && i + 1 < argc && parseAtLeast(argv[i + 1], 1, jobs)) {
+            ++i;
+        } else {
+            cerr << "Использование: karatsuba-regress [-widths список] [-config \"аргументы\"]... [-sim auto|iverilog|builtin]"
+                    " [-gen karatsuba-gen] [-cache папка | -no-cache] [-vectors V] [-j потоки]\n"
+                    "V - число не меньше 0, потоков - не меньше 1" << endl;
+            return 1;
+        }
+    }
+
+    vector<int> widths;
+    if (!parseWidths(widths_str, widths)) {
+        cerr << "Ошибка: Некорректный список разрядностей: " << widths_str << endl;
+        return 1;
+    }
+    if (configs.empty()) {
+        configs = DEFAULT_CONFIGS;
+    }
+    if (simulator == "auto") {
+        simulator = system("command -v iverilog > /dev/null 2>&1") == 0 ? "iverilog" : "builtin";
+    } else if (simulator != "iverilog" && simulator != "builtin") {
+        cerr << "Ошибка: Необходимо передать auto, iverilog или builtin после аргумента -sim." << endl;
+        return 1;
+    }
+
+    // Без кэша результаты пишутся во временную папку и удаляются после прогона
+    bool temporary_cache = cache_dir.empty();
+    filesystem::path cache_path = temporary_cache
+        ? filesystem::temp_directory_path() / ("karatsuba-regress-cache-" + to_string(getpid()))
+        : filesystem::path(cache_dir);
+
+    vector<Job> job_list;
+    for (const string &config : configs) {
+        for (int n : widths) {
+            job_list.push_back({n, config, ""});
+        }
+    }
+    cout << "Заданий: " << job_list.size() << ", симулятор: " << simulator << ", потоков: " << jobs << endl;
+
+    auto start = chrono::steady_clock::now();
+    Regression regression(generator, simulator, cache_path, vectors);
+    regression.runAll(job_list, jobs);
+    printSummary(job_list, secondsSince(start), cout);
+
+    if (temporary_cache) {
+        filesystem::remove_all(cache_path);
+    }
+    bool failed = any_of(job_list.begin(), job_list.end(), [](const Job &job) { return !job.passed; });
+    return failed ? 1 : 0;
+}
@@ -1,14 +1,25 @@
 #include "gtest/gtest.h"
 #include "../src/generator/verilog_generator.h"
+#include "../src/generator/report.h"
+#include "../src/generator/module_directory.h"
+#include "../src/simulator/test_vectors.h"
+#include "../src/simulator/verifier.h"
+#include "../src/simulator/verilog_simulator.h"
 #include <fstream>
+#include <sstream>
 #include <cstdlib>
 #include <cstdio>
+#include <chrono>
+#include <filesystem>
+#include <thread>
+#include <vector>
 
 using namespace std;
 const string test_multiplier_filename = "test_karatsuba_multiplier.v";
 const string test_testbench_filename = "test_tb_karatsuba_multiplier.v";
 const string test_compiled_filename = "test_compiled.vpp";
 const string test_log_filename = "test_log.log";
+const string test_vectors_filename = "test_vectors.hex";
 
 // Тесты для функции generateTestbench при малом значении N
 TEST(UnitTest, GenerateTestbenchForN3) {
@@ -37,6 +48,1082 @@ TEST(UnitTest, GenerateTestbenchForN10) {
     EXPECT_NE(result.find("for (j = 0; j < MAX; j = j + 32)"), string::npos);
 }
 
+// Тест тестбенча для большого N: границы перебора не переполняются, каждый операнд принимает 64 значения
+TEST(UnitTest, GenerateTestbenchForN100) {
+    string result = generateTestbench(100);
+    EXPECT_NE(result.find("parameter [N:0] MAX = {1'b1, {N{1'b0}}};"), string::npos);
+    EXPECT_NE(result.find("reg [N:0] i, j;"), string::npos);
+    EXPECT_NE(result.find("for (i = 0; i < MAX; i = i + {1'b1, {94{1'b0}}})"), string::npos);
+}
+
+// Тест тестбенча с векторами из файла и самого файла векторов
+TEST(UnitTest, GenerateVectorFileTestbench) {
+    TestbenchVectors vectors;
+    vectors.filename = "vectors.hex";
+    vectors.count = 20;
+    string result = generateTestbench(256, GeneratorOptions(), vectors);
+    EXPECT_NE(result.find("parameter VECTORS = 20;"), string::npos);
+    EXPECT_NE(result.find("reg [2*N-1:0] vector_mem [0:3*VECTORS-1];"), string::npos);
+    EXPECT_NE(result.find("$readmemh(\"vectors.hex\", vector_mem);"), string::npos);
+    EXPECT_EQ(result.find("MAX"), string::npos);
+
+    GeneratorOptions pipelined;
+    pipelined.pipeline_every = 2;
+    string pipelined_result = generateTestbench(256, pipelined, vectors);
+    EXPECT_NE(pipelined_result.find("apply_vector(vector_mem[3*i], vector_mem[3*i+1], vector_mem[3*i+2]);"), string::npos);
+    EXPECT_NE(pipelined_result.find("expected_pipe[0] = vp;"), string::npos);
+
+    // Строка файла: x, y и точное произведение; первыми идут граничные значения
+    stringstream file;
+    writeVectorFile(256, 20, 7, file);
+    string line;
+    int lines = 0;
+    while (getline(file, line)) {
+        stringstream words(line);
+        string x_hex, y_hex, product_hex;
+        ASSERT_TRUE(static_cast<bool>(words >> x_hex >> y_hex >> product_hex));
+        BigUint x, y, product;
+        ASSERT_TRUE(BigUint::parse(x_hex, 16, x) && BigUint::parse(y_hex, 16, y) && BigUint::parse(product_hex, 16, product));
+        EXPECT_LE(x.bitLength(), 256);
+        EXPECT_EQ(x * y, product);
+        if (lines == 1) {
+            EXPECT_EQ(x, BigUint::allOnes(256));
+        }
+        lines++;
+    }
+    EXPECT_EQ(lines, 20);
+}
+
+// Тест потоковой генерации: модули выводятся в порядке зависимостей, каждый ровно один раз
+TEST(UnitTest, GenerateModuleStreamsInDependencyOrder) {
+    stringstream ss;
+    generateVerilogModule(100, ss);
+    string result = ss.str();
+
+    EXPECT_EQ(result, generateVerilogModule(100));
+
+    // Верхний модуль выводится последним
+    size_t top = result.find("module karatsuba_mult_100(");
+    ASSERT_NE(top, string::npos);
+    EXPECT_EQ(result.find("module ", top + 1), string::npos);
+
+    // Каждый подмодуль определен один раз и раньше первого использования
+    for (const string name : {"karatsuba_mult_50", "karatsuba_mult_51", "adder_51", "subtractor_102", "adder_200"}) {
+        size_t definition = result.find("module " + name + "(");
+        ASSERT_NE(definition, string::npos) << name;
+        EXPECT_LT(definition, result.find(name + " ")) << name;
+        EXPECT_EQ(result.find("module " + name + "(", definition + 1), string::npos) << name;
+    }
+}
+
+// Тест реентерабельности: параллельная генерация разных разрядностей совпадает с последовательной
+TEST(UnitTest, ParallelGenerationMatchesSequential) {
+    vector<int> widths = {17, 64, 100, 255};
+    vector<string> results(widths.size());
+    vector<thread> threads;
+    for (size_t i = 0; i < widths.size(); ++i) {
+        threads.emplace_back([&, i]() {
+            stringstream ss;
+            KaratsubaGenerator generator(ss);
+            generator.generate(widths[i]);
+            results[i] = ss.str();
+        });
+    }
+    for (thread &t : threads) {
+        t.join();
+    }
+
+    for (size_t i = 0; i < widths.size(); ++i) {
+        EXPECT_EQ(results[i], generateVerilogModule(widths[i])) << widths[i];
+    }
+}
+
+// Тест библиотеки: общие подмодули нескольких разрядностей выводятся один раз
+TEST(UnitTest, LibrarySharesSubmodulesAcrossWidths) {
+    stringstream ss;
+    KaratsubaGenerator generator(ss);
+    generator.generate(1024);
+    generator.generate(1025);
+    string library = ss.str();
+
+    EXPECT_NE(library.find("module karatsuba_mult_1024("), string::npos);
+    EXPECT_NE(library.find("module karatsuba_mult_1025("), string::npos);
+    size_t shared = library.find("module karatsuba_mult_512(");
+    ASSERT_NE(shared, string::npos);
+    EXPECT_EQ(library.find("module karatsuba_mult_512(", shared + 1), string::npos);
+}
+
+// Тест дискового кэша: повторная генерация берет модули из кэша и дает тот же результат
+TEST(UnitTest, ModuleCacheReusesGeneratedModules) {
+    string cache_dir = "test_module_cache";
+    filesystem::remove_all(cache_dir);
+
+    GeneratorOptions options;
+    options.cache_dir = cache_dir;
+
+    stringstream first;
+    KaratsubaGenerator(first, options).generate(100);
+    EXPECT_EQ(first.str(), generateVerilogModule(100));
+
+    // Подменяем модуль в кэше, чтобы убедиться, что второй запуск читает его из кэша
+    string cached_module = (filesystem::path(cache_dir) / hashString(options.key()) / "adder_200.v").string();
+    ASSERT_TRUE(filesystem::exists(cached_module));
+    ofstream(cached_module) << "// cached adder_200\n";
+
+    stringstream second;
+    KaratsubaGenerator(second, options).generate(100);
+    EXPECT_NE(second.str().find("// cached adder_200"), string::npos);
+
+    filesystem::remove_all(cache_dir);
+}
+
+// Тест папки модулей: модули в порядке зависимостей, повторная запись не трогает неизменные файлы
+TEST(UnitTest, ModuleDirectoryRewritesOnlyChangedModules) {
+    string dir = "test_module_directory";
+    filesystem::remove_all(dir);
+
+    string verilog = generateVerilogModule(16);
+    vector<ModuleText> modules = splitModules(verilog);
+    ASSERT_FALSE(modules.empty());
+    EXPECT_EQ(modules.back().name, "karatsuba_mult_16");
+    string joined;
+    for (const ModuleText &module : modules) {
+        joined += module.definition;
+    }
+    EXPECT_EQ(joined, verilog);
+
+    string error;
+    {
+        ModuleDirectory directory(dir, GeneratorOptions().manifestKey());
+        ASSERT_TRUE(directory.write("mult_16", modules, error)) << error;
+        ASSERT_TRUE(directory.writeManifest(error)) << error;
+        EXPECT_EQ(directory.writtenCount(), static_cast<int>(modules.size()));
+    }
+    ifstream list_file(filesystem::path(dir) / "mult_16.f");
+    string first_entry;
+    getline(list_file, first_entry);
+    EXPECT_EQ(first_entry, (filesystem::path(dir) / (modules.front().name + ".v")).string());
+
+    // Время изменения сдвигается в прошлое: перезаписанный файл получил бы текущее время
+    auto past = filesystem::file_time_type::clock::now() - chrono::hours(1);
+    string unchanged_path = (filesystem::path(dir) / (modules.front().name + ".v")).string();
+    string changed_path = (filesystem::path(dir) / "karatsuba_mult_16.v").string();
+    filesystem::last_write_time(unchanged_path, past);
+    filesystem::last_write_time(changed_path, past);
+
+    modules.back().definition = "// changed\n" + modules.back().definition;
+    ModuleDirectory directory(dir, GeneratorOptions().manifestKey());
+    ASSERT_TRUE(directory.write("mult_16", modules, error)) << error;
+    EXPECT_EQ(directory.writtenCount(), 1);
+    EXPECT_EQ(directory.unchangedCount(), static_cast<int>(modules.size()) - 1);
+    EXPECT_EQ(filesystem::last_write_time(unchanged_path), past);
+    EXPECT_NE(filesystem::last_write_time(changed_path), past);
+
+    ASSERT_TRUE(directory.writeManifest(error)) << error;
+    ifstream manifest(filesystem::path(dir) / "manifest.txt");
+    stringstream manifest_text;
+    manifest_text << manifest.rdbuf();
+    EXPECT_EQ(manifest_text.str().rfind("options " + GeneratorOptions().manifestKey() + "\n", 0), 0u);
+    EXPECT_NE(manifest_text.str().find("module karatsuba_mult_16.v " + hashString(modules.back().definition)),
+              string::npos);
+
+    // Запуск с тем же ключом и другим списком сохраняет списки и модули предыдущих запусков
+    vector<ModuleText> smaller = splitModules(generateVerilogModule(8));
+    {
+        ModuleDirectory next(dir, GeneratorOptions().manifestKey());
+        ASSERT_TRUE(next.write("mult_8", smaller, error)) << error;
+        ASSERT_TRUE(next.writeManifest(error)) << error;
+        EXPECT_EQ(next.removedCount(), 0);
+    }
+    for (const string &name : {string("mult_16.f"), string("mult_8.f"), string("karatsuba_mult_16.v"),
+                               string("karatsuba_mult_8.v"), modules.front().name + ".v"}) {
+        EXPECT_TRUE(filesystem::exists(filesystem::path(dir) / name)) << name;
+    }
+    ifstream next_manifest(filesystem::path(dir) / "manifest.txt");
+    stringstream next_text;
+    next_text << next_manifest.rdbuf();
+    EXPECT_NE(next_text.str().find("list mult_16.f "), string::npos);
+    EXPECT_NE(next_text.str().find("list mult_8.f "), string::npos);
+
+    // После смены ключа файлы, которые запуск не записал, удаляются вместе с записями манифеста
+    GeneratorOptions other;
+    other.cutoff = 4;
+    stringstream other_code;
+    KaratsubaGenerator(other_code, other).generate(8);
+    ModuleDirectory pruned(dir, other.manifestKey());
+    ASSERT_TRUE(pruned.write("mult_8", splitModules(other_code.str()), error)) << error;
+    ASSERT_TRUE(pruned.writeManifest(error)) << error;
+    EXPECT_GT(pruned.removedCount(), 0);
+    EXPECT_FALSE(filesystem::exists(changed_path));
+    EXPECT_FALSE(filesystem::exists(filesystem::path(dir) / "mult_16.f"));
+    EXPECT_TRUE(filesystem::exists(filesystem::path(dir) / "karatsuba_mult_8.v"));
+    ifstream pruned_manifest(filesystem::path(dir) / "manifest.txt");
+    stringstream pruned_text;
+    pruned_text << pruned_manifest.rdbuf();
+    EXPECT_EQ(pruned_text.str().find("karatsuba_mult_16.v"), string::npos);
+    EXPECT_EQ(pruned_text.str().find("mult_16.f"), string::npos);
+
+    filesystem::remove_all(dir);
+}
+
+// Тест порога рекурсии: разрядности не больше cutoff умножаются напрямую
+TEST(UnitTest, CutoffStopsRecursion) {
+    GeneratorOptions options;
+    options.cutoff = 17;
+    stringstream ss;
+    KaratsubaGenerator(ss, options).generate(32);
+    string result = ss.str();
+
+    EXPECT_NE(result.find("// Прямое умножение для 17-битных чисел"), string::npos);
+    EXPECT_EQ(result.find("module karatsuba_mult_8("), string::npos);
+    EXPECT_NE(options.key(), GeneratorOptions().key());
+}
+
+// Тест модели стоимости: малые разрядности умножаются напрямую, большие - рекурсивно
+TEST(UnitTest, CostModelChoosesCutoff) {
+    CostModel area_model(OptimizationGoal::Area);
+    EXPECT_TRUE(area_model.preferDirect(8));
+    EXPECT_FALSE(area_model.preferDirect(1024));
+    EXPECT_LT(area_model.cost(1024).area, CostModel::directCost(1024).area);
+
+    // Плоская сумма - цепочка сумматоров, поэтому по глубине выгодна рекурсия
+    CostModel depth_model(OptimizationGoal::Depth);
+    EXPECT_FALSE(depth_model.preferDirect(1024));
+    EXPECT_LT(depth_model.cost(1024).depth, CostModel::directCost(1024).depth);
+    EXPECT_LT(CostModel::directCost(32, false, BaseMultiplier::Dadda).depth, CostModel::directCost(32).depth);
+
+    // Дерево сжатия по глубине не хуже рекурсии, но разрядность прямого умножения ограничена
+    for (OptimizationGoal goal : {OptimizationGoal::Depth, OptimizationGoal::AreaDepth}) {
+        CostModel tree_model(goal, false, 0, false, BaseMultiplier::Dadda);
+        EXPECT_FALSE(tree_model.preferDirect(1024));
+        EXPECT_FALSE(tree_model.preferDirect(MAX_DIRECT_WIDTH + 1));
+    }
+}
+
+// Тест базового умножителя: дерево Дадды из ячеек full_adder/half_adder и итоговый сумматор
+TEST(UnitTest, DaddaTreeBaseMultiplier) {
+    GeneratorOptions options;
+    options.cutoff = 8;
+    options.base = BaseMultiplier::Dadda;
+    stringstream ss;
+    KaratsubaGenerator(ss, options).generate(8);
+    string result = ss.str();
+
+    // Дерево Дадды для n x n бит содержит n^2 - 4n + 3 полных сумматоров и n - 1 полусумматоров
+    auto count = [&result](const string &pattern) {
+        size_t occurrences = 0;
+        for (size_t pos = result.find(pattern); pos != string::npos; pos = result.find(pattern, pos + 1)) {
+            occurrences++;
+        }
+        return occurrences;
+    };
+    EXPECT_EQ(count("\nfull_adder "), 35u);
+    EXPECT_EQ(count("\nhalf_adder "), 7u);
+    EXPECT_EQ(count("module full_adder("), 1u);
+    EXPECT_NE(result.find("adder_16 product_final ("), string::npos);
+    EXPECT_EQ(result.find("<< 14)"), string::npos);
+    EXPECT_NE(options.key(), GeneratorOptions().key());
+}
+
+// Тест выбора архитектуры сумматоров по порогу разрядности
+TEST(UnitTest, AdderSelectionByWidth) {
+    GeneratorOptions options;
+    ASSERT_TRUE(parseAdderSelection("ks:>=64,ripple:<64", options.adders));
+    EXPECT_EQ(options.adders.select(200), AdderStyle::KoggeStone);
+    EXPECT_EQ(options.adders.select(51), AdderStyle::Ripple);
+    EXPECT_EQ(options.adders.key(), "ks:>=64,ripple:<64");
+
+    AdderSelection invalid;
+    EXPECT_FALSE(parseAdderSelection("ks:=64", invalid));
+    EXPECT_FALSE(parseAdderSelection("fast", invalid));
+
+    stringstream ss;
+    KaratsubaGenerator(ss, options).generate(100);
+    string result = ss.str();
+
+    // Сеть Когге-Стоуна на 201 позицию (200 разрядов и входной перенос) имеет 8 уровней
+    size_t adder_200 = result.find("module adder_200(");
+    ASSERT_NE(adder_200, string::npos);
+    EXPECT_NE(result.find("// Сумматор Когге-Стоуна", adder_200), string::npos);
+    EXPECT_NE(result.find("wire [200:0] g8, p8;", adder_200), string::npos);
+    EXPECT_EQ(result.find("wire [200:0] g9, p9;", adder_200), string::npos);
+    EXPECT_NE(result.find("assign c[51] = "), string::npos);
+    EXPECT_EQ(result.find("assign diff = a - b;"), string::npos);
+}
+
+// Тест сборки результата уровня деревом сжатия: без вычитателей, один сумматор на уровень
+TEST(UnitTest, CarrySaveRecombinationUsesSingleAdder) {
+    GeneratorOptions options;
+    options.carry_save = true;
+    stringstream ss;
+    KaratsubaGenerator(ss, options).generate(100);
+    string result = ss.str();
+
+    EXPECT_EQ(result.find("subtractor_"), string::npos);
+    EXPECT_NE(result.find("module csa_200("), string::npos);
+    size_t top = result.find("module karatsuba_mult_100(");
+    ASSERT_NE(top, string::npos);
+    EXPECT_NE(result.find("csa_200 csa2 (", top), string::npos);
+    EXPECT_EQ(result.find("csa_200 csa3 (", top), string::npos);
+    EXPECT_NE(result.find("adder_200 adder_final (", top), string::npos);
+    EXPECT_EQ(result.find("adder_200 adder1 (", top), string::npos);
+    EXPECT_NE(options.key(), GeneratorOptions().key());
+}
+
+// Тест оптимизации списка соединений: сумматоры сдвинутых слагаемых и вычитатели сужаются
+TEST(UnitTest, NetlistTrimsRecombination) {
+    // Младшие нулевые биты операнда проходят мимо сумматора, старшие нулевые позиции отбрасываются
+    Netlist netlist;
+    Bus a = netlist.bus(netlist.addInput("a", 4));
+    Bus b = netlist.bus(netlist.addInput("b", 4));
+    Bus sum = netlist.addCell(CellKind::Adder, "adder", 8, {resizeBus(concatBus(constantBus(2, 0), a), 8), resizeBus(b, 8)}, {"sum"})[0];
+    netlist.setOutput("result", sum);
+    netlist.optimize();
+    EXPECT_EQ(netlist.cells[0].width, 5);
+    EXPECT_EQ(netlist.expression(netlist.output), "{1'b0, sum, b[1:0]}");
+
+    GeneratorOptions options;
+    options.optimize_netlist = true;
+    stringstream ss;
+    KaratsubaGenerator(ss, options).generate(7);
+    string result = ss.str();
+
+    // 7 -> z1 < 2^8: вычитатели 8 бит вместо 10, сумматоры 6 и 10 бит вместо 14
+    size_t top = result.find("module karatsuba_mult_7(");
+    ASSERT_NE(top, string::npos);
+    EXPECT_NE(result.find("subtractor_8 sub1 (", top), string::npos);
+    EXPECT_NE(result.find("adder_6 adder1 (", top), string::npos);
+    EXPECT_NE(result.find("adder_10 adder2 (", top), string::npos);
+    EXPECT_NE(result.find("assign product = {temp_sum2, z0_0[3:0]};", top), string::npos);
+    EXPECT_EQ(result.find("subtractor_10"), string::npos);
+    EXPECT_EQ(result.find("adder_14"), string::npos);
+}
+
+// Тест конвейерного режима: порты clk/rst, выравнивание задержек и латентность в тестбенче
+TEST(UnitTest, PipelinedModuleHasFixedLatency) {
+    GeneratorOptions options;
+    options.pipeline_every = 1;
+    stringstream ss;
+    KaratsubaGenerator generator(ss, options);
+    generator.generate(4);
+    string result = ss.str();
+
+    // 4 -> {2, 2, 3}, 3 -> {1, 2}: каждый уровень добавляет один регистр
+    EXPECT_EQ(generator.height(4), 2);
+    EXPECT_EQ(generator.latency(4), 3);
+    EXPECT_NE(result.find("    input clk,\n    input rst,\n"), string::npos);
+    EXPECT_NE(result.find("reg [3:0] z2_0_d1;"), string::npos);
+    EXPECT_NE(result.find("assign product = product_comb_d1;"), string::npos);
+
+    string testbench = generateTestbench(4, options);
+    EXPECT_NE(testbench.find("parameter LATENCY = 3;"), string::npos);
+    EXPECT_NE(testbench.find("apply_vector(i, j);"), string::npos);
+
+    // Число ступеней пересчитывается в интервал между регистрами
+    GeneratorOptions staged;
+    staged.pipeline_stages = 1;
+    staged.resolvePipelineStages(4);
+    EXPECT_EQ(staged.pipeline_every, 3);
+}
+
+// Тест последовательного режима: один подмодуль на уровень, автомат со start/done и число тактов
+TEST(UnitTest, FoldedModuleSharesOneMultiplier) {
+    GeneratorOptions options;
+    options.fold_levels = 1;
+    options.resolveFolding(16);
+    EXPECT_EQ(options.fold_min_width, 9);
+
+    stringstream ss;
+    KaratsubaGenerator generator(ss, options);
+    generator.generate(16);
+    string result = ss.str();
+
+    // 16 -> общий karatsuba_mult_9, комбинационный подмодуль занимает один такт на произведение
+    EXPECT_TRUE(generator.isFolded(16));
+    EXPECT_FALSE(generator.isFolded(9));
+    EXPECT_EQ(generator.cycles(16), 4);
+    EXPECT_NE(result.find("module karatsuba_seq_16("), string::npos);
+    EXPECT_NE(result.find("karatsuba_mult_9 sub_mult ("), string::npos);
+    EXPECT_EQ(result.find("karatsuba_mult_8"), string::npos);
+    EXPECT_NE(result.find("    output reg done\n"), string::npos);
+
+    string testbench = generateTestbench(16, options);
+    EXPECT_NE(testbench.find("parameter CYCLES = 4;"), string::npos);
+    EXPECT_NE(testbench.find("karatsuba_seq_16 uut ("), string::npos);
+
+    // Второй уровень: подмодуль 9 тоже последовательный
+    GeneratorOptions two_levels;
+    two_levels.fold_levels = 2;
+    two_levels.resolveFolding(16);
+    EXPECT_EQ(two_levels.fold_min_width, 6);
+    ostream null_stream(nullptr);
+    EXPECT_EQ(KaratsubaGenerator(null_stream, two_levels).cycles(16), 3 * (4 + 2) + 1);
+}
+
+// Тест отчета: число экземпляров по иерархии, итоги уровней и глубина ступени конвейера
+TEST(UnitTest, ReportCountsHierarchy) {
+    DesignReport report = buildReport(7, GeneratorOptions());
+    EXPECT_EQ(report.top, "karatsuba_mult_7");
+    map<string, long long> instances;
+    for (const ModuleReport &module : report.modules) {
+        instances[module.name] = module.instances;
+    }
+    // 7 -> {3, 4, 5}, 5 -> {2, 3, 4}, 4 -> {2, 2, 3}, 3 -> {1, 2} и прямое p
+    EXPECT_EQ(instances["karatsuba_mult_4"], 2);
+    EXPECT_EQ(instances["karatsuba_mult_3"], 4);
+    EXPECT_EQ(instances["karatsuba_mult_2"], 9);
+    EXPECT_EQ(instances["subtractor_10"], 2);
+    ASSERT_EQ(report.levels.size(), 5u);
+    EXPECT_EQ(report.levels[1].multipliers, 3);
+    EXPECT_EQ(report.levels[0].adders, 6);
+
+    double level_gates = 0;
+    for (const LevelReport &level : report.levels) {
+        level_gates += level.logic.gates;
+    }
+    EXPECT_DOUBLE_EQ(level_gates, report.total.gates);
+
+    // Глубина прямого умножителя растет с разрядностью: цепочка плоской суммы, log_{3/2}(n) уровней дерева
+    GeneratorOptions direct;
+    direct.cutoff = 64;
+    EXPECT_EQ(buildReport(64, direct).depth, 63);
+    direct.base = BaseMultiplier::Dadda;
+    EXPECT_EQ(buildReport(64, direct).depth, 12);
+    EXPECT_LT(buildReport(64, GeneratorOptions()).depth, 63);
+
+    // Регистры на каждом уровне сокращают путь до одной ступени
+    GeneratorOptions pipelined;
+    pipelined.pipeline_every = 1;
+    DesignReport staged = buildReport(7, pipelined);
+    EXPECT_EQ(staged.latency, 5);
+    EXPECT_LT(staged.depth, report.depth);
+    EXPECT_GT(staged.total.registers, 0);
+
+    // Оптимизация списка соединений уменьшает сумматоры
+    GeneratorOptions optimized;
+    optimized.optimize_netlist = true;
+    EXPECT_LT(buildReport(7, optimized).total.gates, report.total.gates);
+
+    stringstream json;
+    printReportJson({report}, json);
+    EXPECT_NE(json.str().find("{\"name\": \"karatsuba_mult_2\", \"instances\": 9,"), string::npos);
+}
+
+// Тест прямоугольного умножителя: части широкого операнда, строки произведений и отчет
+TEST(UnitTest, RectangularMultiplier) {
+    RectangularSplit split = splitRectangular(10, 4);
+    EXPECT_EQ(split.parts, 3);
+    EXPECT_EQ(split.last_width, 2);
+    EXPECT_EQ(multiplierName(10, 4), "karatsuba_mult_10_4");
+    EXPECT_EQ(multiplierName(8, 8), "karatsuba_mult_8");
+
+    stringstream code;
+    KaratsubaGenerator(code).generate(10, 4);
+    string verilog = code.str();
+    EXPECT_NE(verilog.find("module karatsuba_mult_10_4(\n    input [9:0] x,\n    input [3:0] y,\n    output [13:0] product"),
+              string::npos);
+    EXPECT_NE(verilog.find("karatsuba_mult_4 mult_1 ("), string::npos);
+    EXPECT_NE(verilog.find("karatsuba_mult_2_4 mult_2 ("), string::npos);
+    EXPECT_NE(verilog.find("wire [13:0] row_odd = {pp_1, 4'b0};"), string::npos);
+    EXPECT_NE(verilog.find("adder_14 adder_rows ("), string::npos);
+    // Квадратный умножитель по широкому операнду не строится
+    EXPECT_EQ(verilog.find("module karatsuba_mult_10("), string::npos);
+
+    // 384 x 64: шесть умножителей 64 x 64 без рекурсии на 384 бит
+    stringstream wide;
+    KaratsubaGenerator(wide).generate(384, 64);
+    EXPECT_NE(wide.str().find("karatsuba_mult_64 mult_5 ("), string::npos);
+    EXPECT_EQ(wide.str().find("module karatsuba_mult_384("), string::npos);
+
+    DesignReport report = buildReport(384, GeneratorOptions(), 64);
+    EXPECT_EQ(report.top, "karatsuba_mult_384_64");
+    map<string, long long> instances;
+    for (const ModuleReport &module : report.modules) {
+        instances[module.name] = module.instances;
+    }
+    EXPECT_EQ(instances["karatsuba_mult_64"], 6);
+    EXPECT_EQ(instances["adder_448"], 1);
+    EXPECT_LT(report.total.gates, buildReport(384, GeneratorOptions()).total.gates);
+
+    string testbench = generateTestbench(10, GeneratorOptions(), TestbenchVectors(), 4);
+    EXPECT_NE(testbench.find("parameter M = 4;"), string::npos);
+    EXPECT_NE(testbench.find("wire [N+M-1:0] product;"), string::npos);
+    EXPECT_NE(testbench.find("karatsuba_mult_10_4 uut ("), string::npos);
+    EXPECT_NE(testbench.find("j < MAX_Y"), string::npos);
+}
+
+// Тест квадратора: один вход, рекурсия на квадраторах и вдвое меньше частичных произведений
+TEST(UnitTest, SquareModuleHasSingleInput) {
+    GeneratorOptions square;
+    square.square = true;
+    stringstream code;
+    KaratsubaGenerator(code, square).generate(16);
+    string verilog = code.str();
+    EXPECT_NE(verilog.find("module karatsuba_square_16(\n    input [15:0] x,\n    output [31:0] product"), string::npos);
+    EXPECT_NE(verilog.find("karatsuba_square_9 mult_3 (\n    .x(s1),\n    .product(p_3)"), string::npos);
+    EXPECT_EQ(verilog.find("karatsuba_mult_"), string::npos);
+    EXPECT_EQ(verilog.find("adder_s2"), string::npos);
+    EXPECT_EQ(verilog.find(".y("), string::npos);
+
+    // Прямой квадратор 3 бит: 3 бита на диагонали и 3 конъюнкции вместо 9
+    stringstream base;
+    generateSquareLogic(3, "a", "p", base);
+    EXPECT_EQ(base.str(), "// Прямое возведение в квадрат для 3-битного числа\n"
+                          "assign p = (a[0] << 0) + ((a[0] & a[1]) << 2) + ((a[0] & a[2]) << 3) + (a[1] << 2) + "
+                          "((a[1] & a[2]) << 4) + (a[2] << 4);\n");
+
+    // Квадратор меньше и не глубже умножителя при той же модели стоимости
+    GeneratorOptions multiplier;
+    multiplier.auto_cutoff = true;
+    square.auto_cutoff = true;
+    DesignReport multiplier_report = buildReport(256, multiplier);
+    DesignReport square_report = buildReport(256, square);
+    EXPECT_EQ(square_report.top, "karatsuba_square_256");
+    EXPECT_LT(square_report.total.gates, 0.7 * multiplier_report.total.gates);
+    EXPECT_LE(square_report.depth, multiplier_report.depth);
+
+    string testbench = generateTestbench(6, square);
+    EXPECT_NE(testbench.find("karatsuba_square_6 uut (\n        .x(a),\n        .product(product)"), string::npos);
+    EXPECT_NE(testbench.find("expected = i * i;"), string::npos);
+}
+
+// Тест уровня Toom-3: пять умножителей на точках 0, 1, 2, 1/2 и бесконечность и деление на 3 цепочкой сумматоров
+TEST(UnitTest, ToomCookSplitsIntoFiveProducts) {
+    ToomSplit split = splitToom3(30);
+    EXPECT_TRUE(split.valid);
+    EXPECT_EQ(split.k, 10);
+    EXPECT_EQ(split.high, 10);
+    EXPECT_EQ(split.sum_width, 12);
+    EXPECT_EQ(split.point_width, 13);
+    EXPECT_EQ(split.interpolation_width, 26);
+    EXPECT_FALSE(splitToom3(4).valid);
+
+    GeneratorOptions options;
+    options.toom_min_width = 30;
+    stringstream code;
+    KaratsubaGenerator(code, options).generate(30);
+    string verilog = code.str();
+    EXPECT_NE(verilog.find("karatsuba_mult_10 mult_0 (\n    .x(x[9:0]),\n    .y(y[9:0])"), string::npos);
+    EXPECT_NE(verilog.find("karatsuba_mult_12 mult_1 (\n    .x(x_e1),\n    .y(y_e1)"), string::npos);
+    EXPECT_NE(verilog.find("karatsuba_mult_13 mult_3 (\n    .x(x_eh),\n    .y(y_eh)"), string::npos);
+    EXPECT_NE(verilog.find("karatsuba_mult_10 mult_4 ("), string::npos);
+    EXPECT_NE(verilog.find("adder_26 adder_div3_3 (\n    .a(div3_2),\n    .b({div3_2[9:0], 16'b0})"), string::npos);
+    // Подмодули меньше toom_min_width делятся по Карацубе
+    EXPECT_NE(verilog.find("output [25:0] product\n);\n\nwire [6:0] x0 = x[6:0];"), string::npos);
+
+    // При выборе по модели стоимости Toom-3 уменьшает площадь большого умножителя
+    GeneratorOptions karatsuba;
+    karatsuba.goal = OptimizationGoal::Area;
+    karatsuba.auto_cutoff = true;
+    GeneratorOptions toom = karatsuba;
+    toom.toom_auto = true;
+    DesignReport karatsuba_report = buildReport(2048, karatsuba);
+    DesignReport toom_report = buildReport(2048, toom);
+    EXPECT_EQ(toom_report.modules[1].name, "karatsuba_mult_686");
+    EXPECT_LT(toom_report.total.gates, karatsuba_report.total.gates);
+}
+
+// Тест модульного умножителя: константы редукции, эталон на BigUint и текст верхнего модуля
+TEST(UnitTest, ModularMultiplierWrapsKaratsubaCores) {
+    BigUint value;
+    ASSERT_TRUE(BigUint::parse("123456789abcdef0123456789", 16, value));
+    EXPECT_EQ((value / BigUint(1000000007)).toHex(), "4e2fff8a480a8f033");
+    EXPECT_EQ((value % BigUint(1000000007)).toHex(), "11709824");
+    EXPECT_EQ((value - BigUint(1)).toHex(), "123456789abcdef0123456788");
+    EXPECT_EQ((value >> 68).toHex(), "12345678");
+    EXPECT_EQ((BigUint(3) << 70).toHex(), "c00000000000000000");
+    EXPECT_EQ(value.lowBits(8).toHex(), "89");
+
+    // M' = -M^-1 mod 2^16 и mu = floor(4^16 / M)
+    EXPECT_EQ(reductionConstant(ModularReduction::Montgomery, 16, BigUint(0xef69)).toHex(), "6f27");
+    EXPECT_EQ(reductionConstant(ModularReduction::Barrett, 16, BigUint(0xfff1)).toHex(), "1000f");
+    // 2^-16 mod 0xef69 = 0x67f3: 0xae5 * 0x459a * 0x9f0c mod 0xef69 = 0xd9a4
+    EXPECT_EQ(modularProduct(ModularReduction::Montgomery, 16, BigUint(0xae5), BigUint(0x459a), BigUint(0xef69)).toHex(),
+              "d9a4");
+    EXPECT_EQ(modularProduct(ModularReduction::Barrett, 16, BigUint(0xfff0), BigUint(0xfff0), BigUint(0xfff1)).toHex(), "1");
+
+    string error;
+    EXPECT_FALSE(checkModulus(ModularReduction::Montgomery, 16, BigUint(0xef68), error));
+    EXPECT_FALSE(checkModulus(ModularReduction::Barrett, 16, BigUint(0x8000), error));
+    EXPECT_FALSE(checkModulus(ModularReduction::Barrett, 16, BigUint(0x10001), error));
+    EXPECT_TRUE(checkModulus(ModularReduction::Barrett, 16, BigUint(0x8001), error));
+
+    GeneratorOptions montgomery;
+    montgomery.reduction = ModularReduction::Montgomery;
+    montgomery.modulus = BigUint(0xef69);
+    stringstream code;
+    KaratsubaGenerator(code, montgomery).generate(16);
+    string verilog = code.str();
+    EXPECT_NE(verilog.find("module montgomery_mult_16(\n    input [15:0] x,\n    input [15:0] y,\n    output [15:0] product\n);"),
+              string::npos);
+    EXPECT_NE(verilog.find("karatsuba_low_16 mult_q (\n    .x(t[15:0]),\n    .y(16'h6f27),"), string::npos);
+    EXPECT_NE(verilog.find("karatsuba_mult_16 mult_qm (\n    .x(q),\n    .y(16'hef69),"), string::npos);
+
+    GeneratorOptions barrett;
+    barrett.reduction = ModularReduction::Barrett;
+    barrett.pipeline_every = 1;
+    stringstream pipelined;
+    KaratsubaGenerator barrett_generator(pipelined, barrett);
+    barrett_generator.generate(16);
+    verilog = pipelined.str();
+    EXPECT_NE(verilog.find("    input [15:0] modulus,\n    input [16:0] mu,\n"), string::npos);
+    EXPECT_NE(verilog.find("karatsuba_mult_17 mult_q (\n    .clk(clk),\n    .rst(rst),\n    .x(t[31:15]),\n    .y(mu_d6),"),
+              string::npos);
+    EXPECT_NE(verilog.find("karatsuba_low_18 mult_qm (\n    .clk(clk),\n    .rst(rst),\n    .x({1'b0, q_full[33:17]}),\n"
+                           "    .y({2'b0, modulus_d12}),"),
+              string::npos);
+    // t * mu и t - полные произведения по 6 тактов, младшая половина q * M - 5 тактов
+    EXPECT_EQ(barrett_generator.modularLatency(16), 6 + 6 + 5);
+
+    DesignReport report = buildReport(16, barrett);
+    EXPECT_EQ(report.top, "barrett_mult_16");
+    EXPECT_EQ(report.latency, 17);
+    EXPECT_EQ(report.modules[1].name, "karatsuba_mult_17");
+    EXPECT_EQ(report.modules[1].instances, 1);
+}
+
+// Тест половин произведения: младшая половина не вычисляет z2, старшая отбрасывает легкие слагаемые
+TEST(UnitTest, HalfProductModulesDropUnusedTerms) {
+    GeneratorOptions low;
+    low.half = ProductHalf::Low;
+    stringstream code;
+    KaratsubaGenerator(code, low).generate(16);
+    string verilog = code.str();
+    EXPECT_NE(verilog.find("module karatsuba_low_16(\n    input [15:0] x,\n    input [15:0] y,\n    output [15:0] product\n);"),
+              string::npos);
+    EXPECT_NE(verilog.find("karatsuba_low_8 mult_c1 (\n    .x(x[15:8]),\n    .y(y[7:0]),"), string::npos);
+    EXPECT_NE(verilog.find("assign product = {high, z0[7:0]};"), string::npos);
+    EXPECT_EQ(verilog.find("module karatsuba_mult_16("), string::npos);
+
+    // Наименьшее число защитных битов с ошибкой меньше 2^16 - четыре, ошибка не больше 11 единиц результата
+    GeneratorOptions high;
+    high.half = ProductHalf::High;
+    stringstream high_code;
+    KaratsubaGenerator high_generator(high_code, high);
+    high_generator.generate(16);
+    verilog = high_code.str();
+    EXPECT_EQ(high_generator.highThreshold(16), 12);
+    EXPECT_EQ((high_generator.highErrorBound(16, 12) >> 12).toHex(), "b");
+    EXPECT_NE(verilog.find("module karatsuba_high_16_12(\n    input [15:0] x,\n    input [15:0] y,\n    output [19:0] product\n);"),
+              string::npos);
+    EXPECT_NE(verilog.find("karatsuba_mult_8 mult_z2 ("), string::npos);
+    EXPECT_NE(verilog.find("karatsuba_high_8_4 mult_c1 ("), string::npos);
+    // Прямое умножение без частичных произведений веса меньше 2^2
+    EXPECT_NE(verilog.find("// Разряды [3:2] прямого умножения для 2-битных чисел"), string::npos);
+
+    GeneratorOptions full;
+    full.cutoff = 16;
+    low.cutoff = 16;
+    high.cutoff = 16;
+    double full_gates = buildReport(64, full).total.gates;
+    EXPECT_LT(buildReport(64, low).total.gates, 0.6 * full_gates);
+    EXPECT_LT(buildReport(64, high).total.gates, 0.8 * full_gates);
+}
+
+// Тест потоковой обертки: вход через буфер skid, очередь на latency + 2 результата и аккумулятор пачки
+TEST(UnitTest, StreamWrapperQueuesResults) {
+    GeneratorOptions options;
+    options.stream = true;
+    options.accumulator_bits = 4;
+    options.pipeline_every = 1;
+    stringstream code;
+    KaratsubaGenerator generator(code, options);
+    generator.generate(16);
+    string verilog = code.str();
+    EXPECT_EQ(generator.streamLatency(16), generator.latency(16) + 2);
+    EXPECT_NE(verilog.find("    output m_last,\n    output [35:0] product\n);"), string::npos);
+    EXPECT_NE(verilog.find("assign s_ready = !skid_valid;"), string::npos);
+    EXPECT_NE(verilog.find("karatsuba_mult_16 core (\n    .clk(clk),\n    .rst(rst),\n    .x(in_x),"), string::npos);
+    EXPECT_NE(verilog.find("adder_36 adder_acc (\n    .a(acc),\n    .b({4'b0, core_product}),"), string::npos);
+    string last_slot = "queue_" + to_string(generator.streamLatency(16) - 1);
+    EXPECT_NE(verilog.find(last_slot + " <= acc_sum;"), string::npos);
+    EXPECT_EQ(verilog.find("queue_" + to_string(generator.streamLatency(16)) + " "), string::npos);
+
+    TestbenchVectors vectors;
+    vectors.filename = "vectors.hex";
+    vectors.count = 100;
+    string testbench = generateTestbench(16, options, vectors);
+    EXPECT_NE(testbench.find("module tb_karatsuba_stream_16;"), string::npos);
+    EXPECT_NE(testbench.find("parameter LATENCY = " + to_string(generator.streamLatency(16)) + ";"), string::npos);
+    EXPECT_NE(testbench.find("acc_model = acc_model + vector_mem[3*sent+2];"), string::npos);
+
+    DesignReport report = buildReport(16, options);
+    EXPECT_EQ(report.top, "karatsuba_stream_16");
+    EXPECT_EQ(report.latency, generator.streamLatency(16));
+    EXPECT_EQ(report.modules[1].name, "karatsuba_mult_16");
+}
+
+// Тест параметризованного режима: одно определение karatsuba_mult #(.N()) и обертки с прежними именами
+TEST(UnitTest, ParameterizedBackendIsCompact) {
+    GeneratorOptions options;
+    options.parameterized = true;
+    options.cutoff = 16;
+    stringstream code;
+    KaratsubaGenerator generator(code, options);
+    generator.generate(512);
+    generator.generate(100);
+    string verilog = code.str();
+    EXPECT_NE(verilog.find("module karatsuba_mult #(parameter N = 1, parameter CUTOFF = 16) ("), string::npos);
+    EXPECT_NE(verilog.find("module karatsuba_mult_100(\n    input [99:0] x,"), string::npos);
+    EXPECT_NE(verilog.find("karatsuba_mult #(.N(512)) mult ("), string::npos);
+    size_t modules = 0;
+    for (size_t pos = verilog.find("module "); pos != string::npos; pos = verilog.find("module ", pos + 1)) {
+        modules += pos == 0 || verilog[pos - 1] == '\n';
+    }
+    EXPECT_EQ(modules, 6u);
+
+    GeneratorOptions specialized;
+    specialized.cutoff = 16;
+    stringstream full;
+    KaratsubaGenerator(full, specialized).generate(512);
+    EXPECT_LT(verilog.size() * 5, full.str().size());
+}
+
+// Тест режима блоков DSP: покрытие блоками, остановка рекурсии и число блоков в отчете
+TEST(UnitTest, DspTargetTilesBaseMultipliers) {
+    DspShape shape = dspShape(DspTarget::Dsp48e2);
+    DspTiling tiling = tileDsp(18, shape);
+    EXPECT_EQ(tiling.blocks, 1);
+    EXPECT_EQ(tiling.y_rows, 1);
+    EXPECT_EQ(tileDsp(26, shape).blocks, 2);
+    EXPECT_EQ(tileDsp(34, shape).blocks, 4);
+    EXPECT_EQ(tileDsp(2, shape).blocks, 0);
+
+    GeneratorOptions options;
+    options.target = DspTarget::Dsp48e2;
+    stringstream code;
+    KaratsubaGenerator generator(code, options);
+    generator.generate(64);
+    string verilog = code.str();
+    EXPECT_NE(verilog.find("(* use_dsp = \"yes\" *)\nmodule dsp_mult_26x17("), string::npos);
+    EXPECT_EQ(verilog.find("module dsp_mult_26x17(", verilog.find("module dsp_mult_26x17(") + 1), string::npos);
+    // 64 -> 32, 32, 33 -> 16, 17, 18: блоки DSP вместо уровней ниже
+    EXPECT_TRUE(generator.isDirect(18));
+    EXPECT_FALSE(generator.isDirect(32));
+    EXPECT_EQ(verilog.find("module karatsuba_mult_9("), string::npos);
+    EXPECT_EQ(generator.dspBlocks(64), 9);
+
+    DesignReport report = buildReport(64, options);
+    EXPECT_EQ(report.total.dsps, 9);
+    EXPECT_EQ(report.target, "dsp48e2");
+    stringstream text;
+    printReportText(report, text);
+    EXPECT_NE(text.str().find("9 блоков dsp48e2"), string::npos);
+}
+
+// Вспомогательная функция проверки умножителя встроенным симулятором
+// m > 0 задает прямоугольный умножитель n x m
+VerificationResult verifyGenerated(int n, GeneratorOptions options, long long vectors = 1000, int m = 0) {
+    options.resolvePipelineStages(m > 0 ? min(n, m) : n);
+    options.resolveFolding(n);
+    stringstream moduleCode;
+    KaratsubaGenerator(moduleCode, options).generate(n, m > 0 ? m : n);
+    return verifyMultiplier(moduleCode.str(), n, options, vectors, 1, m);
+}
+
+// Тест встроенного симулятора на комбинационных умножителях с разными базовыми умножителями и сумматорами
+TEST(SimulatorTest, VerifiesCombinationalMultipliers) {
+    EXPECT_TRUE(verifyGenerated(1, GeneratorOptions()).passed);
+    EXPECT_TRUE(verifyGenerated(10, GeneratorOptions()).passed);
+    VerificationResult result = verifyGenerated(100, GeneratorOptions());
+    EXPECT_TRUE(result.passed) << result.message;
+    EXPECT_EQ(result.vectors, 1000);
+
+    GeneratorOptions structural;
+    structural.cutoff = 6;
+    structural.base = BaseMultiplier::Dadda;
+    parseAdderSelection("ks:>=32,sklansky:>=16,ripple", structural.adders);
+    EXPECT_TRUE(verifyGenerated(64, structural).passed);
+
+    GeneratorOptions carry_save;
+    carry_save.carry_save = true;
+    EXPECT_TRUE(verifyGenerated(33, carry_save).passed);
+
+    GeneratorOptions netlist;
+    netlist.optimize_netlist = true;
+    EXPECT_TRUE(verifyGenerated(100, netlist).passed);
+    netlist.carry_save = true;
+    netlist.pipeline_every = 2;
+    EXPECT_TRUE(verifyGenerated(45, netlist).passed);
+}
+
+// Тест встроенного симулятора на конвейерном и последовательном умножителях
+TEST(SimulatorTest, VerifiesClockedMultipliers) {
+    GeneratorOptions pipelined;
+    pipelined.pipeline_every = 1;
+    VerificationResult result = verifyGenerated(40, pipelined);
+    EXPECT_TRUE(result.passed) << result.message;
+    EXPECT_EQ(result.vectors, 1000);
+
+    GeneratorOptions folded;
+    folded.fold_levels = 2;
+    folded.pipeline_every = 2;
+    result = verifyGenerated(40, folded);
+    EXPECT_TRUE(result.passed) << result.message;
+}
+
+// Тест встроенного симулятора на прямоугольных умножителях
+TEST(SimulatorTest, VerifiesRectangularMultipliers) {
+    EXPECT_TRUE(verifyGenerated(10, GeneratorOptions(), 1000, 4).passed);
+    EXPECT_TRUE(verifyGenerated(4, GeneratorOptions(), 1000, 10).passed);
+    EXPECT_TRUE(verifyGenerated(9, GeneratorOptions(), 1000, 1).passed);
+    VerificationResult result = verifyGenerated(384, GeneratorOptions(), 1000, 64);
+    EXPECT_TRUE(result.passed) << result.message;
+
+    GeneratorOptions pipelined;
+    pipelined.pipeline_every = 1;
+    result = verifyGenerated(67, pipelined, 1000, 20);
+    EXPECT_TRUE(result.passed) << result.message;
+}
+
+// Тест встроенного симулятора на квадраторах с разными базовыми умножителями и сборкой результата
+TEST(SimulatorTest, VerifiesSquarers) {
+    GeneratorOptions square;
+    square.square = true;
+    EXPECT_TRUE(verifyGenerated(1, square).passed);
+    EXPECT_TRUE(verifyGenerated(3, square).passed);
+    VerificationResult result = verifyGenerated(100, square);
+    EXPECT_TRUE(result.passed) << result.message;
+
+    GeneratorOptions tree = square;
+    tree.cutoff = 12;
+    tree.base = BaseMultiplier::Dadda;
+    EXPECT_TRUE(verifyGenerated(97, tree).passed);
+    tree.base = BaseMultiplier::Wallace;
+    tree.carry_save = true;
+    EXPECT_TRUE(verifyGenerated(64, tree).passed);
+
+    GeneratorOptions netlist = square;
+    netlist.optimize_netlist = true;
+    netlist.pipeline_every = 2;
+    result = verifyGenerated(45, netlist);
+    EXPECT_TRUE(result.passed) << result.message;
+}
+
+// Тест встроенного симулятора на уровнях Toom-3 со всеми способами сборки и режимами
+TEST(SimulatorTest, VerifiesToomCook) {
+    GeneratorOptions options;
+    options.toom_min_width = 9;
+    for (int n : {9, 10, 11, 31, 100}) {
+        VerificationResult result = verifyGenerated(n, options);
+        EXPECT_TRUE(result.passed) << "N=" << n << ": " << result.message;
+    }
+
+    GeneratorOptions csa = options;
+    csa.carry_save = true;
+    csa.base = BaseMultiplier::Dadda;
+    csa.cutoff = 8;
+    EXPECT_TRUE(verifyGenerated(64, csa).passed);
+
+    GeneratorOptions netlist = options;
+    netlist.optimize_netlist = true;
+    netlist.pipeline_every = 1;
+    VerificationResult result = verifyGenerated(50, netlist);
+    EXPECT_TRUE(result.passed) << result.message;
+
+    GeneratorOptions square = options;
+    square.square = true;
+    result = verifyGenerated(77, square);
+    EXPECT_TRUE(result.passed) << result.message;
+
+    GeneratorOptions automatic;
+    automatic.toom_auto = true;
+    automatic.auto_cutoff = true;
+    automatic.goal = OptimizationGoal::Area;
+    result = verifyGenerated(700, automatic, 200);
+    EXPECT_TRUE(result.passed) << result.message;
+}
+
+// Тест встроенного симулятора на модульных умножителях с постоянным и входным модулем
+TEST(SimulatorTest, VerifiesModularMultipliers) {
+    GeneratorOptions montgomery;
+    montgomery.reduction = ModularReduction::Montgomery;
+    for (int n : {2, 3, 17, 64}) {
+        VerificationResult result = verifyGenerated(n, montgomery);
+        EXPECT_TRUE(result.passed) << "N=" << n << ": " << result.message;
+    }
+    // 2^255 - 19 с конвейером и уровнями Toom-3
+    GeneratorOptions fixed = montgomery;
+    ASSERT_TRUE(BigUint::parse("7fffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffed", 16, fixed.modulus));
+    fixed.pipeline_every = 2;
+    fixed.toom_min_width = 100;
+    VerificationResult result = verifyGenerated(255, fixed, 200);
+    EXPECT_TRUE(result.passed) << result.message;
+
+    GeneratorOptions barrett;
+    barrett.reduction = ModularReduction::Barrett;
+    for (int n : {2, 5, 40}) {
+        result = verifyGenerated(n, barrett);
+        EXPECT_TRUE(result.passed) << "N=" << n << ": " << result.message;
+    }
+    GeneratorOptions goldilocks = barrett;
+    goldilocks.modulus = BigUint(0xffffffff00000001ull);
+    goldilocks.carry_save = true;
+    goldilocks.pipeline_every = 1;
+    result = verifyGenerated(64, goldilocks);
+    EXPECT_TRUE(result.passed) << result.message;
+
+    // Результат без поправки неверен: симулятор это замечает
+    stringstream code;
+    KaratsubaGenerator(code, barrett).generate(12);
+    string verilog = code.str();
+    size_t correction = verilog.find("assign product = !r2[13]");
+    ASSERT_NE(correction, string::npos);
+    verilog.replace(correction, verilog.find(";", correction) - correction, "assign product = r[11:0]");
+    EXPECT_FALSE(verifyMultiplier(verilog, 12, barrett, 1000, 1).passed);
+}
+
+// Тест встроенного симулятора на половинах произведения: младшая сравнивается точно,
+// старшая - с floor(x * y / 2^t) с допустимой ошибкой
+TEST(SimulatorTest, VerifiesHalfProducts) {
+    GeneratorOptions low;
+    low.half = ProductHalf::Low;
+    GeneratorOptions high;
+    high.half = ProductHalf::High;
+    for (int n : {2, 3, 8, 17, 64}) {
+        VerificationResult result = verifyGenerated(n, low);
+        EXPECT_TRUE(result.passed) << "low N=" << n << ": " << result.message;
+        result = verifyGenerated(n, high);
+        EXPECT_TRUE(result.passed) << "high N=" << n << ": " << result.message;
+    }
+
+    GeneratorOptions guarded = high;
+    guarded.guard_bits = 0;
+    guarded.base = BaseMultiplier::Dadda;
+    guarded.cutoff = 8;
+    guarded.pipeline_every = 1;
+    VerificationResult result = verifyGenerated(100, guarded);
+    EXPECT_TRUE(result.passed) << result.message;
+
+    GeneratorOptions toom = low;
+    toom.toom_min_width = 30;
+    toom.pipeline_every = 2;
+    result = verifyGenerated(90, toom);
+    EXPECT_TRUE(result.passed) << result.message;
+
+    // Без одного перекрестного слагаемого младшая половина неверна
+    stringstream code;
+    KaratsubaGenerator(code, low).generate(12);
+    string verilog = code.str();
+    size_t cross = verilog.find("    .b(c2),");
+    ASSERT_NE(cross, string::npos);
+    verilog.replace(cross, string("    .b(c2),").size(), "    .b(c1),");
+    EXPECT_FALSE(verifyMultiplier(verilog, 12, low, 1000, 1).passed);
+}
+
+// Тест встроенного симулятора на потоковой обертке: случайные паузы s_valid и m_ready,
+// прием без пауз при m_ready = 1 и суммы пачек
+TEST(SimulatorTest, VerifiesStreamWrapper) {
+    GeneratorOptions options;
+    options.stream = true;
+    for (int every : {0, 1, 2}) {
+        options.pipeline_every = every;
+        VerificationResult result = verifyGenerated(24, options, 2000);
+        EXPECT_TRUE(result.passed) << "pipeline_every=" << every << ": " << result.message;
+        EXPECT_EQ(result.vectors, 2000);
+    }
+
+    // Наборов меньше задержки: первый результат все равно должен прийти до пауз m_ready
+    for (int n = 1; n <= 64; n += 7) {
+        for (long long vectors : {1LL, 256LL, 300LL}) {
+            options.pipeline_every = 1;
+            VerificationResult few = verifyGenerated(n, options, vectors);
+            EXPECT_TRUE(few.passed) << "n=" << n << ", vectors=" << vectors << ": " << few.message;
+        }
+    }
+
+    GeneratorOptions accumulate = options;
+    accumulate.accumulator_bits = 3;
+    accumulate.pipeline_every = 1;
+    VerificationResult result = verifyGenerated(17, accumulate, 2000);
+    EXPECT_TRUE(result.passed) << result.message;
+
+    // Очереди на один результат меньше не хватает для приема вектора каждый такт
+    options.pipeline_every = 1;
+    stringstream code;
+    KaratsubaGenerator generator(code, options);
+    generator.generate(16);
+    string verilog = code.str();
+    string full = "'d" + to_string(generator.streamLatency(16)) + ";";
+    size_t check = verilog.find(full, verilog.find("wire issue = in_valid && pending != "));
+    ASSERT_NE(check, string::npos);
+    verilog.replace(check, full.size(), "'d" + to_string(generator.streamLatency(16) - 1) + ";");
+    result = verifyMultiplier(verilog, 16, options, 2000, 1);
+    EXPECT_FALSE(result.passed);
+    EXPECT_NE(result.message.find("s_ready"), string::npos);
+}
+
+// Тест встроенного симулятора на параметризованных модулях: элаборация по значениям параметров
+// и условной генерации дает те же произведения, что и специализированные модули
+TEST(SimulatorTest, VerifiesParameterizedModules) {
+    GeneratorOptions options;
+    options.parameterized = true;
+    for (int cutoff : {2, 5}) {
+        options.cutoff = cutoff;
+        for (int n : {1, 2, 3, 4, 7, 33, 128}) {
+            VerificationResult result = verifyGenerated(n, options);
+            EXPECT_TRUE(result.passed) << "N=" << n << ", cutoff=" << cutoff << ": " << result.message;
+        }
+    }
+
+    // Ошибка в параметризованном сумматоре видна во всех разрядностях
+    stringstream code;
+    KaratsubaGenerator(code, options).generate(40);
+    string verilog = code.str();
+    size_t adder = verilog.find("assign sum = a + b;");
+    ASSERT_NE(adder, string::npos);
+    verilog.replace(adder, string("assign sum = a + b;").size(), "assign sum = a | b;");
+    EXPECT_FALSE(verifyMultiplier(verilog, 40, options, 1000, 1).passed);
+
+    VerilogSimulator simulator;
+    string error;
+    string source = "module inner #(parameter W = 2) (input [W-1:0] a, output [W-1:0] b);\nassign b = a;\nendmodule\n"
+                    "module outer(input [3:0] a, output [3:0] b);\ninner #(.V(4)) i (.a(a), .b(b));\nendmodule\n";
+    EXPECT_FALSE(simulator.load(source, "outer", error));
+    EXPECT_NE(error.find("V"), string::npos);
+}
+
+// Тест умножителей на блоках DSP: умножение a * b в модуле блока и строки в LUT
+TEST(SimulatorTest, VerifiesDspTargetMultipliers) {
+    for (DspTarget target : {DspTarget::Dsp48e1, DspTarget::Dsp48e2, DspTarget::Dsp27x27}) {
+        GeneratorOptions options;
+        options.target = target;
+        for (int n : {2, 5, 18, 27, 40, 100}) {
+            VerificationResult result = verifyGenerated(n, options);
+            EXPECT_TRUE(result.passed) << "N=" << n << ", " << dspTargetName(target) << ": " << result.message;
+        }
+    }
+
+    // Ошибка в строке частичных произведений не скрывается блоками
+    GeneratorOptions options;
+    options.target = DspTarget::Dsp48e2;
+    stringstream code;
+    KaratsubaGenerator(code, options).generate(18);
+    string verilog = code.str();
+    size_t row = verilog.find("<< 17)");
+    ASSERT_NE(row, string::npos);
+    verilog.replace(row, string("<< 17)").size(), "<< 16)");
+    EXPECT_FALSE(verifyMultiplier(verilog, 18, options, 1000, 1).passed);
+}
+
+// Тест обнаружения ошибок: неверное произведение и неподдерживаемый текст
+TEST(SimulatorTest, DetectsWrongProduct) {
+    string verilog = generateVerilogModule(16);
+    size_t adder = verilog.find("assign sum = a + b;");
+    ASSERT_NE(adder, string::npos);
+    verilog.replace(adder, string("assign sum = a + b;").size(), "assign sum = a | b;");
+    VerificationResult result = verifyMultiplier(verilog, 16, GeneratorOptions(), 1000, 1);
+    EXPECT_FALSE(result.passed);
+    EXPECT_GT(result.mismatches, 0);
+    EXPECT_NE(result.message.find("ожидалось"), string::npos);
+
+    VerilogSimulator simulator;
+    string error;
+    EXPECT_FALSE(simulator.load("module m(input [3:0] a, output [3:0] b);\nassign b = c;\nendmodule\n", "m", error));
+    EXPECT_NE(error.find("c"), string::npos);
+    EXPECT_FALSE(simulator.load("module m(input a, output b);\nassign b = a;\nendmodule\n", "top", error));
+}
+
 // Вспомогательная функция для проверки существования файла
 bool fileExists(const string& filename) {
     ifstream file(filename);
@@ -60,6 +1147,40 @@ void cleanupGeneratedFiles() {
     remove(test_testbench_filename.c_str());
     remove(test_compiled_filename.c_str());
     remove(test_log_filename.c_str());
+    remove(test_vectors_filename.c_str());
+}
+
+// Вспомогательная функция полного сценария: запись файлов, компиляция iverilog, запуск vvp и проверка вывода
+// ASSERT_* завершают только эту функцию, поэтому тесты вызывают ее через ASSERT_NO_FATAL_FAILURE
+void runFullFlow(const string &moduleCode, const string &testbenchCode) {
+    // Записываем сгенерированный Verilog-модуль в файл
+    ofstream moduleFile(test_multiplier_filename);
+    ASSERT_TRUE(moduleFile.is_open());
+    moduleFile << moduleCode;
+    moduleFile.close();
+
+    // Записываем сгенерированный тестбенч в файл
+    ofstream testbenchFile(test_testbench_filename);
+    ASSERT_TRUE(testbenchFile.is_open());
+    testbenchFile << testbenchCode;
+    testbenchFile.close();
+
+    // Компиляция с помощью iverilog
+    string compileCommand = "iverilog -o "+test_compiled_filename+" " + test_multiplier_filename + " " + test_testbench_filename;
+    int compileResult = system(compileCommand.c_str());
+    ASSERT_EQ(compileResult, 0) << "Ошибка компиляции Verilog файлов";
+
+    // Проверяем, что скомпилированный файл существует
+    ASSERT_TRUE(fileExists(test_compiled_filename)) << "Файл "<<test_compiled_filename<<" не был создан";
+
+    // Запуск скомпилированного файла с помощью vvp
+    string runCommand = "vvp " + test_compiled_filename + " > "+test_log_filename;
+    int runResult = system(runCommand.c_str());
+    ASSERT_EQ(runResult, 0) << "Ошибка выполнения скомпилированного Verilog кода";
+
+    // Проверяем вывод программы
+    string output = readFileToString(test_log_filename);
+    ASSERT_NE(output.find("All tests passed."), string::npos) << "Тесты не прошли успешно";
 }
 
 // Тест сценария: генерация, компиляция и проверка вывода
@@ -140,6 +1261,173 @@ TEST(FunctionalTest, FullFlowForN100) {
     cleanupGeneratedFiles();
 }
 
+// Тест сценария для конвейерного умножителя: результат проверяется с учетом латентности
+TEST(FunctionalTest, FullFlowPipelinedForN10) {
+    GeneratorOptions options;
+    options.pipeline_every = 1;
+    stringstream moduleCode;
+    KaratsubaGenerator(moduleCode, options).generate(10);
+
+    ASSERT_NO_FATAL_FAILURE(runFullFlow(moduleCode.str(), generateTestbench(10, options)));
+    cleanupGeneratedFiles();
+}
+
+// Тест сценария для базового умножителя на дереве Уоллеса
+TEST(FunctionalTest, FullFlowWallaceForN10) {
+    GeneratorOptions options;
+    options.cutoff = 5;
+    options.base = BaseMultiplier::Wallace;
+    stringstream moduleCode;
+    KaratsubaGenerator(moduleCode, options).generate(10);
+
+    ASSERT_NO_FATAL_FAILURE(runFullFlow(moduleCode.str(), generateTestbench(10, options)));
+    cleanupGeneratedFiles();
+}
+
+// Тест сценария для префиксных сумматоров и сумматоров с выбором переноса
+TEST(FunctionalTest, FullFlowStructuralAddersForN10) {
+    GeneratorOptions options;
+    parseAdderSelection("bk:>=12,hc:>=8,carry-select", options.adders);
+    stringstream moduleCode;
+    KaratsubaGenerator(moduleCode, options).generate(10);
+
+    ASSERT_NO_FATAL_FAILURE(runFullFlow(moduleCode.str(), generateTestbench(10, options)));
+    cleanupGeneratedFiles();
+}
+
+// Тест сценария для сборки результата уровней деревом сжатия
+TEST(FunctionalTest, FullFlowCarrySaveForN100) {
+    GeneratorOptions options;
+    options.carry_save = true;
+    stringstream moduleCode;
+    KaratsubaGenerator(moduleCode, options).generate(100);
+
+    ASSERT_NO_FATAL_FAILURE(runFullFlow(moduleCode.str(), generateTestbench(100, options)));
+    cleanupGeneratedFiles();
+}
+
+// Тест сценария для последовательного умножителя: проверяются произведение и число тактов до done
+TEST(FunctionalTest, FullFlowFoldedForN10) {
+    GeneratorOptions options;
+    options.fold_levels = 2;
+    options.resolveFolding(10);
+    stringstream moduleCode;
+    KaratsubaGenerator(moduleCode, options).generate(10);
+
+    ASSERT_NO_FATAL_FAILURE(runFullFlow(moduleCode.str(), generateTestbench(10, options)));
+    cleanupGeneratedFiles();
+}
+
+// Тест сценария для тестбенча с векторами из файла: случайные и граничные операнды для N = 256
+TEST(FunctionalTest, FullFlowVectorFileForN256) {
+    ofstream vectorFile(test_vectors_filename);
+    ASSERT_TRUE(vectorFile.is_open());
+    writeVectorFile(256, 200, 1, vectorFile);
+    vectorFile.close();
+
+    TestbenchVectors vectors;
+    vectors.filename = test_vectors_filename;
+    vectors.count = 200;
+    ASSERT_NO_FATAL_FAILURE(
+        runFullFlow(generateVerilogModule(256), generateTestbench(256, GeneratorOptions(), vectors)));
+    cleanupGeneratedFiles();
+}
+
+// Тест сценария для прямоугольного умножителя 10 x 4: полный перебор операндов в цикле
+TEST(FunctionalTest, FullFlowRectangularFor10x4) {
+    stringstream moduleCode;
+    KaratsubaGenerator(moduleCode).generate(10, 4);
+
+    ASSERT_NO_FATAL_FAILURE(
+        runFullFlow(moduleCode.str(), generateTestbench(10, GeneratorOptions(), TestbenchVectors(), 4)));
+    cleanupGeneratedFiles();
+}
+
+// Тест сценария для квадратора: тестбенч перебирает все 10-битные операнды с шагом
+TEST(FunctionalTest, FullFlowSquareForN10) {
+    GeneratorOptions options;
+    options.square = true;
+    stringstream moduleCode;
+    KaratsubaGenerator(moduleCode, options).generate(10);
+
+    ASSERT_NO_FATAL_FAILURE(runFullFlow(moduleCode.str(), generateTestbench(10, options)));
+    cleanupGeneratedFiles();
+}
+
+// Тест сценария для уровня Toom-3: тестбенч перебирает все 12-битные операнды с шагом
+TEST(FunctionalTest, FullFlowToomForN12) {
+    GeneratorOptions options;
+    options.toom_min_width = 12;
+    stringstream moduleCode;
+    KaratsubaGenerator(moduleCode, options).generate(12);
+
+    ASSERT_NO_FATAL_FAILURE(runFullFlow(moduleCode.str(), generateTestbench(12, options)));
+    cleanupGeneratedFiles();
+}
+
+// Тест сценария для модульного умножителя Монтгомери с модулем на входе: векторы с эталоном на BigUint
+TEST(FunctionalTest, FullFlowMontgomeryForN32) {
+    GeneratorOptions options;
+    options.reduction = ModularReduction::Montgomery;
+    ofstream vectorFile(test_vectors_filename);
+    ASSERT_TRUE(vectorFile.is_open());
+    writeModularVectorFile(options.reduction, 32, options.modulus, 200, 1, vectorFile);
+    vectorFile.close();
+
+    TestbenchVectors vectors;
+    vectors.filename = test_vectors_filename;
+    vectors.count = 200;
+    stringstream moduleCode;
+    KaratsubaGenerator(moduleCode, options).generate(32);
+
+    ASSERT_NO_FATAL_FAILURE(runFullFlow(moduleCode.str(), generateTestbench(32, options, vectors)));
+    cleanupGeneratedFiles();
+}
+
+// Тест сценария для старшей половины произведения: тестбенч допускает ошибку до MAX_ERROR
+TEST(FunctionalTest, FullFlowHighHalfForN12) {
+    GeneratorOptions options;
+    options.half = ProductHalf::High;
+    stringstream moduleCode;
+    KaratsubaGenerator(moduleCode, options).generate(12);
+
+    ASSERT_NO_FATAL_FAILURE(runFullFlow(moduleCode.str(), generateTestbench(12, options)));
+    cleanupGeneratedFiles();
+}
+
+// Тест сценария для потоковой обертки с аккумулятором: случайные паузы на входе и выходе
+TEST(FunctionalTest, FullFlowStreamForN16) {
+    GeneratorOptions options;
+    options.stream = true;
+    options.accumulator_bits = 4;
+    options.pipeline_every = 1;
+    ofstream vectorFile(test_vectors_filename);
+    ASSERT_TRUE(vectorFile.is_open());
+    writeVectorFile(16, 500, 1, vectorFile);
+    vectorFile.close();
+
+    TestbenchVectors vectors;
+    vectors.filename = test_vectors_filename;
+    vectors.count = 500;
+    stringstream moduleCode;
+    KaratsubaGenerator(moduleCode, options).generate(16);
+
+    ASSERT_NO_FATAL_FAILURE(runFullFlow(moduleCode.str(), generateTestbench(16, options, vectors)));
+    cleanupGeneratedFiles();
+}
+
+// Тест сценария для параметризованного режима: iverilog элаборирует рекурсию karatsuba_mult #(.N())
+TEST(FunctionalTest, FullFlowParameterizedForN100) {
+    GeneratorOptions options;
+    options.parameterized = true;
+    options.cutoff = 6;
+    stringstream moduleCode;
+    KaratsubaGenerator(moduleCode, options).generate(100);
+
+    ASSERT_NO_FATAL_FAILURE(runFullFlow(moduleCode.str(), generateTestbench(100, options)));
+    cleanupGeneratedFiles();
+}
+
 // Главная функция для запуска всех тестов
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);